@@ -757,6 +757,7 @@ int printf_(const char *format, ...) {
   char buffer[1];
   const int ret = _vsnprintf(_out_char, buffer, (size_t)-1, format, va);
   va_end(va);
+  _putchar_flush();
   return ret;
 }
 
@@ -46,6 +46,12 @@ extern "C" {
  */
 void _putchar(char character);
 
+/**
+ * Flush the characters that _putchar() might have buffered, called by printf()
+ * before returning. Implemented with _putchar()
+ */
+void _putchar_flush(void);
+
 /**
  * Tiny printf implementation
  * You have to implement _putchar if you use printf()
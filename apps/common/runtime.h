@@ -30,6 +30,8 @@ inline int64_t get_cycle_count() {
 // will start counting, but simply that it will be able to start.
 #define HW_CNT_READY hw_cnt_en_reg = 1;
 #define HW_CNT_NOT_READY hw_cnt_en_reg = 0;
+// Ask the Verilator testbench to save a checkpoint of the simulation
+#define SIM_CHECKPOINT event_trigger = 2;
 // Start and stop the counter
 inline void start_timer() { timer = -get_cycle_count(); }
 inline void stop_timer() { timer += get_cycle_count(); }
@@ -39,6 +41,7 @@ inline int64_t get_timer() { return timer; }
 #else
 #define HW_CNT_READY ;
 #define HW_CNT_NOT_READY ;
+#define SIM_CHECKPOINT ;
 // Start and stop the counter
 inline void start_timer() {
   while (0)
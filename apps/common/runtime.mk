@@ -93,6 +93,9 @@ endif
 ifeq ($(vcd_dump),1)
 ENV_DEFINES += -DVCD_DUMP=1
 endif
+ifeq ($(scalar_uart),1)
+ENV_DEFINES += -DSCALAR_UART=1
+endif
 MAKE_DEFINES = -DNR_LANES=$(nr_lanes) -DVLEN=$(vlen)
 DEFINES += $(ENV_DEFINES) $(MAKE_DEFINES)
 
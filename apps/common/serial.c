@@ -1,8 +1,81 @@
+#include <stddef.h>
 #include <stdint.h>
 
+#include "printf.h"
+#include "runtime.h"
+
 extern char fake_uart;
+// Console of the test-bench, see tb/dpi/console.cc
+extern char host_console;
+
+#ifdef SCALAR_UART
 
+// Send the characters one by one to the UART
 void _putchar(char character) {
   // send char to console
   fake_uart = character;
-}
\ No newline at end of file
+}
+
+void _putchar_flush(void) {}
+
+#else
+
+// Characters buffered until the end of printf()
+#define CONSOLE_BUF_SIZE 256
+
+static char console_buf[CONSOLE_BUF_SIZE];
+static size_t console_len = 0;
+
+void _putchar(char character) {
+  console_buf[console_len++] = character;
+  if (console_len == CONSOLE_BUF_SIZE)
+    _putchar_flush();
+}
+
+// Write the buffered characters to the console with vector stores, as long as
+// VLMAX allows with LMUL = 8. The hw-counter is disabled meanwhile, so that
+// the output is not charged to the benchmark: once Ara is idle, the counter
+// does not start again before it is enabled. vl, vtype and the registers
+// v8-v15 used for the copy are preserved, so printf() can be called while a
+// kernel keeps values in the vector registers.
+void _putchar_flush(void) {
+  // v8-v15, saved with whole-register stores
+  static uint8_t vregs[VLEN] __attribute__((aligned(8)));
+
+  if (!console_len)
+    return;
+
+  uint64_t hw_cnt_en = hw_cnt_en_reg;
+  uint64_t vl, vtype;
+  asm volatile("fence" ::: "memory");
+  hw_cnt_en_reg = 0;
+  asm volatile("fence" ::: "memory");
+  asm volatile("csrr %[vl], vl; csrr %[vtype], vtype"
+               : [vl] "=r"(vl), [vtype] "=r"(vtype));
+  asm volatile("vs8r.v v8, (%[vregs])" ::[vregs] "r"(vregs) : "memory");
+
+  for (const char *src = console_buf; console_len;) {
+    size_t avl;
+    asm volatile("vsetvli %[avl], %[len], e8, m8, ta, ma;"
+                 "vle8.v v8, (%[src]);"
+                 "vse8.v v8, (%[dst])"
+                 : [avl] "=&r"(avl)
+                 : [len] "r"(console_len), [src] "r"(src),
+                   [dst] "r"(&host_console)
+                 : "memory", "v8", "v9", "v10", "v11", "v12", "v13", "v14",
+                   "v15");
+    src += avl;
+    console_len -= avl;
+  }
+
+  asm volatile("vl8re8.v v8, (%[vregs])"
+               ::[vregs] "r"(vregs)
+               : "memory", "v8", "v9", "v10", "v11", "v12", "v13", "v14",
+                 "v15");
+  asm volatile("vsetvl zero, %[vl], %[vtype]" ::[vl] "r"(vl),
+               [vtype] "r"(vtype));
+  asm volatile("fence" ::: "memory");
+  hw_cnt_en_reg = hw_cnt_en;
+}
+
+#endif
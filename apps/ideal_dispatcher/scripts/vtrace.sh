@@ -1,27 +0,0 @@
-#!/usr/bin/env bash
-# Copyright 2020 ETH Zurich and University of Bologna.
-#
-# SPDX-License-Identifier: Apache-2.0
-#
-# Licensed under the Apache License, Version 2.0 (the "License");
-# you may not use this file except in compliance with the License.
-# You may obtain a copy of the License at
-#
-#    http://www.apache.org/licenses/LICENSE-2.0
-#
-# Unless required by applicable law or agreed to in writing, software
-# distributed under the License is distributed on an "AS IS" BASIS,
-# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
-# See the License for the specific language governing permissions and
-# limitations under the License.
-#
-# Author: Matteo Perotti <mperotti@iis.ee.ethz.ch>
-
-# This script should be executed from the output directory
-temp=$1
-vtrace=$2
-
-# Filter trash and scalar insn
-./scripts/filter_vtrace.sh $temp $temp.filtered
-# Create the content for the perfect dispatcher
-python3 ./scripts/dump_vtrace.py $temp.filtered $vtrace
@@ -0,0 +1,267 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// Extract the vector trace of the ideal dispatcher from the log of the
+// modified Spike (patches/0003-riscv-isa-sim-patch).
+//
+// Spike logs every instruction, and dumps the scalar register files after
+// every vector instruction. For every vector instruction, the extractor
+// writes the instruction with the values of its scalar operands:
+// - rs1: the value of the scalar register among the operands, the
+//   floating-point one if any (the previous value if there is none),
+// - rs2: the stride of the strided memory operations, zero otherwise.
+// The register values are the ones after the instruction.
+//
+// Usage: vtrace_extract [-t] [LOG] OUT
+//        vtrace_extract -c
+// LOG defaults to the standard input (also "-"). OUT is binary, as read by
+// hardware/tb/dpi/vtrace_reader.cc:
+//   header: "ARAVTR01"
+//   record: u32 instruction, u64 rs1, u64 rs2 (little endian)
+// With -t, OUT is text instead, with one 160-bit hexadecimal number per
+// instruction, as read by $readmemh.
+// With -c, the extractor only checks its parser of the register dumps.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const char kMagic[8] = {'A', 'R', 'A', 'V', 'T', 'R', '0', '1'};
+
+// Register names printed by Spike, in the order of the register files
+const char *const kXprNames[32] = {
+    "zero", "ra", "sp", "gp", "tp",  "t0",  "t1", "t2", "s0", "s1", "a0",
+    "a1",   "a2", "a3", "a4", "a5",  "a6",  "a7", "s2", "s3", "s4", "s5",
+    "s6",   "s7", "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6"};
+const char *const kFprNames[32] = {
+    "ft0", "ft1", "ft2",  "ft3",  "ft4", "ft5", "ft6",  "ft7",
+    "fs0", "fs1", "fa0",  "fa1",  "fa2", "fa3", "fa4",  "fa5",
+    "fa6", "fa7", "fs2",  "fs3",  "fs4", "fs5", "fs6",  "fs7",
+    "fs8", "fs9", "fs10", "fs11", "ft8", "ft9", "ft10", "ft11"};
+
+// Lines of Spike's dump of the XRF and of the FRF, and digits per register
+const int kRegLines = 8;
+const int kRegDigits = 16;
+
+struct Insn {
+  uint32_t bits;
+  std::string name;
+  std::vector<std::string> operands;
+};
+
+// Parse "core   0: 0x<pc> (0x<insn>) <name> <operands>"
+bool ParseInsn(const char *line, Insn &insn) {
+  const char *open = strstr(line, ") ");
+  const char *bits = strstr(line, "(0x");
+  if (!strstr(line, "core") || !bits || !open || open < bits) {
+    return false;
+  }
+  insn.bits = strtoul(bits + 3, nullptr, 16);
+
+  std::string rest(open + 2);
+  insn.name.clear();
+  insn.operands.clear();
+  std::string token;
+  for (size_t i = 0; i <= rest.size(); ++i) {
+    char c = i < rest.size() ? rest[i] : ' ';
+    if (c == ',' || c == '(' || c == ')') {
+      continue;
+    }
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+      if (token.empty()) {
+        continue;
+      }
+      if (insn.name.empty()) {
+        insn.name = token;
+      } else {
+        insn.operands.push_back(token);
+      }
+      token.clear();
+    } else {
+      token += c;
+    }
+  }
+  return !insn.name.empty();
+}
+
+// Update the four registers of |rf| from |row| of Spike's dump, a line of
+// "<name>: 0x<value>" fields of 24 characters, with the name right-aligned on
+// four characters and the value on 16 hexadecimal digits. The fields are not
+// separated: "fs10" or "ft10" follows the previous value directly, so exactly
+// 16 digits are parsed per field. The names are not needed.
+void ParseRegLine(const char *line, unsigned int row, uint64_t rf[32]) {
+  const char *p = line;
+  for (unsigned int r = 4 * row; r < 4 * (row + 1) && r < 32; ++r) {
+    p = strstr(p, ": 0x");
+    if (!p) {
+      return;
+    }
+    char value[kRegDigits + 1] = {};
+    strncpy(value, p + 4, kRegDigits);
+    rf[r] = strtoull(value, nullptr, 16);
+    p += 4 + strlen(value);
+  }
+}
+
+// Check ParseRegLine against the last two lines of a dump of the FRF by Spike
+bool CheckRegLines() {
+  const char *const lines[2] = {
+      " fs8: 0x0000000000000018 fs9: 0x0000000000000019fs10: "
+      "0x000000000000001afs11: 0x000000000000001b\n",
+      " ft8: 0x000000000000001c ft9: 0x000000000000001dft10: "
+      "0xffffffffffffffffft11: 0x000000000000001f\n"};
+  uint64_t frf[32] = {};
+  ParseRegLine(lines[0], 6, frf);
+  ParseRegLine(lines[1], 7, frf);
+  for (int r = 24; r < 32; ++r) {
+    uint64_t expected = r == 30 ? ~0ull : r;
+    if (frf[r] != expected) {
+      fprintf(stderr, "ERROR: %s is 0x%016llx instead of 0x%016llx\n",
+              kFprNames[r], (unsigned long long)frf[r],
+              (unsigned long long)expected);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Read the next line of the log that belongs to the vector trace, i.e. drop
+// Spike's messages (with a semicolon) and the scalar instructions
+bool NextLine(FILE *in, std::vector<char> &line) {
+  while (fgets(line.data(), line.size(), in)) {
+    const char *open = strstr(line.data(), ") ");
+    if (!strstr(line.data(), "0x") || strchr(line.data(), ';')) {
+      continue;
+    }
+    if (strstr(line.data(), "core") && open && open[2] != 'v') {
+      continue;
+    }
+    return true;
+  }
+  return false;
+}
+
+int Index(const char *const names[32], const std::string &reg) {
+  for (int r = 0; r < 32; ++r) {
+    if (reg == names[r]) {
+      return r;
+    }
+  }
+  return -1;
+}
+
+void Usage(const char *argv0) {
+  fprintf(stderr, "Usage: %s [-t] [LOG] OUT\n       %s -c\n", argv0, argv0);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  bool text = false;
+  int c;
+  while ((c = getopt(argc, argv, "cth")) != -1) {
+    switch (c) {
+      case 'c':
+        return CheckRegLines() ? 0 : 1;
+      case 't':
+        text = true;
+        break;
+      default:
+        Usage(argv[0]);
+        return c == 'h' ? 0 : 1;
+    }
+  }
+  if (argc - optind < 1 || argc - optind > 2) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  FILE *in = stdin;
+  if (argc - optind == 2 && strcmp(argv[optind], "-") != 0) {
+    in = fopen(argv[optind], "r");
+    if (!in) {
+      fprintf(stderr, "ERROR: Could not open %s\n", argv[optind]);
+      return 1;
+    }
+  }
+  const char *out_path = argv[argc - 1];
+  FILE *out = fopen(out_path, text ? "w" : "wb");
+  if (!out) {
+    fprintf(stderr, "ERROR: Could not open %s\n", out_path);
+    return 1;
+  }
+  if (!text) {
+    fwrite(kMagic, 1, sizeof(kMagic), out);
+  }
+
+  uint64_t xrf[32] = {};
+  uint64_t frf[32] = {};
+  uint64_t rs1 = 0;
+  unsigned long count = 0;
+  std::vector<char> line(4096);
+  Insn insn;
+
+  while (NextLine(in, line)) {
+    if (!ParseInsn(line.data(), insn)) {
+      continue;
+    }
+
+    // The register files after the instruction
+    for (int l = 0; l < 2 * kRegLines && NextLine(in, line); ++l) {
+      ParseRegLine(line.data(), l % kRegLines, l < kRegLines ? xrf : frf);
+    }
+
+    // The destination of vsetvli is not an operand for Ara, the stride of the
+    // strided memory operations goes to rs2
+    std::vector<std::string> &ops = insn.operands;
+    uint64_t rs2 = 0;
+    if (insn.name == "vsetvli" && !ops.empty() && ops[0] != "zero") {
+      ops.erase(ops.begin());
+    } else if ((insn.name.find("vlse") != std::string::npos ||
+                insn.name.find("vsse") != std::string::npos) &&
+               !ops.empty() && Index(kXprNames, ops.back()) >= 0) {
+      rs2 = xrf[Index(kXprNames, ops.back())];
+      ops.pop_back();
+    }
+    if (insn.name == "vsetvl") {
+      fprintf(stderr, "ERROR: vsetvl is not supported\n");
+    }
+
+    // The last scalar operand, the floating-point ones last
+    for (const char *const *names : {kXprNames, kFprNames}) {
+      const uint64_t *rf = names == kXprNames ? xrf : frf;
+      for (int r = 0; r < 32; ++r) {
+        for (const std::string &op : ops) {
+          if (op == names[r]) {
+            rs1 = rf[r];
+          }
+        }
+      }
+    }
+
+    if (text) {
+      fprintf(out, "%08x%016llx%016llx\n", insn.bits, (unsigned long long)rs1,
+              (unsigned long long)rs2);
+    } else {
+      fwrite(&insn.bits, sizeof(insn.bits), 1, out);
+      fwrite(&rs1, sizeof(rs1), 1, out);
+      fwrite(&rs2, sizeof(rs2), 1, out);
+    }
+    ++count;
+  }
+
+  fclose(out);
+  if (in != stdin) {
+    fclose(in);
+  }
+  fprintf(stderr, "%lu vector instructions written to %s\n", count, out_path);
+  return 0;
+}
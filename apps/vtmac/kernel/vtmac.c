@@ -1,86 +1,90 @@
 // vtmac.c
 #include "vtmac.h"
-#include "runtime.h"
-#include "util.h"
-#include <math.h>
 #include <stdint.h>
-#include <string.h>
-#ifndef SPIKE
-#include "printf.h"
-#else
-#include <stdio.h>
-#endif
 
-// Initialize test data
-void init_vtmac_data(double *a, double *b, unsigned long int n) {
-  for (unsigned long int i = 0; i < n; i++) {
-    // Initialize with some pattern
-    a[i] = (double)i * 0.5;
-    b[i] = (double)i * 0.25;
+// VTMAC.vx and VTMACC.vx (OPIVX, funct6 111001 and 110010), unmasked
+#define VTMAC_V8_V4(rs1)                                                       \
+  asm volatile(".insn r 0x57, 0x4, 0x73, v8, %0, v4" ::"r"(rs1))
+#define VTMACC_V8_V4(rs1)                                                      \
+  asm volatile(".insn r 0x57, 0x4, 0x65, v8, %0, v4" ::"r"(rs1))
+
+void vtmac_pack(uint32_t *wpack, const uint8_t *w, uint64_t rows, uint64_t cols,
+                uint64_t wbits) {
+  for (uint64_t g = 0; g < cols / VTMAC_GROUP; ++g) {
+    for (uint64_t i = 0; i < rows; ++i) {
+      uint32_t planes = 0;
+      for (uint64_t j = 0; j < VTMAC_GROUP; ++j) {
+        uint32_t weight = w[i * cols + VTMAC_GROUP * g + j];
+        for (uint64_t p = 0; p < wbits; ++p)
+          planes |= ((weight >> p) & 1) << (VTMAC_GROUP * p + j);
+      }
+      wpack[g * rows + i] = planes;
+    }
   }
 }
 
-// TMAC kernel using custom instruction
-void vtmac_kernel(double *dest, double *a, double *b, unsigned long int n) {
-  unsigned long int vl;
-  asm volatile("vsetvli %0, %1, e64, m4, ta, ma" : "=r"(vl) : "r"(n));
-  
-  for (unsigned long int i = 0; i < n; i += vl) {
-    // Set vector length for this iteration
-    asm volatile("vsetvli %0, %1, e64, m4, ta, ma" : "=r"(vl) : "r"(n - i));
-    
-    // Load vectors
-    asm volatile("vle64.v v0, (%0)" ::"r"(a + i));
-    asm volatile("vle64.v v4, (%0)" ::"r"(b + i));
-    
-    // Custom TMAC instruction for matrix multiplication
-    asm volatile(".insn r 0x57, 0x0, 0x39, v8, v0, v4");
-    
-    // Store results
-    asm volatile("vse64.v v8, (%0)" ::"r"(dest + i));
-  }
+void vmacc_unpack(int32_t *wcol, const uint8_t *w, uint64_t rows, uint64_t cols,
+                  uint64_t wbits) {
+  for (uint64_t k = 0; k < cols; ++k)
+    for (uint64_t i = 0; i < rows; ++i)
+      wcol[k * rows + i] = w[i * cols + k] & ((1 << wbits) - 1);
 }
 
-// Standard matrix multiplication using regular RISC-V vector instructions
-void std_matrix_mul(double *dest, double *a, double *b, unsigned long int n) {
-  unsigned long int vl;
-  asm volatile("vsetvli %0, %1, e64, m4, ta, ma" : "=r"(vl) : "r"(n));
-  
-  for (unsigned long int i = 0; i < n; i += vl) {
-    // Set vector length for this iteration
-    asm volatile("vsetvli %0, %1, e64, m4, ta, ma" : "=r"(vl) : "r"(n - i));
-    
-    // Load vectors
-    asm volatile("vle64.v v0, (%0)" ::"r"(a + i));
-    asm volatile("vle64.v v4, (%0)" ::"r"(b + i));
-    
-    // Standard vector multiply
-    asm volatile("vfmul.vv v8, v0, v4");
-    
-    // Store results
-    asm volatile("vse64.v v8, (%0)" ::"r"(dest + i));
+void vtmac_gemv(int32_t *y, const uint32_t *wpack, const int8_t *x,
+                uint64_t rows, uint64_t cols, uint64_t log2_wbits) {
+  uint64_t groups = cols / VTMAC_GROUP;
+  uint64_t vl;
+
+  for (uint64_t i = 0; i < rows; i += vl) {
+    asm volatile("vsetvli %0, %1, e32, m4, ta, ma" : "=r"(vl) : "r"(rows - i));
+
+    for (uint64_t g = 0; g < groups; ++g) {
+      // One group of activations, and the width of the weights
+      uint64_t act = *(const uint32_t *)(x + VTMAC_GROUP * g) |
+                     (log2_wbits << VTMAC_WBITS_SHIFT);
+
+      asm volatile("vle32.v v4, (%0)" ::"r"(wpack + g * rows + i));
+      if (g == 0)
+        VTMAC_V8_V4(act);
+      else
+        VTMACC_V8_V4(act);
+    }
+
+    asm volatile("vse32.v v8, (%0)" ::"r"(y + i));
   }
 }
 
-// 修正後的函數簽名，與 vtmac.h 中的聲明一致
-int vtmac_verify(double *result, double *a, double *b, unsigned long int n) {
-  int errors = 0;
-  
-  for (unsigned long int i = 0; i < n; i++) {
-    // 標準矩陣乘法計算預期結果
-    double std_result = a[i] * b[i];
-    
-    // 與預期結果比較
-    if (fabs(result[i] - std_result) > 1e-2) {
-      printf("Error at index %ld: got %f, expected %f\n",
-             i, result[i], std_result);
-      errors++;
-      if (errors > 10) {
-        printf("Too many errors, stopping verification.\n");
-        return 1;
-      }
+void vmacc_gemv(int32_t *y, const int32_t *wcol, const int8_t *x, uint64_t rows,
+                uint64_t cols) {
+  uint64_t vl;
+
+  for (uint64_t i = 0; i < rows; i += vl) {
+    asm volatile("vsetvli %0, %1, e32, m4, ta, ma" : "=r"(vl) : "r"(rows - i));
+    asm volatile("vmv.v.i v8, 0");
+
+    for (uint64_t k = 0; k < cols; ++k) {
+      int64_t act = x[k];
+      asm volatile("vle32.v v4, (%0)" ::"r"(wcol + k * rows + i));
+      asm volatile("vmacc.vx v8, %0, v4" ::"r"(act));
     }
+
+    asm volatile("vse32.v v8, (%0)" ::"r"(y + i));
   }
-  
-  return (errors > 0) ? 1 : 0;
-}
\ No newline at end of file
+}
+
+void gemv_scalar(int32_t *y, const uint8_t *w, const int8_t *x, uint64_t rows,
+                 uint64_t cols, uint64_t wbits) {
+  for (uint64_t i = 0; i < rows; ++i) {
+    int32_t acc = 0;
+    for (uint64_t k = 0; k < cols; ++k)
+      acc += x[k] * (int32_t)(w[i * cols + k] & ((1 << wbits) - 1));
+    y[i] = acc;
+  }
+}
+
+uint64_t gemv_verify(const int32_t *y, const int32_t *gold, uint64_t rows) {
+  for (uint64_t i = 0; i < rows; ++i)
+    if (y[i] != gold[i])
+      return i + 1;
+  return 0;
+}
@@ -4,29 +4,34 @@
 
 #include <stdint.h>
 
-// Initialize test data
-void init_vtmac_data(double *a, double *b, unsigned long int n);
+// Activations per VTMAC(C) instruction
+#define VTMAC_GROUP 4
+// The log2 of the width of the weights is in bits [33:32] of rs1
+#define VTMAC_WBITS_SHIFT 32
 
-// TMAC kernel implementation
-void vtmac_kernel(double *dest, double *a, double *b, unsigned long int n);
+// Pack the bit planes of the weights with |wbits| bits, for every row and group
+// of activations: wpack[g * rows + i] holds the weights w[i][4g..4g+3], plane p in
+// bits [4p+3:4p]
+void vtmac_pack(uint32_t *wpack, const uint8_t *w, uint64_t rows, uint64_t cols,
+                uint64_t wbits);
 
-// Standard matrix multiplication for comparison
-void std_matrix_mul(double *dest, double *a, double *b, unsigned long int n);
+// Keep the |wbits| bits of the weights, in column-major order for vmacc_gemv
+void vmacc_unpack(int32_t *wcol, const uint8_t *w, uint64_t rows, uint64_t cols,
+                  uint64_t wbits);
 
-// Function to verify the results
-int vtmac_verify(double *result, double *a, double *b, unsigned long int n);
+// y = Wx with the T-MAC instructions, log2_wbits in [0, 2]
+void vtmac_gemv(int32_t *y, const uint32_t *wpack, const int8_t *x,
+                uint64_t rows, uint64_t cols, uint64_t log2_wbits);
 
-// Instruction/cycle counting functions
-static inline uint64_t read_instret(void) {
-  uint64_t instret;
-  asm volatile("csrr %0, minstret" : "=r"(instret));
-  return instret;
-}
+// y = Wx with vmacc.vx, one column of W per instruction
+void vmacc_gemv(int32_t *y, const int32_t *wcol, const int8_t *x, uint64_t rows,
+                uint64_t cols);
 
-static inline uint64_t read_cycles(void) {
-  uint64_t cycles;
-  asm volatile("csrr %0, mcycle" : "=r"(cycles));
-  return cycles;
-}
+// Scalar reference, with the |wbits| bits of the weights
+void gemv_scalar(int32_t *y, const uint8_t *w, const int8_t *x, uint64_t rows,
+                 uint64_t cols, uint64_t wbits);
 
-#endif // VTMAC_H
\ No newline at end of file
+// Return the index of the first mismatch plus one, or zero
+uint64_t gemv_verify(const int32_t *y, const int32_t *gold, uint64_t rows);
+
+#endif // VTMAC_H
@@ -1,4 +1,6 @@
 // main.c
+// Low-bit GEMV with the T-MAC unit, against vmacc.vx on unpacked weights.
+// VTMAC(C) is not a standard instruction: run this app on the RTL model only.
 #include <stdint.h>
 #include <string.h>
 #include "kernel/vtmac.h"
@@ -12,91 +14,67 @@
 #include "printf.h"
 #endif
 
-#define TEST_SIZE 1024
-
-// Reference to data arrays initialized in data.S
-extern uint64_t N;
-extern double a[] __attribute__((aligned(4 * NR_LANES), section(".l2")));
-extern double b[] __attribute__((aligned(4 * NR_LANES), section(".l2")));
-extern double result[] __attribute__((aligned(4 * NR_LANES), section(".l2")));
-extern double std_result[] __attribute__((aligned(4 * NR_LANES), section(".l2")));
-
-#define VERIFY 1
+// y = Wx with W=[RxC], x=[C]
+extern uint64_t R;
+extern uint64_t C;
+extern int8_t x[] __attribute__((aligned(4 * NR_LANES), section(".l2")));
+extern uint8_t w[] __attribute__((aligned(4 * NR_LANES), section(".l2")));
+extern uint32_t wpack[] __attribute__((aligned(4 * NR_LANES), section(".l2")));
+extern int32_t wcol[] __attribute__((aligned(4 * NR_LANES), section(".l2")));
+extern int32_t y[] __attribute__((aligned(4 * NR_LANES), section(".l2")));
+extern int32_t y_gold[] __attribute__((aligned(4 * NR_LANES), section(".l2")));
 
 int main() {
   printf("\n");
-  printf("=========================================\n");
-  printf("= VTMAC vs Standard Matrix Multiplication =\n");
-  printf("=========================================\n");
+  printf("=============\n");
+  printf("=   VTMAC   =\n");
+  printf("=============\n");
   printf("\n");
-  
-  for (int s = 4; s <= TEST_SIZE; s *= 2) {
+
+  for (uint64_t log2_wbits = 0; log2_wbits <= 2; ++log2_wbits) {
+    uint64_t wbits = 1 << log2_wbits;
+
     printf("\n");
-    printf("-------------------------------------------------------\n");
-    printf("Testing with vector size %d...\n", s);
-    printf("-------------------------------------------------------\n");
+    printf("------------------------------------------------------------\n");
+    printf("GEMV (%lu x %lu) x (%lu) with %lu-bit weights...\n", R, C, C, wbits);
+    printf("------------------------------------------------------------\n");
     printf("\n");
-    
-    // Initialize data
-    printf("Initializing test data...\n");
-    init_vtmac_data(a, b, s);
-    
-    // Run standard matrix multiplication
-    printf("Running standard matrix multiplication...\n");
-    uint64_t std_instr_start = read_instret();
-    uint64_t std_cycle_start = read_cycles();
-    
-    std_matrix_mul(std_result, a, b, s);
-    
-    uint64_t std_cycle_end = read_cycles();
-    uint64_t std_instr_end = read_instret();
-    
-    uint64_t std_instr_count = std_instr_end - std_instr_start;
-    uint64_t std_cycle_count = std_cycle_end - std_cycle_start;
-    
-    // Run TMAC kernel
-    printf("Running TMAC kernel...\n");
-    uint64_t tmac_instr_start = read_instret();
-    uint64_t tmac_cycle_start = read_cycles();
-    
-    vtmac_kernel(result, a, b, s);
-    
-    uint64_t tmac_cycle_end = read_cycles();
-    uint64_t tmac_instr_end = read_instret();
-    
-    uint64_t tmac_instr_count = tmac_instr_end - tmac_instr_start;
-    uint64_t tmac_cycle_count = tmac_cycle_end - tmac_cycle_start;
-    
-    // Print performance metrics
-    printf("\nPerformance Comparison for size %d:\n", s);
-    printf("Standard Matrix Multiplication:\n");
-    printf("  Instructions: %llu\n", (unsigned long long)std_instr_count);
-    printf("  Cycles: %llu\n", (unsigned long long)std_cycle_count);
-    printf("  Cycles per element: %.2f\n", (double)std_cycle_count / s);
-    
-    printf("TMAC Matrix Multiplication:\n");
-    printf("  Instructions: %llu\n", (unsigned long long)tmac_instr_count);
-    printf("  Cycles: %llu\n", (unsigned long long)tmac_cycle_count);
-    printf("  Cycles per element: %.2f\n", (double)tmac_cycle_count / s);
-    
-    printf("Improvement Ratio:\n");
-    printf("  Instruction count: %.2fx\n", (double)std_instr_count / tmac_instr_count);
-    printf("  Cycle count: %.2fx\n", (double)std_cycle_count / tmac_cycle_count);
-    
-    // Verify the result
-    // 在 main.c 中
-    // 驗證結果
-    if (VERIFY) {
-      printf("Verifying results...\n");
-      if (vtmac_verify(result, a, b, s)) {
-        printf("Verification failed!\n");
-        return 1;
-      } else {
-        printf("Verification passed.\n");
-      }
+
+    vtmac_pack(wpack, w, R, C, wbits);
+    vmacc_unpack(wcol, w, R, C, wbits);
+    gemv_scalar(y_gold, w, x, R, C, wbits);
+
+    // vmacc.vx baseline
+    memset(y, 0, R * sizeof(int32_t));
+    start_timer();
+    vmacc_gemv(y, wcol, x, R, C);
+    stop_timer();
+    int64_t vmacc_runtime = get_timer();
+    printf("The vmacc execution took %ld cycles.\n", vmacc_runtime);
+    uint64_t error = gemv_verify(y, y_gold, R);
+    if (error) {
+      printf("vmacc: error at row %lu, %d != %d.\n", error - 1, y[error - 1],
+             y_gold[error - 1]);
+      return error;
+    }
+
+    // T-MAC
+    memset(y, 0, R * sizeof(int32_t));
+    start_timer();
+    vtmac_gemv(y, wpack, x, R, C, log2_wbits);
+    stop_timer();
+    int64_t vtmac_runtime = get_timer();
+    printf("The VTMAC execution took %ld cycles.\n", vtmac_runtime);
+    error = gemv_verify(y, y_gold, R);
+    if (error) {
+      printf("VTMAC: error at row %lu, %d != %d.\n", error - 1, y[error - 1],
+             y_gold[error - 1]);
+      return error;
     }
+
+    printf("Passed. The VTMAC speedup is %.2fx.\n",
+           (float)vmacc_runtime / vtmac_runtime);
   }
-  
-  printf("Done!\n");
+
   return 0;
-}
\ No newline at end of file
+}
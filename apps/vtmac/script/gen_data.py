@@ -1,44 +1,59 @@
 #!/usr/bin/env python3
-# Copyright 2025 [Your Organization]
+# Copyright 2025
 #
 # SPDX-License-Identifier: Apache-2.0
-import random
+
+# Low-bit GEMV y = Wx, with W=[RxC] and x=[C]
+# arg1, arg2: R, C (C multiple of the T-MAC group size, i.e., 4)
+# x holds signed 8-bit activations, W unsigned 4-bit weights, one per byte. The
+# kernels pack or unpack the weights for the tested weight widths.
+
 import numpy as np
 import sys
 
 def emit(name, array, alignment='8'):
-    print(".global %s" % name)
-    print(".balign " + alignment)
-    print("%s:" % name)
-    bs = array.tobytes()
-    for i in range(0, len(bs), 4):
-        s = ""
-        for n in range(min(4, len(bs) - i)):
-            s += "%02x" % bs[i+min(3, len(bs)-i-1)-n]
-        print(" .word 0x%s" % s)
+  print(".global %s" % name)
+  print(".balign " + alignment)
+  print("%s:" % name)
+  bs = array.tobytes()
+  for i in range(0, len(bs), 4):
+    s = ""
+    for n in range(4):
+      s += "%02x" % bs[i+3-n]
+    print("    .word 0x%s" % s)
 
 ############
 ## SCRIPT ##
 ############
-# Default value if no argument is provided
-n = 1024
-if len(sys.argv) == 2:
-    n = int(sys.argv[1])
 
-# Create test arrays
-a = np.random.rand(n).astype(np.float64)
-b = np.random.rand(n).astype(np.float64)
-result = np.zeros(n).astype(np.float64)  # For TMAC result
-std_result = np.zeros(n).astype(np.float64)  # For standard result
+if len(sys.argv) == 3:
+  R = int(sys.argv[1])
+  C = int(sys.argv[2])
+else:
+  print("Error. Give me two arguments: R, C.")
+  print("y = Wx with W=[RxC], x=[C]")
+  sys.exit()
+
+if C % 4:
+  print("Error. C must be a multiple of 4.")
+  sys.exit()
+
+x = np.random.randint(-128, 128, size=C).astype(np.int8)
+w = np.random.randint(0, 16, size=(R, C)).astype(np.uint8)
 
 # Create the file
 print(".section .data,\"aw\",@progbits")
-print(".global N")
-print(".section .sdata,\"aw\",@progbits")
-print("N: .dword %d" % n)
+print(".global R")
+print(".global C")
+print("R: .dword %d" % R)
+print("C: .dword %d" % C)
 
 print(".section .l2,\"aw\",@progbits")
-emit("a", a, 'NR_LANES*4')
-emit("b", b, 'NR_LANES*4')
-emit("result", result, 'NR_LANES*4')
-emit("std_result", std_result, 'NR_LANES*4')
\ No newline at end of file
+emit("x", x, 'NR_LANES*4')
+emit("w", w, 'NR_LANES*4')
+# Packed bit planes, one word per row and group of 4 activations
+emit("wpack", np.zeros(R * C // 4, dtype=np.uint32), 'NR_LANES*4')
+# Unpacked weights of the vmacc kernel, column-major
+emit("wcol", np.zeros(R * C, dtype=np.int32), 'NR_LANES*4')
+emit("y", np.zeros(R, dtype=np.int32), 'NR_LANES*4')
+emit("y_gold", np.zeros(R, dtype=np.int32), 'NR_LANES*4')
@@ -23,3 +23,6 @@ nr_lanes ?= 16
 # Length of each vector register (in bits)
 # Constraints: VLEN > 128
 vlen ?= 16384
+
+# Number of threads of the verilated model (1: single-threaded)
+veril_threads ?= 8
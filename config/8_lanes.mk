@@ -23,3 +23,6 @@ nr_lanes ?= 8
 # Length of each vector register (in bits)
 # Constraints: VLEN > 128
 vlen ?= 8192
+
+# Number of threads of the verilated model (1: single-threaded)
+veril_threads ?= 4
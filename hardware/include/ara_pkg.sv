@@ -80,14 +80,20 @@ package ara_pkg;
   endfunction : RVVBA
 
   // TMAC latencies
-  localparam int unsigned LatTmacEW64 = 2; // Adjust based on your implementation
+  localparam int unsigned LatTmacEW64 = 2;
   localparam int unsigned LatTmacEW32 = 2;
   localparam int unsigned LatTmacEW16 = 1;
   localparam int unsigned LatTmacEW8  = 1;
 
   // TMAC-specific parameters
-  localparam int unsigned TmacLUTSize = 16; // The default LUT size in your implementation
-  localparam int unsigned TmacWeightBits = 4; // Default weight bits
+  // A group of TmacGroupSize 8-bit activations is expanded in a LUT with all the
+  // TmacLUTSize sums of its subsets. The weights have up to TmacWeightBits bits.
+  localparam int unsigned TmacGroupSize  = 4;
+  localparam int unsigned TmacLUTSize    = 1 << TmacGroupSize;
+  localparam int unsigned TmacLUTWidth   = 8 + $clog2(TmacGroupSize);
+  localparam int unsigned TmacWeightBits = 4;
+
+  typedef logic [TmacLUTSize-1:0][TmacLUTWidth-1:0] tmac_lut_t;
 
 
   // Multiplier latencies.
@@ -8,18 +8,16 @@
 //
 // Note: the module does not support answers from Ara,
 // it is just a blind dispatcher
+//
+// The instructions are streamed from the trace given with +vtrace=FILE (or,
+// by default, from the VTRACE define) by tb/dpi/vtrace_reader.cc, so one
+// model runs the traces of all the applications.
 
 `define STRINGIFY(x) `"x`"
 `ifndef VTRACE
 `define VTRACE ./
 `endif
 
-// Dummy definition not to throw errors during compilation
-// If N_VINSN is not defined, this file will not be used anyway
-`ifndef N_VINSN
-`define N_VINSN 1
-`endif
-
 module accel_dispatcher_ideal import axi_pkg::*; import ara_pkg::*; # (
   parameter  config_pkg::cva6_cfg_t CVA6Cfg = cva6_config_pkg::cva6_cfg,
   parameter type cva6_to_acc_t = logic,
@@ -33,76 +31,71 @@ module accel_dispatcher_ideal import axi_pkg::*; import ara_pkg::*; # (
   input  acc_to_cva6_t acc_resp_i
 );
 
-  localparam string vtrace = `STRINGIFY(`VTRACE);
+  // The reader is referred to with an integer handle, 0 if the trace could not be
+  // opened, so that it survives the checkpoints of the Verilator model
+  import "DPI-C" function int vtrace_open(input string path);
+  import "DPI-C" function void vtrace_rewind(input int reader);
+  import "DPI-C" function bit vtrace_next(input int reader, output int insn,
+    output longint rs1, output longint rs2);
+  import "DPI-C" function longint vtrace_entries(input int reader);
+  import "DPI-C" function void vtrace_close(input int reader);
 
   //////////
   // Data //
   //////////
 
-  // Width and number of vector instructions in the ideal dispatcher
-  localparam integer unsigned DATA_WIDTH  = 32 + 64 + 64; // vinsn + scalar reg + scalar reg
-  localparam integer unsigned N_VINSN   = `N_VINSN;
-
   typedef struct packed {
     riscv::instruction_t insn;
     xlen_t rs1;
     xlen_t rs2;
   } fifo_payload_t;
 
-  logic [DATA_WIDTH-1:0] fifo_data_raw;
-  fifo_payload_t fifo_data;
+  int vtrace_reader = 0;
+
+  initial begin
+    automatic string vtrace = `STRINGIFY(`VTRACE);
 
-  // FIFO-like structure with no reset
-  // Instantiated here without hierarchy to please questasim
-
-  // FIFO read pointer
-  logic [$clog2(N_VINSN):0] read_pointer_n, read_pointer_q;
-  // FIFO counter
-  logic [$clog2(N_VINSN):0] status_cnt_n, status_cnt_q;
-  // FIFO
-  logic [DATA_WIDTH-1:0] fifo_q [N_VINSN];
-  logic fifo_empty;
-
-  // read and write queue logic
-  always_comb begin : read_write_comb
-    // Default assignment
-    read_pointer_n = read_pointer_q;
-    status_cnt_n   = status_cnt_q;
-    fifo_data_raw  = fifo_q[read_pointer_q];
-
-    if (acc_resp_i.acc_resp.req_ready && ~fifo_empty) begin
-      // read from the queue is a default assignment
-      // but increment the read pointer...
-      if (read_pointer_n == N_VINSN - 1)
-        read_pointer_n = '0;
-      else
-        read_pointer_n = read_pointer_q + 1;
-      // ... and decrement the overall count
-      status_cnt_n = status_cnt_q - 1;
+    void'($value$plusargs("vtrace=%s", vtrace));
+    vtrace_reader = vtrace_open(vtrace);
+    if (vtrace_reader == 0)
+      $fatal(1, "[ideal-dispatcher] Could not open the vector trace %s", vtrace);
+  end
+
+  final begin
+    if (vtrace_reader != 0) begin
+      $display("[ideal-dispatcher] %0d instructions dispatched", vtrace_entries(vtrace_reader));
+      vtrace_close(vtrace_reader);
     end
   end
 
-  // sequential process
+  // Head of the trace, popped upon every handshake with Ara. The trace
+  // restarts with every reset.
+  fifo_payload_t fifo_data;
+  logic          fifo_valid, fifo_started;
+
   always_ff @(posedge clk_i or negedge rst_ni) begin
     if (!rst_ni) begin
-      read_pointer_q  <= '0;
-      status_cnt_q    <= N_VINSN;
-    end else begin
-      read_pointer_q  <= read_pointer_n;
-      status_cnt_q    <= status_cnt_n;
+      fifo_data    <= '0;
+      fifo_valid   <= 1'b0;
+      fifo_started <= 1'b0;
+    end else if (!fifo_started || (fifo_valid && acc_resp_i.acc_resp.req_ready)) begin
+      automatic int     insn;
+      automatic longint rs1, rs2;
+
+      if (!fifo_started && vtrace_reader != 0) vtrace_rewind(vtrace_reader);
+      fifo_started <= 1'b1;
+      fifo_valid   <= vtrace_reader != 0 && vtrace_next(vtrace_reader, insn, rs1, rs2);
+      fifo_data    <= fifo_payload_t'({insn, rs1, rs2});
     end
   end
 
-  assign fifo_empty = (status_cnt_q == 0);
-
   // Output assignment
-  assign fifo_data = fifo_payload_t'(fifo_data_raw);
   assign acc_req_o.acc_req = '{
     insn    : fifo_data.insn,
     rs1     : fifo_data.rs1,
     rs2     : fifo_data.rs2,
     // Always valid until empty
-    req_valid  : ~fifo_empty,
+    req_valid  : fifo_valid,
     // Flush the answer
     resp_ready : 1'b1,
     default : '0
@@ -110,9 +103,6 @@ module accel_dispatcher_ideal import axi_pkg::*; import ara_pkg::*; # (
   assign acc_req_o.acc_mmu_resp = '0;
   assign acc_req_o.acc_mmu_en = 1'b0;
 
-  // Initialize the perfect dispatcher
-  initial $readmemh(vtrace, fifo_q);
-
   /////////////
   // Control //
   /////////////
@@ -136,7 +126,8 @@ module accel_dispatcher_ideal import axi_pkg::*; import ara_pkg::*; # (
   // Stop the computation when the instructions are over and ara has returned idle
   // Just check that we are after reset
   always_ff @(posedge clk_i) begin
-    if (rst_ni && was_reset && !acc_req_o.acc_req.req_valid && i_system.i_ara.ara_idle) begin
+    if (rst_ni && was_reset && fifo_started && !acc_req_o.acc_req.req_valid &&
+        i_system.i_ara.ara_idle) begin
       $display("[hw-cycles]: %d", int'(perf_cnt_q));
       $display("[cva6-d$-stalls]: %d", int'(dut.dcache_stall_buf_q));
       $display("[cva6-i$-stalls]: %d", int'(dut.icache_stall_buf_q));
@@ -694,8 +694,6 @@ module ara_dispatcher import ara_pkg::*; import rvv_pkg::*; #(
 
                 // Decode based on the func6 field
                 unique case (insn.varith_type.func6)
-                  6'b111001: ara_req.op = ara_pkg::VTMAC;
-                  6'b110010: ara_req.op = ara_pkg::VTMACC;
                   6'b000000: ara_req.op = ara_pkg::VADD;
                   6'b000010: ara_req.op = ara_pkg::VSUB;
                   6'b000100: ara_req.op = ara_pkg::VMINU;
@@ -949,6 +947,12 @@ module ara_dispatcher import ara_pkg::*; import rvv_pkg::*; #(
 
                 // Decode based on the func6 field
                 unique case (insn.varith_type.func6)
+                  // T-MAC: rs1 holds the group of activations, see vtmac
+                  6'b111001: ara_req.op = ara_pkg::VTMAC;
+                  6'b110010: begin
+                    ara_req.op        = ara_pkg::VTMACC;
+                    ara_req.use_vd_op = 1'b1;
+                  end
                   6'b000000: ara_req.op = ara_pkg::VADD;
                   6'b000010: ara_req.op = ara_pkg::VSUB;
                   6'b000011: ara_req.op = ara_pkg::VRSUB;
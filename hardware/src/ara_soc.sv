@@ -28,6 +28,10 @@ module ara_soc import axi_pkg::*; import ara_pkg::*; #(
     parameter  int           unsigned AxiRespDelay = 200,
     // Main memory
     parameter  int           unsigned L2NumWords   = (2**22) / NrLanes,
+    // Replace the single-cycle L2 timing by the DRAM timing model (simulation only)
+    parameter  bit                    DramModel    = 1'b0,
+    // Maximum number of outstanding requests of the DRAM timing model
+    parameter  int           unsigned DramMaxOutstanding = 16,
     // Dependant parameters. DO NOT CHANGE!
     localparam type                   axi_data_t   = logic [AxiDataWidth-1:0],
     localparam type                   axi_strb_t   = logic [AxiDataWidth/8-1:0],
@@ -213,12 +217,15 @@ module ara_soc import axi_pkg::*; import ara_pkg::*; #(
   logic [AxiDataWidth-1:0]   l2_wdata;
   logic [AxiDataWidth-1:0]   l2_rdata;
   logic                      l2_rvalid;
+  logic                      l2_gnt;
+  logic [AxiDataWidth-1:0]   l2_sram_rdata;
 
   axi_to_mem #(
     .AddrWidth (AxiAddrWidth   ),
     .DataWidth (AxiDataWidth   ),
     .IdWidth   (AxiSocIdWidth  ),
     .NumBanks  (1              ),
+    .BufDepth  (DramModel ? DramMaxOutstanding : 1),
     .axi_req_t (soc_wide_req_t ),
     .axi_resp_t(soc_wide_resp_t)
   ) i_axi_to_mem (
@@ -227,7 +234,7 @@ module ara_soc import axi_pkg::*; import ara_pkg::*; #(
     .axi_req_i   (l2mem_wide_axi_req_wo_atomics ),
     .axi_resp_o  (l2mem_wide_axi_resp_wo_atomics),
     .mem_req_o   (l2_req                        ),
-    .mem_gnt_i   (l2_req                        ), // Always available
+    .mem_gnt_i   (l2_gnt                        ),
     .mem_we_o    (l2_we                         ),
     .mem_addr_o  (l2_addr                       ),
     .mem_strb_o  (l2_be                         ),
@@ -247,19 +254,50 @@ module ara_soc import axi_pkg::*; import ara_pkg::*; #(
   ) i_dram (
     .clk_i  (clk_i                                                                      ),
     .rst_ni (rst_ni                                                                     ),
-    .req_i  (l2_req                                                                     ),
+    .req_i  (l2_gnt                                                                     ),
     .we_i   (l2_we                                                                      ),
     .addr_i (l2_addr[$clog2(L2NumWords)-1+$clog2(AxiDataWidth/8):$clog2(AxiDataWidth/8)]),
     .wdata_i(l2_wdata                                                                   ),
     .be_i   (l2_be                                                                      ),
-    .rdata_o(l2_rdata                                                                   )
+    .rdata_o(l2_sram_rdata                                                              )
   );
 `else
-  assign l2_rdata = '0;
+  assign l2_sram_rdata = '0;
 `endif
 
-  // One-cycle latency
-  `FF(l2_rvalid, l2_req, 1'b0);
+  if (DramModel) begin: gen_dram_model
+`ifndef SPYGLASS
+    ara_dram_model #(
+      .DataWidth     (AxiDataWidth      ),
+      .AddrWidth     (AxiAddrWidth      ),
+      .MaxOutstanding(DramMaxOutstanding)
+    ) i_dram_model (
+      .clk_i       (clk_i        ),
+      .rst_ni      (rst_ni       ),
+      .req_i       (l2_req       ),
+      .we_i        (l2_we        ),
+      .addr_i      (l2_addr      ),
+      .gnt_o       (l2_gnt       ),
+      .rdata_o     (l2_rdata     ),
+      .rvalid_o    (l2_rvalid    ),
+      .sram_rdata_i(l2_sram_rdata)
+    );
+`else
+    // The DPI model is not part of the SPYGLASS build: the memory is always
+    // available, as without the model
+    assign l2_gnt   = l2_req;
+    assign l2_rdata = l2_sram_rdata;
+
+    `FF(l2_rvalid, l2_req, 1'b0);
+`endif
+  end else begin: gen_l2_timing
+    // Always available
+    assign l2_gnt   = l2_req;
+    assign l2_rdata = l2_sram_rdata;
+
+    // One-cycle latency
+    `FF(l2_rvalid, l2_req, 1'b0);
+  end
 
   ////////////
   //  UART  //
@@ -377,7 +377,7 @@ module lane_sequencer import ara_pkg::*; import rvv_pkg::*; import cf_math_pkg::
 
       // Mute request if the instruction runs in the lane and the vl is zero.
       // Exception: during a reduction, all the lanes must cooperate anyway.
-      if (vfu_operation_d.vl == '0 && (vfu_operation_d.vfu inside {VFU_Alu, VFU_MFpu}) && !(vfu_operation_d.op inside {[VREDSUM:VWREDSUM], [VFREDUSUM:VFWREDOSUM]})) begin
+      if (vfu_operation_d.vl == '0 && (vfu_operation_d.vfu inside {VFU_Alu, VFU_MFpu, VFU_TmacUnit}) && !(vfu_operation_d.op inside {[VREDSUM:VWREDSUM], [VFREDUSUM:VFWREDOSUM]})) begin
         vfu_operation_valid_d = 1'b0;
         // We are already done with this instruction
         vinsn_done_d[pe_req.id] |= 1'b1;
@@ -926,21 +926,22 @@ module lane_sequencer import ara_pkg::*; import rvv_pkg::*; import cf_math_pkg::
           operand_request_push[MaskM] = !pe_req.vm;
         end
         VFU_TmacUnit: begin
+          // The activations come with the scalar operand, TmacA brings the accumulator
           operand_request[TmacA] = '{
             id         : pe_req.id,
-            vs         : pe_req.vs1,
-            eew        : pe_req.eew_vs1,
-            conv       : pe_req.conversion_vs1,
+            vs         : pe_req.vd,
+            eew        : pe_req.eew_vd_op,
+            conv       : OpQueueConversionNone,
             scale_vl   : pe_req.scale_vl,
             cvt_resize : pe_req.cvt_resize,
             vtype      : pe_req.vtype,
             vl         : vfu_operation_d.vl,
             vstart     : vfu_operation_d.vstart,
-            hazard     : pe_req.hazard_vs1 | pe_req.hazard_vd,
+            hazard     : pe_req.hazard_vd,
             target_fu  : TMAC,
             default    : '0
           };
-          operand_request_push[TmacA] = pe_req.use_vs1;
+          operand_request_push[TmacA] = pe_req.use_vd_op;
 
           operand_request[TmacB] = '{
             id         : pe_req.id,
@@ -0,0 +1,158 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// Ara's SIMD T-MAC datapath, operating on elements 64-bit wide.
+// Every element of the weight operand holds the bit planes of the weights of one row,
+// i.e., TmacGroupSize bits per plane, plane p in bits [TmacGroupSize*p +: TmacGroupSize].
+// Each plane indexes the LUT of the activation group, and the lookups of the planes
+// are shifted and added in the input stage, so that all the planes of all the elements
+// are looked up in the same cycle. The accumulator is added in the output stage.
+// The parametric number of pipeline register determines the intrinsic latency of the unit.
+// Once the pipeline is full, the unit can generate 64 bits per cycle.
+
+module simd_tmac import ara_pkg::*; import rvv_pkg::*; #(
+    // SIMD T-MAC parameters
+    parameter  int    unsigned NumPipeRegs  = 0,
+    parameter  vew_e           ElementWidth = EW64,
+    // Dependant parameters. DO NOT CHANGE!
+    localparam int    unsigned DataWidth    = $bits(elen_t),
+    localparam int    unsigned StrbWidth    = DataWidth/8,
+    localparam type            strb_t       = logic [DataWidth/8-1:0]
+  ) (
+    input  logic       clk_i,
+    input  logic       rst_ni,
+    // LUT of the activation group, and log2 of the width of the weights
+    input  tmac_lut_t  lut_i,
+    input  logic [1:0] wbits_i,
+    input  elen_t      operand_b_i,
+    input  elen_t      operand_c_i,
+    input  strb_t      mask_i,
+    input  ara_op_e    op_i,
+    output elen_t      result_o,
+    output strb_t      mask_o,
+    input  logic       valid_i,
+    output logic       ready_o,
+    input  logic       ready_i,
+    output logic       valid_o
+  );
+
+`include "common_cells/registers.svh"
+
+  ///////////////////
+  //  Definitions  //
+  ///////////////////
+
+  localparam int unsigned ElemWidth = 8 << int'(ElementWidth);
+  localparam int unsigned NrElems   = DataWidth / ElemWidth;
+  // Narrow elements do not have room for all the bit planes
+  localparam int unsigned NrPlanes  = ElemWidth / TmacGroupSize < TmacWeightBits ?
+                                      ElemWidth / TmacGroupSize : TmacWeightBits;
+  // Width of the dot product of a group of activations with a row of weights
+  localparam int unsigned DotWidth  = TmacLUTWidth + TmacWeightBits;
+
+  elen_t   dot, opc;
+  ara_op_e op;
+
+  ///////////////////
+  //  Table lookup //
+  ///////////////////
+
+  elen_t lookup;
+
+  always_comb begin : p_lookup
+    automatic logic [DotWidth-1:0] sum;
+
+    lookup = '0;
+    for (int e = 0; e < NrElems; e++) begin
+      sum = '0;
+      for (int p = 0; p < NrPlanes; p++)
+        if (p < (1 << wbits_i))
+          sum += DotWidth'($signed(
+            lut_i[operand_b_i[e*ElemWidth + p*TmacGroupSize +: TmacGroupSize]])) << p;
+      // Sign-extend, or wrap around, to the element width
+      lookup[e*ElemWidth +: ElemWidth] = ElemWidth'($signed(sum));
+    end
+  end : p_lookup
+
+  ///////////////////////
+  //  Pipeline stages  //
+  ///////////////////////
+
+  // Input signals for the next stage (= output signals of the previous stage)
+  elen_t   [NumPipeRegs:0] dot_d, opc_d;
+  ara_op_e [NumPipeRegs:0] op_d;
+  strb_t   [NumPipeRegs:0] mask_d;
+  logic    [NumPipeRegs:0] valid_d;
+  // Ready signal is combinatorial for all stages
+  logic    [NumPipeRegs:0] stage_ready;
+
+  // Input stage: First element of pipeline is taken from inputs
+  assign dot_d[0]   = lookup;
+  assign opc_d[0]   = operand_c_i;
+  assign op_d[0]    = op_i;
+  assign mask_d[0]  = mask_i;
+  assign valid_d[0] = valid_i;
+
+  // Generate the pipeline stages in case they are needed
+  if (NumPipeRegs > 0) begin : gen_pipeline
+    // Pipelined versions of signals for later stages
+    elen_t   [NumPipeRegs-1:0] dot_q, opc_q;
+    strb_t   [NumPipeRegs-1:0] mask_q;
+    ara_op_e [NumPipeRegs-1:0] op_q;
+    logic    [NumPipeRegs-1:0] valid_q;
+
+    for (genvar i = 0; i < NumPipeRegs; i++) begin : gen_pipeline_stages
+      // Next state from previous register to form a shift register
+      assign dot_d[i+1]   = dot_q[i];
+      assign opc_d[i+1]   = opc_q[i];
+      assign op_d[i+1]    = op_q[i];
+      assign mask_d[i+1]  = mask_q[i];
+      assign valid_d[i+1] = valid_q[i];
+
+      // Determine the ready signal of the current stage - advance the pipeline:
+      // 1. if the next stage is ready for our data
+      // 2. if the next stage register only holds a bubble (not valid) -> we can pop it
+      assign stage_ready[i] = stage_ready[i+1] | ~valid_q[i];
+
+      // Enable register if pipeline ready
+      logic reg_ena;
+      assign reg_ena = stage_ready[i];
+
+      // Generate the pipeline
+      `FFL(valid_q[i], valid_d[i], reg_ena, '0)
+      `FFL(dot_q[i], dot_d[i], reg_ena, '0)
+      `FFL(opc_q[i], opc_d[i], reg_ena, '0)
+      `FFL(op_q[i], op_d[i], reg_ena, ara_op_e'('0))
+      `FFL(mask_q[i], mask_d[i], reg_ena, '0)
+    end : gen_pipeline_stages
+  end
+
+  // Input stage: Propagate ready signal from pipeline
+  assign ready_o = stage_ready[0];
+
+  // Output stage: bind last stage outputs to the pipeline output. Directly connects to input if no
+  // regs.
+  assign dot     = dot_d[NumPipeRegs];
+  assign opc     = opc_d[NumPipeRegs];
+  assign op      = op_d[NumPipeRegs];
+  assign mask_o  = mask_d[NumPipeRegs];
+  assign valid_o = valid_d[NumPipeRegs];
+
+  // Output stage: Ready travels backwards from output side
+  assign stage_ready[NumPipeRegs] = ready_i;
+
+  ///////////////////
+  //  Accumulator  //
+  ///////////////////
+
+  always_comb begin : p_accumulate
+    result_o = dot;
+    if (op == VTMACC)
+      for (int e = 0; e < NrElems; e++)
+        result_o[e*ElemWidth +: ElemWidth] = dot[e*ElemWidth +: ElemWidth] +
+          opc[e*ElemWidth +: ElemWidth];
+  end : p_accumulate
+
+endmodule : simd_tmac
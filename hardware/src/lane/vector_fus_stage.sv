@@ -108,9 +108,9 @@ module vector_fus_stage import ara_pkg::*; import rvv_pkg::*; import cf_math_pkg
   assign mask_ready_o = alu_mask_ready | mfpu_mask_ready | tmac_mask_ready;
 
   // saturation selection
+  // The T-MAC results wrap around, as the ones of vmacc
   logic alu_vxsat, mfpu_vxsat;
-  logic tmac_vxsat;
-  assign vxsat_flag_o = mfpu_vxsat | alu_vxsat | tmac_vxsat;
+  assign vxsat_flag_o = mfpu_vxsat | alu_vxsat;
 
   ///////////////////
   //  Vector TMAC  //
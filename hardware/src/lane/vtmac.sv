@@ -1,9 +1,18 @@
 // Copyright 2025
-// 
+//
 // Description:
 // This is the T-MAC (Table Lookup for Low-Bit LLM) unit for Ara.
 // It implements the table-lookup approach for matrix multiplication
 // with bit-serial decomposition as described in the T-MAC paper.
+//
+// The scalar operand holds a group of TmacGroupSize signed 8-bit activations in its
+// low bits, and the log2 of the width of the weights (1, 2, or 4 bits) in bits [33:32].
+// The LUT with the sums of all the subsets of the group is built once per instruction,
+// when it reaches the issue stage. Every element of vs2 holds the bit planes of the
+// unsigned weights of a row (see simd_tmac), and:
+// - VTMAC:  vd[i] = sum_j act[j] * w[i][j]
+// - VTMACC: vd[i] = vd[i] + sum_j act[j] * w[i][j]
+// The unit is fully pipelined, and processes a 64-bit word of weights per cycle.
 
 module vtmac import ara_pkg::*; import rvv_pkg::*; import cf_math_pkg::idx_width; #(
     parameter  int    unsigned NrLanes         = 0,
@@ -20,18 +29,19 @@ module vtmac import ara_pkg::*; import rvv_pkg::*; import cf_math_pkg::idx_width
     input  logic                         clk_i,
     input  logic                         rst_ni,
     input  logic[idx_width(NrLanes)-1:0] lane_id_i,
-    
+
     // Interface with the lane sequencer
     input  vfu_operation_t               vfu_operation_i,
     input  logic                         vfu_operation_valid_i,
     output logic                         tmac_ready_o,
     output logic           [NrVInsn-1:0] tmac_vinsn_done_o,
-    
+
     // Interface with the operand queues
+    // 0: vd (VTMACC), 1: vs2
     input  elen_t          [1:0]         tmac_operand_i,
     input  logic           [1:0]         tmac_operand_valid_i,
     output logic           [1:0]         tmac_operand_ready_o,
-    
+
     // Interface with the vector register file
     output logic                         tmac_result_req_o,
     output vid_t                         tmac_result_id_o,
@@ -39,7 +49,7 @@ module vtmac import ara_pkg::*; import rvv_pkg::*; import cf_math_pkg::idx_width
     output elen_t                        tmac_result_wdata_o,
     output strb_t                        tmac_result_be_o,
     input  logic                         tmac_result_gnt_i,
-    
+
     // Interface with the Mask unit
     input  strb_t                        mask_i,
     input  logic                         mask_valid_i,
@@ -54,7 +64,7 @@ module vtmac import ara_pkg::*; import rvv_pkg::*; import cf_math_pkg::idx_width
   ////////////////////////////////
 
   // We store a certain number of in-flight vector instructions
-  localparam VInsnQueueDepth = 4; // Adjust as needed for T-MAC
+  localparam VInsnQueueDepth = TmacInsnQueueDepth;
 
   struct packed {
     vfu_operation_t [VInsnQueueDepth-1:0] vinsn;
@@ -62,10 +72,12 @@ module vtmac import ara_pkg::*; import rvv_pkg::*; import cf_math_pkg::idx_width
     // Instruction execution phases pointers
     logic [idx_width(VInsnQueueDepth)-1:0] accept_pnt;
     logic [idx_width(VInsnQueueDepth)-1:0] issue_pnt;
+    logic [idx_width(VInsnQueueDepth)-1:0] processing_pnt;
     logic [idx_width(VInsnQueueDepth)-1:0] commit_pnt;
 
     // Instruction counters
     logic [idx_width(VInsnQueueDepth):0] issue_cnt;
+    logic [idx_width(VInsnQueueDepth):0] processing_cnt;
     logic [idx_width(VInsnQueueDepth):0] commit_cnt;
   } vinsn_queue_d, vinsn_queue_q;
 
@@ -79,6 +91,10 @@ module vtmac import ara_pkg::*; import rvv_pkg::*; import cf_math_pkg::idx_width
   assign vinsn_issue_d     = vinsn_queue_d.vinsn[vinsn_queue_d.issue_pnt];
   assign vinsn_issue_valid = (vinsn_queue_q.issue_cnt != '0);
 
+  // Do we have a vector instruction being processed?
+  vfu_operation_t vinsn_processing;
+  assign vinsn_processing = vinsn_queue_q.vinsn[vinsn_queue_q.processing_pnt];
+
   // Do we have a vector instruction with results being committed?
   vfu_operation_t vinsn_commit;
   logic           vinsn_commit_valid;
@@ -110,70 +126,167 @@ module vtmac import ara_pkg::*; import rvv_pkg::*; import cf_math_pkg::idx_width
   logic result_queue_full;
   assign result_queue_full = (result_queue_cnt_q == ResultQueueDepth);
 
-  ///////////////////////////
-  //  T-MAC implementation //
-  ///////////////////////////
-  
-  // States for the T-MAC operation
-  typedef enum logic [2:0] {
-    IDLE,
-    BIT_DECOMPOSITION,   // Decompose weight matrix into one-bit matrices
-    PRECOMPUTE_LUT,      // Precompute the activation matrix into LUT
-    TABLE_LOOKUP,        // Perform table lookup operations
-    BIT_AGGREGATION      // Aggregate the results
-  } tmac_state_e;
-  
-  tmac_state_e tmac_state_d, tmac_state_q;
-  
-  // Lookup Table (LUT) storage
-  // The size would depend on the group size (g)
-  localparam int unsigned LUTSize = 16; // Example size, adjust as needed
-  localparam int unsigned GroupSize = 4; // Group size for LUT (g)
-  
-  elen_t [LUTSize-1:0] lut_d, lut_q;
-  
-  // Weight matrices after bit-serial decomposition
-  // For simplicity, we'll assume a fixed number of bits
-  localparam int unsigned WeightBits = 4; // Example, adjust based on your needs
-  elen_t [WeightBits-1:0] weight_matrices_d, weight_matrices_q;
-  
-  // Counters for T-MAC processing
-  logic [2:0] current_bit_d, current_bit_q;
-  logic [7:0] current_position_d, current_position_q;
-  
-  // Remaining elements of the current instruction in the issue phase
-  vlen_t issue_cnt_d, issue_cnt_q;
-  // Remaining elements of the current instruction in the commit phase
-  vlen_t commit_cnt_d, commit_cnt_q;
+  ///////////
+  //  LUT  //
+  ///////////
+
+  // All the sums of the subsets of a group of activations
+  function automatic tmac_lut_t tmac_lut(logic [TmacGroupSize-1:0][7:0] act);
+    for (int k = 0; k < TmacLUTSize; k++) begin
+      tmac_lut[k] = '0;
+      for (int j = 0; j < TmacGroupSize; j++)
+        if (k & (1 << j)) tmac_lut[k] += TmacLUTWidth'($signed(act[j]));
+    end
+  endfunction : tmac_lut
+
+  // The LUT follows the instruction being issued. Build it only when a new instruction
+  // reaches the issue stage, and keep it for all its micro-operations.
+  tmac_lut_t lut_q;
+  logic      lut_en;
+  assign lut_en = (vinsn_queue_d.issue_pnt != vinsn_queue_q.issue_pnt) ||
+                  (vinsn_queue_q.issue_cnt == '0);
+
+  `FFL(lut_q, tmac_lut(vinsn_issue_d.scalar_op[TmacGroupSize*8-1:0]), lut_en, '0)
+
+  ////////////////////////
+  //  SIMD T-MAC units  //
+  ////////////////////////
+
+  logic    [3:0] tmac_simd_in_valid;
+  logic    [3:0] tmac_simd_in_ready;
+  logic    [3:0] tmac_simd_out_valid;
+  logic    [3:0] tmac_simd_out_ready;
+  elen_t   [3:0] tmac_simd_result;
+  strb_t   [3:0] tmac_simd_mask;
+
+  simd_tmac #(
+    .NumPipeRegs (LatTmacEW64),
+    .ElementWidth(EW64       )
+  ) i_simd_tmac_ew64 (
+    .clk_i      (clk_i                                ),
+    .rst_ni     (rst_ni                               ),
+    .lut_i      (lut_q                                ),
+    .wbits_i    (vinsn_issue_q.scalar_op[33:32]       ),
+    .operand_b_i(tmac_operand_i[1]                    ),
+    .operand_c_i(tmac_operand_i[0]                    ),
+    .mask_i     (mask_i                               ),
+    .op_i       (vinsn_issue_q.op                     ),
+    .result_o   (tmac_simd_result[EW64]               ),
+    .mask_o     (tmac_simd_mask[EW64]                 ),
+    .valid_i    (tmac_simd_in_valid[EW64]             ),
+    .ready_o    (tmac_simd_in_ready[EW64]             ),
+    .ready_i    (tmac_simd_out_ready[EW64]            ),
+    .valid_o    (tmac_simd_out_valid[EW64]            )
+  );
+
+  simd_tmac #(
+    .NumPipeRegs (LatTmacEW32),
+    .ElementWidth(EW32       )
+  ) i_simd_tmac_ew32 (
+    .clk_i      (clk_i                                ),
+    .rst_ni     (rst_ni                               ),
+    .lut_i      (lut_q                                ),
+    .wbits_i    (vinsn_issue_q.scalar_op[33:32]       ),
+    .operand_b_i(tmac_operand_i[1]                    ),
+    .operand_c_i(tmac_operand_i[0]                    ),
+    .mask_i     (mask_i                               ),
+    .op_i       (vinsn_issue_q.op                     ),
+    .result_o   (tmac_simd_result[EW32]               ),
+    .mask_o     (tmac_simd_mask[EW32]                 ),
+    .valid_i    (tmac_simd_in_valid[EW32]             ),
+    .ready_o    (tmac_simd_in_ready[EW32]             ),
+    .ready_i    (tmac_simd_out_ready[EW32]            ),
+    .valid_o    (tmac_simd_out_valid[EW32]            )
+  );
 
-  // How many elements are we processing this cycle?
-  logic [3:0] element_cnt_buf_issue, element_cnt_buf_commit;
-  logic [1:0] issue_effective_eew, commit_effective_eew;
-  logic [6:0] element_cnt_issue;
-  logic [6:0] element_cnt_commit;
+  simd_tmac #(
+    .NumPipeRegs (LatTmacEW16),
+    .ElementWidth(EW16       )
+  ) i_simd_tmac_ew16 (
+    .clk_i      (clk_i                                ),
+    .rst_ni     (rst_ni                               ),
+    .lut_i      (lut_q                                ),
+    .wbits_i    (vinsn_issue_q.scalar_op[33:32]       ),
+    .operand_b_i(tmac_operand_i[1]                    ),
+    .operand_c_i(tmac_operand_i[0]                    ),
+    .mask_i     (mask_i                               ),
+    .op_i       (vinsn_issue_q.op                     ),
+    .result_o   (tmac_simd_result[EW16]               ),
+    .mask_o     (tmac_simd_mask[EW16]                 ),
+    .valid_i    (tmac_simd_in_valid[EW16]             ),
+    .ready_o    (tmac_simd_in_ready[EW16]             ),
+    .ready_i    (tmac_simd_out_ready[EW16]            ),
+    .valid_o    (tmac_simd_out_valid[EW16]            )
+  );
+
+  simd_tmac #(
+    .NumPipeRegs (LatTmacEW8),
+    .ElementWidth(EW8       )
+  ) i_simd_tmac_ew8 (
+    .clk_i      (clk_i                                ),
+    .rst_ni     (rst_ni                               ),
+    .lut_i      (lut_q                                ),
+    .wbits_i    (vinsn_issue_q.scalar_op[33:32]       ),
+    .operand_b_i(tmac_operand_i[1]                    ),
+    .operand_c_i(tmac_operand_i[0]                    ),
+    .mask_i     (mask_i                               ),
+    .op_i       (vinsn_issue_q.op                     ),
+    .result_o   (tmac_simd_result[EW8]                ),
+    .mask_o     (tmac_simd_mask[EW8]                  ),
+    .valid_i    (tmac_simd_in_valid[EW8]              ),
+    .ready_o    (tmac_simd_in_ready[EW8]              ),
+    .ready_i    (tmac_simd_out_ready[EW8]             ),
+    .valid_o    (tmac_simd_out_valid[EW8]             )
+  );
+
+  // The outputs of the SIMD units are read in order
+  elen_t tmac_result;
+  logic  tmac_in_valid;
+  logic  tmac_in_ready;
+  logic  tmac_out_valid;
+  logic  tmac_out_ready;
+  strb_t tmac_mask;
+
+  always_comb begin
+    // Only one SIMD unit receives the request
+    tmac_simd_in_valid                           = '0;
+    tmac_simd_in_valid[vinsn_issue_q.vtype.vsew] = tmac_in_valid;
+    tmac_in_ready                                = tmac_simd_in_ready[vinsn_issue_q.vtype.vsew];
+
+    // We read the responses of a single SIMD unit
+    tmac_result         = tmac_simd_result[vinsn_processing.vtype.vsew];
+    tmac_mask           = tmac_simd_mask[vinsn_processing.vtype.vsew];
+    tmac_out_valid      = tmac_simd_out_valid[vinsn_processing.vtype.vsew];
+    tmac_simd_out_ready = '0;
+    tmac_simd_out_ready[vinsn_processing.vtype.vsew] = tmac_out_ready;
+  end
 
   ///////////////
   //  Control  //
   ///////////////
 
+  // Remaining elements of the current instruction in the issue phase
+  vlen_t issue_cnt_d, issue_cnt_q;
+  // Remaining elements of the current instruction in the processing phase
+  vlen_t to_process_cnt_d, to_process_cnt_q;
+  // Remaining elements of the current instruction in the commit phase
+  vlen_t commit_cnt_d, commit_cnt_q;
+
+  // Do we have all the operands of the instruction being issued?
+  logic operands_valid;
+
   always_comb begin : p_vtmac_control
     // Maintain state
-    vinsn_queue_d = vinsn_queue_q;
-    issue_cnt_d   = issue_cnt_q;
-    commit_cnt_d  = commit_cnt_q;
+    vinsn_queue_d    = vinsn_queue_q;
+    issue_cnt_d      = issue_cnt_q;
+    to_process_cnt_d = to_process_cnt_q;
+    commit_cnt_d     = commit_cnt_q;
 
     result_queue_d           = result_queue_q;
     result_queue_valid_d     = result_queue_valid_q;
     result_queue_read_pnt_d  = result_queue_read_pnt_q;
     result_queue_write_pnt_d = result_queue_write_pnt_q;
     result_queue_cnt_d       = result_queue_cnt_q;
-    
-    // T-MAC specific state
-    tmac_state_d         = tmac_state_q;
-    lut_d                = lut_q;
-    weight_matrices_d    = weight_matrices_q;
-    current_bit_d        = current_bit_q;
-    current_position_d   = current_position_q;
 
     // Inform our status to the lane controller
     tmac_ready_o      = !vinsn_queue_full;
@@ -181,183 +294,126 @@ module vtmac import ara_pkg::*; import rvv_pkg::*; import cf_math_pkg::idx_width
 
     // Do not acknowledge any operands by default
     tmac_operand_ready_o = '0;
-    mask_ready_o         = '0;
-
-    // How many elements are we processing this cycle?
-    issue_effective_eew = unsigned'(vinsn_issue_q.vtype.vsew[1:0]);
-    element_cnt_buf_issue = 1 << (unsigned'(EW64) - issue_effective_eew);
-    element_cnt_issue = {2'b0, element_cnt_buf_issue};
-
-    commit_effective_eew = unsigned'(vinsn_commit.vtype.vsew[1:0]);
-    element_cnt_buf_commit = 1 << (unsigned'(EW64) - commit_effective_eew);
-    element_cnt_commit = {2'b0, element_cnt_buf_commit};
-
-    // T-MAC state machine
-    case (tmac_state_q)
-      IDLE: begin
-        // Only process if we have a valid instruction
-        if (vinsn_issue_valid) begin
-          // If this is a T-MAC instruction (assuming TMAC is defined in the instruction set)
-          if (vinsn_issue_q.op == TMAC) begin
-            // Initialize for T-MAC operation
-            current_bit_d = '0;
-            current_position_d = '0;
-            tmac_state_d = BIT_DECOMPOSITION;
-          end
-        end
-      end
-      
-      BIT_DECOMPOSITION: begin
-        // Check if we have the operands needed
-        if (tmac_operand_valid_i[1]) begin
-          // Get the weight matrix
-          // Implementation of bit-serial decomposition as per the paper
-          if (current_bit_q < WeightBits) begin
-            // Extract one-bit matrix from weight matrix (tmac_operand_i[1])
-            // This is a simplified implementation - implement the actual bit extraction logic
-            for (int i = 0; i < DataWidth; i++) begin
-              weight_matrices_d[current_bit_q][i] = (tmac_operand_i[1][i] >> current_bit_q) & 1'b1;
-            end
-            current_bit_d = current_bit_q + 1;
-          end else begin
-            // All bits processed, move to next state
-            current_bit_d = '0;
-            tmac_state_d = PRECOMPUTE_LUT;
-          end
-          
-          // Acknowledge the weight operand
-          tmac_operand_ready_o[1] = 1'b1;
-        end
-      end
-      
-      PRECOMPUTE_LUT: begin
-        // Check if we have the activation operand
-        if (tmac_operand_valid_i[0]) begin
-          // Precompute the LUT as per the algorithm in the paper
-          // This is simplified - implement the actual precomputation logic
-          for (int i = 0; i < LUTSize; i++) begin
-            lut_d[i] = '0;
-            for (int j = 0; j < GroupSize; j++) begin
-              if (i & (1 << j)) begin
-                // Add activation value to LUT
-                lut_d[i] = lut_d[i] + tmac_operand_i[0];
-              end else begin
-                // Subtract activation value from LUT
-                lut_d[i] = lut_d[i] - tmac_operand_i[0];
-              end
-            end
-          end
-          
-          // Acknowledge the activation operand
-          tmac_operand_ready_o[0] = 1'b1;
-          
-          // Move to next state
-          tmac_state_d = TABLE_LOOKUP;
-        end
-      end
-      
-      TABLE_LOOKUP: begin
-        // Perform table lookup for each bit position
-        if (current_bit_q < WeightBits) begin
-          // Create a result by looking up each group in the LUT
-          elen_t result_temp = '0;
-          
-          // Process groups (simplified implementation)
-          for (int i = 0; i < (DataWidth/GroupSize); i++) begin
-            // Extract the group index from one-bit matrix
-            logic [GroupSize-1:0] group_index;
-            for (int j = 0; j < GroupSize; j++) begin
-              group_index[j] = weight_matrices_q[current_bit_q][i*GroupSize+j];
-            end
-            
-
-            result_temp = result_temp + (lut_q[group_index] << (current_bit_q * DataWidth/GroupSize));
-          end
-          
-          // Store result in the result queue
-          result_queue_d[result_queue_write_pnt_q].wdata = result_temp;
-          result_queue_d[result_queue_write_pnt_q].addr = 
-            vaddr(vinsn_issue_q.vd, NrLanes, VLEN) + current_position_q;
-          result_queue_d[result_queue_write_pnt_q].id = vinsn_issue_q.id;
-          result_queue_d[result_queue_write_pnt_q].be = {StrbWidth{1'b1}}; // All bytes enabled
-          
-          current_bit_d = current_bit_q + 1;
-
-          if (current_bit_d >= WeightBits) begin
-            // Make the result valid
-            result_queue_valid_d[result_queue_write_pnt_q] = 1'b1;
-            
-            // Update result queue pointers
-            result_queue_cnt_d += 1;
-            if (result_queue_write_pnt_q == ResultQueueDepth-1)
-              result_queue_write_pnt_d = 0;
-            else
-              result_queue_write_pnt_d = result_queue_write_pnt_q + 1;
-              
-            tmac_state_d = BIT_AGGREGATION;
-          end
-        end
-      end
-      
-      BIT_AGGREGATION: begin
-        current_position_d = current_position_q + 1;
-        
-        // Reset bit counter
-        current_bit_d = '0;
-        
-        // Check if we've processed all elements
-        if (current_position_d >= issue_cnt_q) begin
-          // Finished processing, go back to idle
-          tmac_state_d = IDLE;
-          
-          // Update counters
-          issue_cnt_d = '0;
-          
+    mask_ready_o         = 1'b0;
+
+    // Inputs to the SIMD units are not valid by default
+    tmac_in_valid = 1'b0;
+
+    // If the result queue is not full, it is ready to accept a result
+    tmac_out_ready = ~result_queue_full;
+
+    operands_valid = (tmac_operand_valid_i[1] || !vinsn_issue_q.use_vs2) &&
+                     (tmac_operand_valid_i[0] || !vinsn_issue_q.use_vd_op) &&
+                     (mask_valid_i || vinsn_issue_q.vm);
+
+    ////////////////////////////////////
+    //  Issue the micro-operations    //
+    ////////////////////////////////////
+
+    // Is there a vector instruction ready to be issued and do we have all its operands?
+    if (operands_valid && vinsn_issue_valid && issue_cnt_q != '0) begin
+      tmac_in_valid = 1'b1;
+
+      if (tmac_in_ready) begin
+        // How many elements are we issuing?
+        automatic logic [3:0] issue_element_cnt =
+          (1 << (int'(EW64) - int'(vinsn_issue_q.vtype.vsew)));
+        if (issue_element_cnt > issue_cnt_q) issue_element_cnt = issue_cnt_q;
+
+        // Acknowledge the operands of this instruction
+        tmac_operand_ready_o = {vinsn_issue_q.use_vs2, vinsn_issue_q.use_vd_op};
+        mask_ready_o         = ~vinsn_issue_q.vm;
+
+        // Update the number of elements still to be issued
+        issue_cnt_d = issue_cnt_q - issue_element_cnt;
+
+        // Finished issuing the micro-operations of this vector instruction
+        if (issue_cnt_d == '0) begin
+          // Bump issue counter and pointers
           vinsn_queue_d.issue_cnt -= 1;
-          if (vinsn_queue_q.issue_pnt == VInsnQueueDepth-1)
-            vinsn_queue_d.issue_pnt = '0;
-          else
-            vinsn_queue_d.issue_pnt = vinsn_queue_q.issue_pnt + 1;
-          
-          // If next instruction is ready, prepare counters
-          if (vinsn_queue_d.issue_cnt != 0)
-            issue_cnt_d = vinsn_queue_q.vinsn[vinsn_queue_d.issue_pnt].vl;
-          
-          // Move to commit phase
-          commit_cnt_d = '0;
-        end else begin
-          // More elements to process, go back to bit decomposition
-          tmac_state_d = BIT_DECOMPOSITION;
+          if (vinsn_queue_q.issue_pnt == VInsnQueueDepth-1) vinsn_queue_d.issue_pnt = '0;
+          else vinsn_queue_d.issue_pnt = vinsn_queue_q.issue_pnt + 1;
+
+          if (vinsn_queue_d.issue_cnt != 0) issue_cnt_d =
+            vinsn_queue_q.vinsn[vinsn_queue_d.issue_pnt].vl;
         end
       end
-      
-      default: tmac_state_d = IDLE;
-    endcase
+    end
+
+    //////////////////////////////
+    //  Write the result queue  //
+    //////////////////////////////
+
+    // Check if we have a valid result and we can add it to the result queue
+    if (tmac_out_valid && !result_queue_full) begin
+      // How many elements have we processed?
+      automatic logic [3:0] processed_element_cnt =
+        (1 << (int'(EW64) - int'(vinsn_processing.vtype.vsew)));
+      if (processed_element_cnt > to_process_cnt_q) processed_element_cnt = to_process_cnt_q;
+
+      // Update the number of elements still to be processed
+      to_process_cnt_d = to_process_cnt_q - processed_element_cnt;
+
+      // Store the result in the result queue
+      result_queue_d[result_queue_write_pnt_q].id    = vinsn_processing.id;
+      result_queue_d[result_queue_write_pnt_q].addr  = vaddr(vinsn_processing.vd, NrLanes, VLEN) +
+        ((vinsn_processing.vl - to_process_cnt_q) >> (int'(EW64) - vinsn_processing.vtype.vsew));
+      result_queue_d[result_queue_write_pnt_q].wdata = tmac_result;
+      result_queue_d[result_queue_write_pnt_q].be    =
+        be(processed_element_cnt, vinsn_processing.vtype.vsew) &
+          (vinsn_processing.vm ? {StrbWidth{1'b1}} : tmac_mask);
+      result_queue_valid_d[result_queue_write_pnt_q] = 1'b1;
+
+      // Bump pointers and counters of the result queue
+      result_queue_cnt_d += 1;
+      if (result_queue_write_pnt_q == ResultQueueDepth-1)
+        result_queue_write_pnt_d = 0;
+      else
+        result_queue_write_pnt_d = result_queue_write_pnt_q + 1;
+
+      // Finished processing the micro-operations of this vector instruction
+      if (to_process_cnt_d == '0) begin
+        vinsn_queue_d.processing_cnt -= 1;
+        if (vinsn_queue_q.processing_pnt == VInsnQueueDepth-1) vinsn_queue_d.processing_pnt = '0;
+        else vinsn_queue_d.processing_pnt = vinsn_queue_q.processing_pnt + 1;
+
+        if (vinsn_queue_d.processing_cnt != 0) to_process_cnt_d =
+          vinsn_queue_q.vinsn[vinsn_queue_d.processing_pnt].vl;
+      end
+    end
 
     //////////////////////////////////
     //  Write results into the VRF  //
     //////////////////////////////////
 
+    tmac_result_req_o   = result_queue_valid_q[result_queue_read_pnt_q];
+    tmac_result_addr_o  = result_queue_q[result_queue_read_pnt_q].addr;
+    tmac_result_id_o    = result_queue_q[result_queue_read_pnt_q].id;
     tmac_result_wdata_o = result_queue_q[result_queue_read_pnt_q].wdata;
-    tmac_result_req_o = result_queue_valid_q[result_queue_read_pnt_q];
-    tmac_result_addr_o = result_queue_q[result_queue_read_pnt_q].addr;
-    tmac_result_id_o   = result_queue_q[result_queue_read_pnt_q].id;
-    tmac_result_be_o   = result_queue_q[result_queue_read_pnt_q].be;
+    tmac_result_be_o    = result_queue_q[result_queue_read_pnt_q].be;
 
     // Received a grant from the VRF.
     // Deactivate the request.
     if (tmac_result_gnt_i) begin
+      // How many elements are we committing?
+      automatic logic [3:0] commit_element_cnt =
+        (1 << (int'(EW64) - int'(vinsn_commit.vtype.vsew)));
+
       result_queue_valid_d[result_queue_read_pnt_q] = 1'b0;
       result_queue_d[result_queue_read_pnt_q]       = '0;
 
       // Increment the read pointer
-      if (result_queue_read_pnt_q == ResultQueueDepth-1) 
+      if (result_queue_read_pnt_q == ResultQueueDepth-1)
         result_queue_read_pnt_d = 0;
-      else 
+      else
         result_queue_read_pnt_d = result_queue_read_pnt_q + 1;
 
       // Decrement the counter of results waiting to be written
       result_queue_cnt_d -= 1;
+
+      // Decrement the counter of remaining vector elements waiting to be written
+      commit_cnt_d = commit_cnt_q - commit_element_cnt;
+      if (commit_cnt_q < commit_element_cnt) commit_cnt_d = '0;
     end
 
     // Finished committing the results of a vector instruction
@@ -367,9 +423,9 @@ module vtmac import ara_pkg::*; import rvv_pkg::*; import cf_math_pkg::idx_width
 
       // Update the commit counters and pointers
       vinsn_queue_d.commit_cnt -= 1;
-      if (vinsn_queue_d.commit_pnt == VInsnQueueDepth-1) 
+      if (vinsn_queue_d.commit_pnt == VInsnQueueDepth-1)
         vinsn_queue_d.commit_pnt = '0;
-      else 
+      else
         vinsn_queue_d.commit_pnt += 1;
 
       // Update the commit counter for the next instruction
@@ -381,20 +437,18 @@ module vtmac import ara_pkg::*; import rvv_pkg::*; import cf_math_pkg::idx_width
     //  Accept new instruction  //
     //////////////////////////////
 
-    if (!vinsn_queue_full && vfu_operation_valid_i && vfu_operation_i.op == TMAC) begin
+    if (!vinsn_queue_full && vfu_operation_valid_i && vfu_operation_i.vfu == VFU_TmacUnit) begin
       vinsn_queue_d.vinsn[vinsn_queue_q.accept_pnt] = vfu_operation_i;
 
       // Initialize counters if the instruction queue was empty
-      if (vinsn_queue_d.issue_cnt == '0) begin
-        issue_cnt_d = vfu_operation_i.vl;
-      end
-      
-      if (vinsn_queue_d.commit_cnt == '0)
-        commit_cnt_d = vfu_operation_i.vl;
+      if (vinsn_queue_d.issue_cnt == '0) issue_cnt_d = vfu_operation_i.vl;
+      if (vinsn_queue_d.processing_cnt == '0) to_process_cnt_d = vfu_operation_i.vl;
+      if (vinsn_queue_d.commit_cnt == '0) commit_cnt_d = vfu_operation_i.vl;
 
       // Bump pointers and counters of the vector instruction queue
       vinsn_queue_d.accept_pnt += 1;
       vinsn_queue_d.issue_cnt += 1;
+      vinsn_queue_d.processing_cnt += 1;
       vinsn_queue_d.commit_cnt += 1;
     end
   end : p_vtmac_control
@@ -402,40 +456,32 @@ module vtmac import ara_pkg::*; import rvv_pkg::*; import cf_math_pkg::idx_width
   // Register the state
   always_ff @(posedge clk_i or negedge rst_ni) begin : p_vtmac_ff
     if (!rst_ni) begin
-      vinsn_queue_q         <= '0;
-      vinsn_issue_q         <= '0;
-      
+      vinsn_queue_q            <= '0;
+      vinsn_issue_q            <= '0;
+
       result_queue_q           <= '0;
       result_queue_valid_q     <= '0;
       result_queue_write_pnt_q <= '0;
       result_queue_read_pnt_q  <= '0;
       result_queue_cnt_q       <= '0;
-      
-      issue_cnt_q         <= '0;
-      commit_cnt_q        <= '0;
-      tmac_state_q        <= IDLE;
-      lut_q               <= '0;
-      weight_matrices_q   <= '0;
-      current_bit_q       <= '0;
-      current_position_q  <= '0;
+
+      issue_cnt_q              <= '0;
+      to_process_cnt_q         <= '0;
+      commit_cnt_q             <= '0;
     end else begin
-      vinsn_queue_q         <= vinsn_queue_d;
-      vinsn_issue_q         <= vinsn_issue_d;
-      
+      vinsn_queue_q            <= vinsn_queue_d;
+      vinsn_issue_q            <= vinsn_issue_d;
+
       result_queue_q           <= result_queue_d;
       result_queue_valid_q     <= result_queue_valid_d;
       result_queue_write_pnt_q <= result_queue_write_pnt_d;
       result_queue_read_pnt_q  <= result_queue_read_pnt_d;
       result_queue_cnt_q       <= result_queue_cnt_d;
-      
-      issue_cnt_q         <= issue_cnt_d;
-      commit_cnt_q        <= commit_cnt_d;
-      tmac_state_q        <= tmac_state_d;
-      lut_q               <= lut_d;
-      weight_matrices_q   <= weight_matrices_d;
-      current_bit_q       <= current_bit_d;
-      current_position_q  <= current_position_d;
+
+      issue_cnt_q              <= issue_cnt_d;
+      to_process_cnt_q         <= to_process_cnt_d;
+      commit_cnt_q             <= commit_cnt_d;
     end
   end : p_vtmac_ff
 
-endmodule : vtmac
\ No newline at end of file
+endmodule : vtmac
@@ -0,0 +1,69 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description: Host-side console.
+//              The software writes whole strings to the console window with
+//              vector stores (apps/common/serial.c). The W beats of Ara are
+//              snooped, and the bytes that fall into the window are printed
+//              by tb/dpi/console.cc. The stores themselves are completed by
+//              the UART port of the SoC, see ara_testharness.
+
+module ara_console #(
+    parameter int unsigned     AxiDataWidth = 0,
+    parameter logic     [63:0] Base         = '0,
+    parameter logic     [63:0] Length       = '0,
+    // Dependant parameters. DO NOT CHANGE!
+    localparam int unsigned    StrbWidth    = AxiDataWidth / 8
+  ) (
+    input logic                    clk_i,
+    input logic                    rst_ni,
+    // Ara's AW channel
+    input logic             [63:0] aw_addr_i,
+    input axi_pkg::len_t           aw_len_i,
+    input axi_pkg::size_t          aw_size_i,
+    input axi_pkg::burst_t         aw_burst_i,
+    input logic                    aw_valid_i,
+    input logic                    aw_ready_i,
+    // Ara's W channel
+    input logic [AxiDataWidth-1:0] w_data_i,
+    input logic [StrbWidth-1:0]    w_strb_i,
+    input logic                    w_last_i,
+    input logic                    w_valid_i,
+    input logic                    w_ready_i
+  );
+
+  // The console is referred to with an integer handle, 0 if it could not be
+  // opened, so that it survives the checkpoints of the Verilator model
+  import "DPI-C" function int console_open(input int beat_bytes, input longint base,
+    input longint length);
+  import "DPI-C" function void console_aw(input int console, input longint addr, input int len,
+    input int size, input int burst);
+  import "DPI-C" function void console_w(input int console,
+    input bit [AxiDataWidth-1:0] data, input bit [StrbWidth-1:0] strb, input bit last);
+  import "DPI-C" function void console_reset(input int console);
+  import "DPI-C" function void console_close(input int console);
+
+  int console;
+
+  initial console = console_open(StrbWidth, Base, Length);
+
+  final begin
+    if (console != 0) console_close(console);
+  end
+
+  // All the bursts are tracked to know the addresses of the beats. A reset, e.g.
+  // between the tests of a batch run, drops the bursts in flight.
+  always_ff @(posedge clk_i)
+    if (console != 0) begin
+      if (!rst_ni)
+        console_reset(console);
+      else begin
+        if (aw_valid_i && aw_ready_i)
+          console_aw(console, aw_addr_i, aw_len_i, aw_size_i, aw_burst_i);
+        if (w_valid_i && w_ready_i)
+          console_w(console, w_data_i, w_strb_i, w_last_i);
+      end
+    end
+
+endmodule : ara_console
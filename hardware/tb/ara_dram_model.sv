@@ -0,0 +1,146 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description: DRAM timing model of the L2 memory.
+//              Sits between axi_to_mem and the L2 SRAM, and delays the grants
+//              and the responses as decided by the C++ model in
+//              tb/dpi/dram_model.cc. The SRAM is accessed on the grant, and its
+//              data is buffered until the response is returned.
+//
+//              The timing is configured with plusargs (default in brackets):
+//                +dram_outstanding=N  requests in flight [MaxOutstanding]
+//                +dram_latency=N      controller latency [cycles] [20]
+//                +dram_bandwidth=R    data bus bandwidth [bytes/cycle] [16]
+//                +dram_banks=N        number of banks [16]
+//                +dram_row_size=N     row size [bytes] [2048]
+//                +dram_t_cas=N        column access time [cycles] [14]
+//                +dram_t_rcd=N        row activation time [cycles] [14]
+//                +dram_t_rp=N         precharge time [cycles] [14]
+
+module ara_dram_model #(
+    parameter int unsigned DataWidth      = 0,
+    parameter int unsigned AddrWidth      = 0,
+    // Upper bound of +dram_outstanding
+    parameter int unsigned MaxOutstanding = 16,
+    // Dependant parameters. DO NOT CHANGE!
+    localparam type        data_t         = logic [DataWidth-1:0],
+    localparam type        addr_t         = logic [AddrWidth-1:0]
+  ) (
+    input  logic  clk_i,
+    input  logic  rst_ni,
+    // From axi_to_mem
+    input  logic  req_i,
+    input  logic  we_i,
+    input  addr_t addr_i,
+    output logic  gnt_o,
+    output data_t rdata_o,
+    output logic  rvalid_o,
+    // From the SRAM, one cycle after the grant
+    input  data_t sram_rdata_i
+  );
+
+  `include "common_cells/registers.svh"
+
+  // The model is referred to with an integer handle, 0 if it could not be
+  // created, so that it survives the checkpoints of the Verilator model
+  import "DPI-C" function int dram_model_init(input int word_bytes, input int max_outstanding,
+    input int latency, input real bandwidth, input int banks, input int row_bytes, input int t_cas,
+    input int t_rcd, input int t_rp);
+  import "DPI-C" function void dram_model_reset(input int model);
+  import "DPI-C" function void dram_model_clock(input int model, input bit req, input bit gnt,
+    input bit we, input longint addr, output bit gnt_next, output bit rvalid_next);
+  import "DPI-C" function void dram_model_final(input int model);
+
+  /*******************
+   *  Configuration  *
+   *******************/
+
+  int model = 0;
+
+  initial begin
+    automatic int  outstanding = MaxOutstanding;
+    automatic int  latency     = 20;
+    automatic real bandwidth   = 16.0;
+    automatic int  banks       = 16;
+    automatic int  row_size    = 2048;
+    automatic int  t_cas       = 14;
+    automatic int  t_rcd       = 14;
+    automatic int  t_rp        = 14;
+
+    void'($value$plusargs("dram_outstanding=%d", outstanding));
+    void'($value$plusargs("dram_latency=%d", latency));
+    void'($value$plusargs("dram_bandwidth=%f", bandwidth));
+    void'($value$plusargs("dram_banks=%d", banks));
+    void'($value$plusargs("dram_row_size=%d", row_size));
+    void'($value$plusargs("dram_t_cas=%d", t_cas));
+    void'($value$plusargs("dram_t_rcd=%d", t_rcd));
+    void'($value$plusargs("dram_t_rp=%d", t_rp));
+
+    if (outstanding > MaxOutstanding) begin
+      $warning("[DRAM] +dram_outstanding=%0d exceeds MaxOutstanding, using %0d", outstanding,
+        MaxOutstanding);
+      outstanding = MaxOutstanding;
+    end
+
+    model = dram_model_init(DataWidth/8, outstanding, latency, bandwidth, banks, row_size, t_cas,
+      t_rcd, t_rp);
+    if (model == 0)
+      $fatal(1, "[DRAM] Could not create the timing model");
+  end
+
+  final begin
+    if (model != 0) dram_model_final(model);
+  end
+
+  /************
+   *  Timing  *
+   ************/
+
+  logic gnt_q, rvalid_q;
+
+  assign gnt_o    = req_i & gnt_q;
+  assign rvalid_o = rvalid_q;
+
+  always_ff @(posedge clk_i or negedge rst_ni) begin
+    if (!rst_ni) begin
+      gnt_q    <= 1'b0;
+      rvalid_q <= 1'b0;
+      if (model != 0) dram_model_reset(model);
+    end else if (model != 0) begin
+      automatic bit gnt_next, rvalid_next;
+      dram_model_clock(model, req_i, gnt_o, we_i, addr_i, gnt_next, rvalid_next);
+      gnt_q    <= gnt_next;
+      rvalid_q <= rvalid_next;
+    end
+  end
+
+  /*********************
+   *  Response buffer  *
+   *********************/
+
+  // The data of every granted request, returned in order. Writes are buffered
+  // as well, since axi_to_mem expects a response for them.
+  logic granted_q;
+
+  `FF(granted_q, gnt_o, 1'b0, clk_i, rst_ni)
+
+  fifo_v3 #(
+    .FALL_THROUGH(1'b1          ),
+    .DEPTH       (MaxOutstanding),
+    .dtype       (data_t        )
+  ) i_resp_buffer (
+    .clk_i     (clk_i       ),
+    .rst_ni    (rst_ni      ),
+    .flush_i   (1'b0        ),
+    .testmode_i(1'b0        ),
+    .full_o    (/* Unused */),
+    .empty_o   (/* Unused */),
+    .usage_o   (/* Unused */),
+    .data_i    (sram_rdata_i),
+    .push_i    (granted_q   ),
+    .data_o    (rdata_o     ),
+    .pop_i     (rvalid_o    )
+  );
+
+endmodule : ara_dram_model
@@ -0,0 +1,245 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description: Pipeline tracer for the vector instructions.
+//              Logs the lifecycle of every vector instruction in the Kanata
+//              format of the Konata pipeline visualizer. Enabled by the
+//              +konata_trace=FILE plusarg.
+//
+//              Stages (Konata lane 0):
+//                Ds: waiting in the dispatcher for the sequencer
+//                Sq: issued by the sequencer, waiting for the lanes
+//                Ex: running in the lanes and functional units
+//              Stages (Konata lane 1):
+//                Hz: waiting for an older instruction (global hazard table)
+//              The lane start and the completion of each processing element are
+//              annotated on the instruction.
+
+module ara_konata_tracer import ara_pkg::*; import rvv_pkg::*; #(
+    parameter  int unsigned NrLanes = 0,
+    // The lanes, and the load, store, mask, slide and TMAC units
+    localparam int unsigned NrPEs   = NrLanes + 5
+  ) (
+    input logic                                clk_i,
+    input logic                                rst_ni,
+    // Request from the dispatcher to the sequencer
+    input logic                                ara_req_valid_i,
+    input logic                                ara_req_ready_i,
+    input ara_op_e                             ara_req_op_i,
+    input logic          [4:0]                 ara_req_vd_i,
+    input logic          [4:0]                 ara_req_vs1_i,
+    input logic          [4:0]                 ara_req_vs2_i,
+    input logic                                ara_req_use_vd_i,
+    input logic                                ara_req_use_vs1_i,
+    input logic                                ara_req_use_vs2_i,
+    input logic          [31:0]                ara_req_vl_i,
+    input vew_e                                ara_req_vsew_i,
+    // Sequencer
+    input logic          [NrPEs-1:0][NrVInsn-1:0]   pe_vinsn_running_i,
+    input logic          [NrVInsn-1:0][NrVInsn-1:0] global_hazard_table_i,
+    // Lane sequencers
+    input logic          [NrLanes-1:0]         lane_pe_req_valid_i,
+    input logic          [NrLanes-1:0]         lane_pe_req_ready_i,
+    input vid_t          [NrLanes-1:0]         lane_pe_req_id_i
+  );
+
+  /***********
+   *  Setup  *
+   ***********/
+
+  int    fd = 0;
+  string path;
+
+  initial begin
+    if ($value$plusargs("konata_trace=%s", path)) begin
+      fd = $fopen(path, "w");
+      if (fd == 0)
+        $error("[Konata] Could not open %s", path);
+      else
+        $fwrite(fd, "Kanata\t0004\nC=\t0\n");
+    end
+  end
+
+  final begin
+    if (fd != 0) $fclose(fd);
+  end
+
+  /***********
+   *  State  *
+   ***********/
+
+  // Current cycle, and cycle of the last line written to the trace
+  longint unsigned cycle = 0, trace_cycle = 0;
+  // Konata ID of the next instruction, and retire ID of the next retirement
+  int unsigned     next_id = 0, next_retire = 0;
+  // Instruction requested by the dispatcher until the sequencer acknowledges
+  // it, -1 if none. Memory operations are issued before the acknowledgment.
+  int              dispatch_id;
+  // Instruction dispatched but not yet seen running, -1 if none
+  int              unissued_id;
+  // Was unissued_id accepted by the sequencer in the previous cycle?
+  logic            accepted_q;
+  // Konata ID of every vector instruction ID
+  int              vinsn_kid [NrVInsn];
+  // Has the instruction started in a lane? Is it stalled by a hazard?
+  logic [NrVInsn-1:0] started_q, hazard_q;
+
+  logic [NrPEs-1:0][NrVInsn-1:0] pe_vinsn_running_q;
+  logic [NrVInsn-1:0]            vinsn_running, vinsn_running_q;
+
+  always_comb begin
+    vinsn_running = '0;
+    for (int pe = 0; pe < NrPEs; pe++) vinsn_running |= pe_vinsn_running_i[pe];
+  end
+
+  /*************
+   *  Helpers  *
+   *************/
+
+  // Move the trace to the current cycle
+  task automatic sync_cycle();
+    if (cycle != trace_cycle) begin
+      $fwrite(fd, "C\t%0d\n", cycle - trace_cycle);
+      trace_cycle = cycle;
+    end
+  endtask
+
+  task automatic stage_start(int id, int lane, string stage);
+    sync_cycle();
+    $fwrite(fd, "S\t%0d\t%0d\t%s\n", id, lane, stage);
+  endtask
+
+  task automatic stage_end(int id, int lane, string stage);
+    sync_cycle();
+    $fwrite(fd, "E\t%0d\t%0d\t%s\n", id, lane, stage);
+  endtask
+
+  // Add a line to the detail (hover) text of an instruction
+  task automatic annotate(int id, string text);
+    sync_cycle();
+    $fwrite(fd, "L\t%0d\t1\t%s; \n", id, text);
+  endtask
+
+  task automatic retire(int id, bit flush);
+    sync_cycle();
+    $fwrite(fd, "R\t%0d\t%0d\t%0d\n", id, next_retire, flush);
+    next_retire++;
+  endtask
+
+  function automatic string pe_name(int pe);
+    if (pe < NrLanes) return $sformatf("lane %0d", pe);
+    case (pe - NrLanes)
+      OffsetLoad : return "VLDU";
+      OffsetStore: return "VSTU";
+      OffsetMask : return "MASKU";
+      OffsetSlide: return "SLDU";
+      OffsetTmac : return "VTMAC";
+      default    : return "?";
+    endcase
+  endfunction
+
+  /************
+   *  Tracer  *
+   ************/
+
+  always @(posedge clk_i) begin
+    if (!rst_ni) begin
+      dispatch_id        = -1;
+      unissued_id        = -1;
+      accepted_q         = 1'b0;
+      started_q          = '0;
+      hazard_q           = '0;
+      pe_vinsn_running_q = '0;
+      vinsn_running_q    = '0;
+    end else if (fd != 0) begin
+      // Completion of each processing element, and of the whole instruction
+      for (int id = 0; id < NrVInsn; id++) begin
+        if (!vinsn_running_q[id]) continue;
+        for (int pe = 0; pe < NrPEs; pe++)
+          if (pe_vinsn_running_q[pe][id] && !pe_vinsn_running_i[pe][id])
+            annotate(vinsn_kid[id], $sformatf("%s done @ %0d", pe_name(pe), cycle));
+        if (!vinsn_running[id]) begin
+          if (hazard_q[id]) stage_end(vinsn_kid[id], 1, "Hz");
+          stage_end(vinsn_kid[id], 0, started_q[id] ? "Ex" : "Sq");
+          retire(vinsn_kid[id], 1'b0);
+          started_q[id] = 1'b0;
+          hazard_q[id]  = 1'b0;
+        end
+      end
+
+      // Issue: the sequencer marks the instruction as running
+      for (int id = 0; id < NrVInsn; id++) begin
+        if (vinsn_running[id] && !vinsn_running_q[id] && unissued_id != -1) begin
+          vinsn_kid[id] = unissued_id;
+          unissued_id   = -1;
+          stage_end(vinsn_kid[id], 0, "Ds");
+          stage_start(vinsn_kid[id], 0, "Sq");
+          annotate(vinsn_kid[id], $sformatf("vinsn_id %0d", id));
+        end
+      end
+
+      // The sequencer accepted the request without issuing it
+      if (accepted_q && unissued_id != -1) begin
+        stage_end(unissued_id, 0, "Ds");
+        annotate(unissued_id, "not issued");
+        retire(unissued_id, 1'b1);
+        unissued_id = -1;
+      end
+
+      // Start in the lanes
+      for (int l = 0; l < NrLanes; l++) begin
+        automatic int id = lane_pe_req_id_i[l];
+        if (lane_pe_req_valid_i[l] && lane_pe_req_ready_i[l] && vinsn_running[id]) begin
+          annotate(vinsn_kid[id], $sformatf("lane %0d start @ %0d", l, cycle));
+          if (!started_q[id]) begin
+            stage_end(vinsn_kid[id], 0, "Sq");
+            stage_start(vinsn_kid[id], 0, "Ex");
+            started_q[id] = 1'b1;
+          end
+        end
+      end
+
+      // Hazards on older instructions, shown as dependency arrows
+      for (int id = 0; id < NrVInsn; id++) begin
+        automatic logic hazard = vinsn_running[id] && |global_hazard_table_i[id];
+        if (hazard && !hazard_q[id]) begin
+          stage_start(vinsn_kid[id], 1, "Hz");
+          for (int dep = 0; dep < NrVInsn; dep++)
+            if (global_hazard_table_i[id][dep] && vinsn_running[dep])
+              $fwrite(fd, "W\t%0d\t%0d\t0\n", vinsn_kid[id], vinsn_kid[dep]);
+        end else if (!hazard && hazard_q[id]) begin
+          stage_end(vinsn_kid[id], 1, "Hz");
+        end
+        hazard_q[id] = hazard;
+      end
+
+      // New request from the dispatcher
+      if (ara_req_valid_i && dispatch_id == -1) begin
+        dispatch_id = next_id;
+        unissued_id = next_id;
+        next_id++;
+        sync_cycle();
+        $fwrite(fd, "I\t%0d\t%0d\t0\n", dispatch_id, dispatch_id);
+        $fwrite(fd, "L\t%0d\t0\t%s", dispatch_id, ara_req_op_i.name());
+        if (ara_req_use_vd_i)  $fwrite(fd, " v%0d", ara_req_vd_i);
+        if (ara_req_use_vs2_i) $fwrite(fd, " v%0d", ara_req_vs2_i);
+        if (ara_req_use_vs1_i) $fwrite(fd, " v%0d", ara_req_vs1_i);
+        $fwrite(fd, " (vl %0d, %s)\n", ara_req_vl_i, ara_req_vsew_i.name());
+        stage_start(dispatch_id, 0, "Ds");
+      end
+
+      // Handshake with the sequencer
+      accepted_q = 1'b0;
+      if (ara_req_valid_i && ara_req_ready_i) begin
+        accepted_q  = unissued_id == dispatch_id;
+        dispatch_id = -1;
+      end
+
+      pe_vinsn_running_q = pe_vinsn_running_i;
+      vinsn_running_q    = vinsn_running;
+    end
+    cycle++;
+  end
+
+endmodule : ara_konata_tracer
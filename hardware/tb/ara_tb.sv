@@ -35,6 +35,12 @@ module ara_tb;
   localparam VLEN = 0;
   `endif
 
+  `ifdef DRAM_MODEL
+  localparam DramModel = 1'b1;
+  `else
+  localparam DramModel = 1'b0;
+  `endif
+
   localparam ClockPeriod  = 1ns;
   // Axi response delay [ps]
   localparam int unsigned AxiRespDelay = 200;
@@ -87,7 +93,8 @@ module ara_tb;
     .VLEN        (VLEN            ),
     .AxiAddrWidth(AxiAddrWidth    ),
     .AxiDataWidth(AxiWideDataWidth),
-    .AxiRespDelay(AxiRespDelay    )
+    .AxiRespDelay(AxiRespDelay    ),
+    .DramModel   (DramModel       )
   ) dut (
     .clk_i (clk  ),
     .rst_ni(rst_n),
@@ -102,9 +109,12 @@ module ara_tb;
   typedef logic [AxiAddrWidth-1:0] addr_t;
   typedef logic [AxiWideDataWidth-1:0] data_t;
 
+  // Write a whole section into the DRAM with a single call. The bytes around an
+  // unaligned section keep their value.
+  import "DPI-C" function byte load_section(input longint address, input longint mem_base,
+    input int word_bytes, inout logic [AxiWideDataWidth-1:0] mem[]);
+
   initial begin : dram_init
-    automatic data_t mem_row;
-    byte buffer [];
     addr_t address;
     addr_t length;
     string binary;
@@ -120,24 +130,12 @@ module ara_tb;
       read_elf(binary);
       $display("Loading ELF file %s", binary);
       while (get_section(address, length)) begin
-        // Read sections
-        automatic int nwords = (length + AxiWideBeWidth - 1)/AxiWideBeWidth;
         $display("Loading section %x of length %x", address, length);
-        buffer = new[nwords * AxiWideBeWidth];
-        void'(read_section(address, buffer));
-        // Initializing memories
-        for (int w = 0; w < nwords; w++) begin
-          mem_row = '0;
-          for (int b = 0; b < AxiWideBeWidth; b++) begin
-            mem_row[8 * b +: 8] = buffer[w * AxiWideBeWidth + b];
-          end
-          if (address >= DRAMAddrBase && address < DRAMAddrBase + DRAMLength)
-            // This requires the sections to be aligned to AxiWideByteOffset,
-            // otherwise, they can be over-written.
-            dut.i_ara_soc.i_dram.init_val[(address - DRAMAddrBase + (w << AxiWideByteOffset)) >> AxiWideByteOffset] = mem_row;
-          else
-            $display("Cannot initialize address %x, which doesn't fall into the L2 region.", address);
-        end
+        if (address >= DRAMAddrBase && address + length <= DRAMAddrBase + DRAMLength) begin
+          if (!load_section(address, DRAMAddrBase, AxiWideBeWidth, dut.i_ara_soc.i_dram.init_val))
+            $error("Cannot initialize section %x", address);
+        end else
+          $display("Cannot initialize address %x, which doesn't fall into the L2 region.", address);
       end
     end else begin
       $error("Expecting a firmware to run, none was provided!");
@@ -147,22 +145,39 @@ module ara_tb;
 
 `ifndef TARGET_GATESIM
 
-  /*************************
-   *  PRINT STORED VALUES  *
-   *************************/
+  /***************************
+   *  CAPTURE STORED VALUES  *
+   ***************************/
 
-  // This is useful to check that the ideal dispatcher simulation was correct
+  // This is useful to check that the ideal dispatcher simulation was correct.
+  // The strobed bytes of Ara's W beats are captured, with their addresses, by
+  // tb/dpi/result_sink.cc. Compare the captures with scripts/compare_results.py.
 
 `ifndef IDEAL_DISPATCHER
-  localparam OutResultFile = "../gold_results.txt";
+  localparam OutResultFile = "../gold_results.bin";
 `else
-  localparam OutResultFile = "../id_results.txt";
+  localparam OutResultFile = "../id_results.bin";
 `endif
 
-  int fd;
-
+  import "DPI-C" function chandle result_sink_open(input string path, input int beat_bytes);
+  import "DPI-C" function void result_sink_aw(input chandle sink, input longint addr, input int len,
+    input int size, input int burst);
+  import "DPI-C" function void result_sink_w(input chandle sink,
+    input bit [AxiWideDataWidth-1:0] data, input bit [AxiWideBeWidth-1:0] strb, input bit last,
+    input bit record);
+  import "DPI-C" function void result_sink_close(input chandle sink);
+
+  chandle result_sink;
+
+  axi_pkg::len_t             ara_aw_len;
+  axi_pkg::size_t            ara_aw_size;
+  axi_pkg::burst_t           ara_aw_burst;
+  addr_t                     ara_aw_addr;
+  logic                      ara_aw_valid;
+  logic                      ara_aw_ready;
   data_t                     ara_w;
   logic [AxiWideBeWidth-1:0] ara_w_strb;
+  logic                      ara_w_last;
   logic                      ara_w_valid;
   logic                      ara_w_ready;
 
@@ -170,14 +185,21 @@ module ara_tb;
   logic dump_en_mask;
 
   initial begin
-    fd = $fopen(OutResultFile, "w");
+    result_sink = result_sink_open(OutResultFile, AxiWideBeWidth);
     $display("Dump results on %s", OutResultFile);
   end
 
-  assign ara_w       = dut.i_ara_soc.i_system.i_ara.i_vlsu.axi_req.w.data;
-  assign ara_w_strb  = dut.i_ara_soc.i_system.i_ara.i_vlsu.axi_req.w.strb;
-  assign ara_w_valid = dut.i_ara_soc.i_system.i_ara.i_vlsu.axi_req.w_valid;
-  assign ara_w_ready = dut.i_ara_soc.i_system.i_ara.i_vlsu.axi_resp.w_ready;
+  assign ara_aw_addr  = dut.i_ara_soc.i_system.i_ara.i_vlsu.axi_req.aw.addr;
+  assign ara_aw_len   = dut.i_ara_soc.i_system.i_ara.i_vlsu.axi_req.aw.len;
+  assign ara_aw_size  = dut.i_ara_soc.i_system.i_ara.i_vlsu.axi_req.aw.size;
+  assign ara_aw_burst = dut.i_ara_soc.i_system.i_ara.i_vlsu.axi_req.aw.burst;
+  assign ara_aw_valid = dut.i_ara_soc.i_system.i_ara.i_vlsu.axi_req.aw_valid;
+  assign ara_aw_ready = dut.i_ara_soc.i_system.i_ara.i_vlsu.axi_resp.aw_ready;
+  assign ara_w        = dut.i_ara_soc.i_system.i_ara.i_vlsu.axi_req.w.data;
+  assign ara_w_strb   = dut.i_ara_soc.i_system.i_ara.i_vlsu.axi_req.w.strb;
+  assign ara_w_last   = dut.i_ara_soc.i_system.i_ara.i_vlsu.axi_req.w.last;
+  assign ara_w_valid  = dut.i_ara_soc.i_system.i_ara.i_vlsu.axi_req.w_valid;
+  assign ara_w_ready  = dut.i_ara_soc.i_system.i_ara.i_vlsu.axi_resp.w_ready;
 
 `ifndef IDEAL_DISPATCHER
   assign dump_en_mask = dut.i_ara_soc.hw_cnt_en_o[0];
@@ -185,12 +207,15 @@ module ara_tb;
   // Ideal-Dispatcher system does not warm the scalar cache
   assign dump_en_mask = 1'b1;
 `endif
+  // All the bursts are tracked to know the addresses, but only the beats
+  // within the measured region are captured
   always_ff @(posedge clk)
-    if (dump_en_mask)
+    if (result_sink != null) begin
+      if (ara_aw_valid && ara_aw_ready)
+        result_sink_aw(result_sink, ara_aw_addr, ara_aw_len, ara_aw_size, ara_aw_burst);
       if (ara_w_valid && ara_w_ready)
-        for (int b = 0; b < AxiWideBeWidth; b++)
-          if (ara_w_strb[b])
-            $fdisplay(fd, "%0x", ara_w[b*8 +: 8]);
+        result_sink_w(result_sink, ara_w, ara_w_strb, ara_w_last, dump_en_mask);
+    end
 
 `endif
 
@@ -214,7 +239,7 @@ module ara_tb;
       end
 
 `ifndef TARGET_GATESIM
-      $fclose(fd);
+      if (result_sink != null) result_sink_close(result_sink);
 `endif
       $finish(exit >> 1);
     end
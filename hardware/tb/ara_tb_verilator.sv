@@ -7,12 +7,35 @@
 // Description: Top level testbench module for Verilator.
 
 module ara_tb_verilator #(
-    parameter int unsigned NrLanes = 0,
-    parameter int unsigned VLEN    = 0
+    parameter int unsigned NrLanes   = 0,
+    parameter int unsigned VLEN      = 0,
+    // Use the DRAM timing model for the L2 memory
+    parameter bit          DramModel = 1'b0
   )(
     input  logic        clk_i,
     input  logic        rst_ni,
-    output logic [63:0] exit_o
+    output logic [63:0] exit_o,
+    // Software event trigger, sampled by the C++ simulation controller
+    output logic [63:0] event_trigger_o,
+    // Performance events, sampled by the C++ performance counters
+    output logic [63:0] perf_events_o,
+    // AXI traffic, sampled by the C++ AXI monitor: Ara's port (VLSU), the
+    // crossbar input (CVA6 and Ara) and the crossbar output to the L2
+    output logic [63:0] axi_probe_vlsu_o,
+    output logic [63:0] axi_probe_system_o,
+    output logic [63:0] axi_probe_l2_o,
+    // Instructions retired by CVA6 and state of Ara, sampled by the C++
+    // co-simulation with Spike
+    output logic [63:0] cosim_commit_o,
+    output logic [63:0] cosim_pc0_o,
+    output logic [63:0] cosim_pc1_o,
+    output logic [63:0] cosim_wdata0_o,
+    output logic [63:0] cosim_wdata1_o,
+    output logic [63:0] cosim_ara_o,
+    output logic [63:0] cosim_vrf_eew_o,
+    // State of the sequencer and of the lanes, sampled by the C++ watchdog
+    output logic [63:0] watchdog_ara_o,
+    output logic [63:0] watchdog_lanes_o
   );
 
   /*****************
@@ -30,13 +53,216 @@ module ara_tb_verilator #(
     .NrLanes     (NrLanes         ),
     .VLEN        (VLEN            ),
     .AxiAddrWidth(AxiAddrWidth    ),
-    .AxiDataWidth(AxiWideDataWidth)
+    .AxiDataWidth(AxiWideDataWidth),
+    .DramModel   (DramModel       )
   ) dut (
     .clk_i (clk_i ),
     .rst_ni(rst_ni),
     .exit_o(exit_o)
   );
 
+  assign event_trigger_o = dut.i_ara_soc.event_trigger;
+
+  /************************
+   *  Performance events  *
+   ************************/
+
+  // One bit per event, counted by the C++ performance counters on every cycle
+  // it is set. The bit positions must match kPerfEventNames in
+  // tb/verilator/perf_counters.cc. Lane events are taken from lane 0, since
+  // all the lanes work on the same instructions.
+
+`define ARA dut.i_ara_soc.i_system.i_ara
+`define LANE0 `ARA.gen_lanes[0].i_lane
+
+  // An operand requester of lane 0 lost the arbitration for a VRF bank
+  logic lane0_vrf_bank_conflict;
+  always_comb begin
+    lane0_vrf_bank_conflict = 1'b0;
+    for (int b = 0; b < ara_pkg::NrVRFBanksPerLane; b++)
+      lane0_vrf_bank_conflict |= |(`LANE0.i_operand_requester.lane_operand_req[b] &
+        ~`LANE0.i_operand_requester.operand_gnt[b][ara_pkg::NrOperandQueues-1:0]);
+  end
+
+  // Operand requesters of lane 0 blocked by a full operand queue, or by a hazard
+  logic [ara_pkg::NrOperandQueues-1:0] lane0_opqueue_full, lane0_opreq_hazard;
+  for (genvar r = 0; r < ara_pkg::NrOperandQueues; r++) begin: gen_lane0_opreq_events
+    logic requesting;
+    assign requesting = `LANE0.i_operand_requester.gen_operand_requester[r].state_q != '0;
+    assign lane0_opqueue_full[r] = requesting &&
+      !`LANE0.i_operand_requester.operand_queue_ready_i[r];
+    assign lane0_opreq_hazard[r] = requesting &&
+      `LANE0.i_operand_requester.operand_queue_ready_i[r] &&
+      `LANE0.i_operand_requester.gen_operand_requester[r].stall;
+  end: gen_lane0_opreq_events
+
+  always_comb begin
+    perf_events_o = '0;
+    // Sequencer
+    perf_events_o[0]  = !`ARA.ara_idle;
+    perf_events_o[1]  = |`ARA.i_sequencer.vinsn_running_q;
+    perf_events_o[2]  = `ARA.i_sequencer.accepted_insn_stalled;
+    perf_events_o[3]  = `ARA.i_sequencer.stall_lanes_desynch;
+    perf_events_o[4]  = |`ARA.i_sequencer.global_hazard_table_o;
+    // Functional units
+    perf_events_o[5]  = `LANE0.i_vfus.i_valu.vinsn_issue_valid;
+    perf_events_o[6]  = `LANE0.i_vfus.i_vmfpu.vinsn_issue_q_valid;
+    perf_events_o[7]  = `LANE0.i_vfus.i_vtmac.vinsn_issue_valid;
+    perf_events_o[8]  = |`ARA.i_sequencer.pe_vinsn_running_q[NrLanes + ara_pkg::OffsetLoad];
+    perf_events_o[9]  = |`ARA.i_sequencer.pe_vinsn_running_q[NrLanes + ara_pkg::OffsetStore];
+    perf_events_o[10] = |`ARA.i_sequencer.pe_vinsn_running_q[NrLanes + ara_pkg::OffsetMask];
+    perf_events_o[11] = |`ARA.i_sequencer.pe_vinsn_running_q[NrLanes + ara_pkg::OffsetSlide];
+    // Lane 0 operand fetch
+    perf_events_o[12] = lane0_vrf_bank_conflict;
+    perf_events_o[13] = |lane0_opqueue_full;
+    perf_events_o[14] = |lane0_opreq_hazard;
+    // AXI handshakes (AR/AW) and beats (R/W) of Ara
+    perf_events_o[15] = `ARA.axi_req_o.ar_valid && `ARA.axi_resp_i.ar_ready;
+    perf_events_o[16] = `ARA.axi_resp_i.r_valid && `ARA.axi_req_o.r_ready;
+    perf_events_o[17] = `ARA.axi_req_o.aw_valid && `ARA.axi_resp_i.aw_ready;
+    perf_events_o[18] = `ARA.axi_req_o.w_valid && `ARA.axi_resp_i.w_ready;
+`ifndef IDEAL_DISPATCHER
+    // CVA6
+    perf_events_o[19] = dut.i_ara_soc.i_system.i_ariane.gen_perf_counter.perf_counters_i.l1_dcache_miss_i;
+    perf_events_o[20] = dut.i_ara_soc.i_system.i_ariane.gen_perf_counter.perf_counters_i.l1_icache_miss_i;
+    perf_events_o[21] = dut.i_ara_soc.i_system.i_ariane.gen_perf_counter.perf_counters_i.sb_full_i;
+`endif
+  end
+
+  /*****************
+   *  AXI traffic  *
+   *****************/
+
+  // Handshakes, burst lengths and IDs of one AXI port, packed as expected by
+  // tb/verilator/axi_monitor.cc
+`define AXI_PROBE(probe, req, resp)                  \
+  always_comb begin                                   \
+    probe        = '0;                                \
+    probe[0]     = req.ar_valid && resp.ar_ready;     \
+    probe[1]     = resp.r_valid && req.r_ready;       \
+    probe[2]     = resp.r.last;                       \
+    probe[3]     = req.aw_valid && resp.aw_ready;     \
+    probe[4]     = req.w_valid && resp.w_ready;       \
+    probe[5]     = req.w.last;                        \
+    probe[6]     = resp.b_valid && req.b_ready;       \
+    probe[15:8]  = req.ar.len;                        \
+    probe[23:16] = req.aw.len;                        \
+    probe[31:24] = req.ar.id;                         \
+    probe[39:32] = resp.r.id;                         \
+    probe[47:40] = req.aw.id;                         \
+    probe[55:48] = resp.b.id;                         \
+    probe[56]    = req.ar_valid && !resp.ar_ready;    \
+    probe[57]    = resp.r_valid && !req.r_ready;      \
+    probe[58]    = req.aw_valid && !resp.aw_ready;    \
+    probe[59]    = req.w_valid && !resp.w_ready;      \
+  end
+
+  `AXI_PROBE(axi_probe_vlsu_o, `ARA.axi_req_o, `ARA.axi_resp_i)
+  `AXI_PROBE(axi_probe_system_o, dut.i_ara_soc.system_axi_req, dut.i_ara_soc.system_axi_resp)
+  `AXI_PROBE(axi_probe_l2_o, dut.i_ara_soc.periph_wide_axi_req[0], dut.i_ara_soc.periph_wide_axi_resp[0])
+
+`undef AXI_PROBE
+
+  /*******************
+   *  Co-simulation  *
+   *******************/
+
+  // Packed as expected by tb/verilator/spike_cosim.cc. Per commit port p of
+  // CVA6, bits [16*p +: 16] of cosim_commit_o hold the acknowledge (0), the
+  // GPR (1) and FPR (2) write enables and the destination register ([7:3]).
+  // Bit 32 flags an exception.
+`ifndef IDEAL_DISPATCHER
+`define CVA6 dut.i_ara_soc.i_system.i_ariane
+
+  always_comb begin
+    cosim_commit_o = '0;
+    for (int p = 0; p < 2; p++) begin
+      cosim_commit_o[16*p]          = `CVA6.commit_ack[p];
+      cosim_commit_o[16*p + 1]      = `CVA6.we_gpr_commit_id[p];
+      cosim_commit_o[16*p + 2]      = `CVA6.we_fpr_commit_id[p];
+      cosim_commit_o[16*p + 3 +: 5] = `CVA6.waddr_commit_id[p];
+    end
+    cosim_commit_o[32] = `CVA6.ex_commit.valid;
+  end
+
+  assign cosim_pc0_o    = `CVA6.commit_instr_id_commit[0].pc;
+  assign cosim_pc1_o    = `CVA6.commit_instr_id_commit[1].pc;
+  assign cosim_wdata0_o = `CVA6.wdata_commit_id[0];
+  assign cosim_wdata1_o = `CVA6.wdata_commit_id[1];
+
+`undef CVA6
+`else
+  assign cosim_commit_o = '0;
+  assign cosim_pc0_o    = '0;
+  assign cosim_pc1_o    = '0;
+  assign cosim_wdata0_o = '0;
+  assign cosim_wdata1_o = '0;
+`endif
+
+  // Instruction accepted by Ara ([31:0] and 32), and Ara idle with no request
+  // pending (33)
+  always_comb begin
+    cosim_ara_o       = '0;
+    cosim_ara_o[31:0] = `ARA.acc_req_i.acc_req.insn;
+    cosim_ara_o[32]   = `ARA.acc_req_i.acc_req.req_valid && `ARA.acc_resp_o.acc_resp.req_ready;
+    cosim_ara_o[33]   = `ARA.ara_idle && !`ARA.acc_req_i.acc_req.req_valid;
+  end
+
+  // Element width of the layout of every vector register in the VRF
+  always_comb begin
+    cosim_vrf_eew_o = '0;
+    for (int v = 0; v < 32; v++)
+      cosim_vrf_eew_o[2*v +: 2] = `ARA.i_dispatcher.eew_q[v][1:0];
+  end
+
+  /**************
+   *  Watchdog  *
+   **************/
+
+  // Packed as expected by tb/verilator/watchdog.cc. watchdog_ara_o holds the
+  // running instructions ([7:0]), the idle flag (8), the handshake with CVA6
+  // (9, 10), the stall reasons of the sequencer (11-13) and, from bit 16, one
+  // bit per processing element with a running instruction. watchdog_lanes_o
+  // holds four bits per lane: request valid (0) and ready (1) of the lane
+  // sequencer, a busy operand requester (2) and a running instruction (3).
+  always_comb begin
+    watchdog_ara_o       = '0;
+    watchdog_ara_o[7:0]  = `ARA.i_sequencer.vinsn_running_q;
+    watchdog_ara_o[8]    = `ARA.ara_idle;
+    watchdog_ara_o[9]    = `ARA.acc_req_i.acc_req.req_valid;
+    watchdog_ara_o[10]   = `ARA.acc_resp_o.acc_resp.req_ready;
+    watchdog_ara_o[11]   = `ARA.i_sequencer.accepted_insn_stalled;
+    watchdog_ara_o[12]   = `ARA.i_sequencer.stall_lanes_desynch;
+    watchdog_ara_o[13]   = |`ARA.i_sequencer.global_hazard_table_o;
+    for (int pe = 0; pe < NrLanes + 5; pe++)
+      watchdog_ara_o[16 + pe] = |`ARA.i_sequencer.pe_vinsn_running_q[pe];
+  end
+
+  logic [15:0][3:0] watchdog_lanes;
+  for (genvar l = 0; l < 16; l++) begin: gen_watchdog_lanes
+    if (l < NrLanes) begin: gen_lane
+      logic [ara_pkg::NrOperandQueues-1:0] opreq_busy;
+      for (genvar r = 0; r < ara_pkg::NrOperandQueues; r++) begin: gen_opreq
+        assign opreq_busy[r] =
+          `ARA.gen_lanes[l].i_lane.i_operand_requester.gen_operand_requester[r].state_q != '0;
+      end: gen_opreq
+
+      assign watchdog_lanes[l] = {
+        |`ARA.gen_lanes[l].i_lane.i_lane_sequencer.vinsn_running_q,
+        |opreq_busy,
+        `ARA.gen_lanes[l].i_lane.i_lane_sequencer.pe_req_ready_o,
+        `ARA.gen_lanes[l].i_lane.i_lane_sequencer.pe_req_valid_i
+      };
+    end: gen_lane else begin: gen_no_lane
+      assign watchdog_lanes[l] = '0;
+    end: gen_no_lane
+  end: gen_watchdog_lanes
+
+  assign watchdog_lanes_o = watchdog_lanes;
+
+`undef LANE0
+`undef ARA
+
   /*********
    *  EOC  *
    *********/
@@ -17,7 +17,9 @@ module ara_testharness #(
     parameter int unsigned AxiAddrWidth = 64,
     parameter int unsigned AxiDataWidth = 64*NrLanes/2,
     // AXI Resp Delay [ps] for gate-level simulation
-    parameter int unsigned AxiRespDelay = 200
+    parameter int unsigned AxiRespDelay = 200,
+    // Use the DRAM timing model for the L2 memory
+    parameter bit          DramModel    = 1'b0
   ) (
     input  logic        clk_i,
     input  logic        rst_ni,
@@ -73,7 +75,8 @@ module ara_testharness #(
     .AxiDataWidth(AxiDataWidth ),
     .AxiIdWidth  (AxiIdWidth   ),
     .AxiUserWidth(AxiUserWidth ),
-    .AxiRespDelay(AxiRespDelay )
+    .AxiRespDelay(AxiRespDelay ),
+    .DramModel   (DramModel    )
   ) i_ara_soc (
     .clk_i         (clk_i       ),
     .rst_ni        (rst_ni      ),
@@ -97,17 +100,33 @@ module ara_testharness #(
    *  UART  *
    **********/
 
+  // The upper half of the UART region is the console window, see ara_console. Its accesses
+  // complete immediately, and do not reach the mock UART, which aliases its registers.
+  localparam logic [63:0] ConsoleBase   = 64'hC000_0800;
+  localparam logic [63:0] ConsoleLength = 64'h800;
+
+  logic        console_sel;
+  logic [31:0] mock_uart_prdata;
+  logic        mock_uart_pready;
+  logic        mock_uart_pslverr;
+
+  assign console_sel  = uart_paddr >= ConsoleBase[31:0] &&
+                        uart_paddr <  ConsoleBase[31:0] + ConsoleLength[31:0];
+  assign uart_prdata  = console_sel ? '0   : mock_uart_prdata;
+  assign uart_pready  = console_sel ? 1'b1 : mock_uart_pready;
+  assign uart_pslverr = console_sel ? 1'b0 : mock_uart_pslverr;
+
   mock_uart i_mock_uart (
-    .clk_i    (clk_i       ),
-    .rst_ni   (rst_ni      ),
-    .penable_i(uart_penable),
-    .pwrite_i (uart_pwrite ),
-    .paddr_i  (uart_paddr  ),
-    .psel_i   (uart_psel   ),
-    .pwdata_i (uart_pwdata ),
-    .prdata_o (uart_prdata ),
-    .pready_o (uart_pready ),
-    .pslverr_o(uart_pslverr)
+    .clk_i    (clk_i                    ),
+    .rst_ni   (rst_ni                   ),
+    .penable_i(uart_penable             ),
+    .pwrite_i (uart_pwrite              ),
+    .paddr_i  (uart_paddr               ),
+    .psel_i   (uart_psel && !console_sel),
+    .pwdata_i (uart_pwdata              ),
+    .prdata_o (mock_uart_prdata         ),
+    .pready_o (mock_uart_pready         ),
+    .pslverr_o(mock_uart_pslverr        )
   );
 
 `ifndef TARGET_GATESIM
@@ -279,6 +298,67 @@ module ara_testharness #(
 
 `endif
 
+  /*************
+   *  CONSOLE  *
+   *************/
+
+  ara_console #(
+    .AxiDataWidth(AxiDataWidth ),
+    .Base        (ConsoleBase  ),
+    .Length      (ConsoleLength)
+  ) i_console (
+    .clk_i     (clk_i                                                  ),
+    .rst_ni    (rst_ni                                                 ),
+    .aw_addr_i (64'(i_ara_soc.i_system.i_ara.i_vlsu.axi_req.aw.addr)   ),
+    .aw_len_i  (i_ara_soc.i_system.i_ara.i_vlsu.axi_req.aw.len         ),
+    .aw_size_i (i_ara_soc.i_system.i_ara.i_vlsu.axi_req.aw.size        ),
+    .aw_burst_i(i_ara_soc.i_system.i_ara.i_vlsu.axi_req.aw.burst       ),
+    .aw_valid_i(i_ara_soc.i_system.i_ara.i_vlsu.axi_req.aw_valid       ),
+    .aw_ready_i(i_ara_soc.i_system.i_ara.i_vlsu.axi_resp.aw_ready      ),
+    .w_data_i  (i_ara_soc.i_system.i_ara.i_vlsu.axi_req.w.data         ),
+    .w_strb_i  (i_ara_soc.i_system.i_ara.i_vlsu.axi_req.w.strb         ),
+    .w_last_i  (i_ara_soc.i_system.i_ara.i_vlsu.axi_req.w.last         ),
+    .w_valid_i (i_ara_soc.i_system.i_ara.i_vlsu.axi_req.w_valid        ),
+    .w_ready_i (i_ara_soc.i_system.i_ara.i_vlsu.axi_resp.w_ready       )
+  );
+
+  /*********************
+   *  PIPELINE TRACER  *
+   *********************/
+
+  // Konata trace of the vector instructions, enabled by +konata_trace=FILE
+
+  logic         [NrLanes-1:0] lane_pe_req_valid, lane_pe_req_ready;
+  ara_pkg::vid_t [NrLanes-1:0] lane_pe_req_id;
+
+  for (genvar l = 0; l < NrLanes; l++) begin: gen_lane_pe_req
+    assign lane_pe_req_valid[l] = i_ara_soc.i_system.i_ara.gen_lanes[l].i_lane.i_lane_sequencer.pe_req_valid_i;
+    assign lane_pe_req_ready[l] = i_ara_soc.i_system.i_ara.gen_lanes[l].i_lane.i_lane_sequencer.pe_req_ready_o;
+    assign lane_pe_req_id[l]    = i_ara_soc.i_system.i_ara.gen_lanes[l].i_lane.i_lane_sequencer.pe_req_i.id;
+  end: gen_lane_pe_req
+
+  ara_konata_tracer #(
+    .NrLanes(NrLanes)
+  ) i_konata_tracer (
+    .clk_i                (clk_i                                                  ),
+    .rst_ni               (rst_ni                                                 ),
+    .ara_req_valid_i      (i_ara_soc.i_system.i_ara.ara_req_valid                 ),
+    .ara_req_ready_i      (i_ara_soc.i_system.i_ara.ara_req_ready                 ),
+    .ara_req_op_i         (i_ara_soc.i_system.i_ara.ara_req.op                    ),
+    .ara_req_vd_i         (i_ara_soc.i_system.i_ara.ara_req.vd                    ),
+    .ara_req_vs1_i        (i_ara_soc.i_system.i_ara.ara_req.vs1                   ),
+    .ara_req_vs2_i        (i_ara_soc.i_system.i_ara.ara_req.vs2                   ),
+    .ara_req_use_vd_i     (i_ara_soc.i_system.i_ara.ara_req.use_vd                ),
+    .ara_req_use_vs1_i    (i_ara_soc.i_system.i_ara.ara_req.use_vs1               ),
+    .ara_req_use_vs2_i    (i_ara_soc.i_system.i_ara.ara_req.use_vs2               ),
+    .ara_req_vl_i         (32'(i_ara_soc.i_system.i_ara.ara_req.vl)               ),
+    .ara_req_vsew_i       (i_ara_soc.i_system.i_ara.ara_req.vtype.vsew            ),
+    .pe_vinsn_running_i   (i_ara_soc.i_system.i_ara.i_sequencer.pe_vinsn_running_q),
+    .global_hazard_table_i(i_ara_soc.i_system.i_ara.global_hazard_table           ),
+    .lane_pe_req_valid_i  (lane_pe_req_valid                                      ),
+    .lane_pe_req_ready_i  (lane_pe_req_ready                                      ),
+    .lane_pe_req_id_i     (lane_pe_req_id                                         )
+  );
 
 `endif
 endmodule : ara_testharness
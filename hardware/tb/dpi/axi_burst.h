@@ -0,0 +1,35 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// AXI4 bursts, as seen on the AW channel, shared by the DPI models that snoop
+// the W beats of Ara.
+
+#pragma once
+
+#include <cstdint>
+
+struct AxiBurst {
+  uint64_t addr;
+  uint32_t len;
+  uint32_t size;
+  uint32_t burst;
+};
+
+// Address of beat |i| of burst |b| (AXI4 FIXED, INCR and WRAP)
+inline uint64_t AxiBeatAddress(const AxiBurst &b, uint32_t i) {
+  uint64_t bytes = 1ULL << b.size;
+  uint64_t aligned = b.addr & ~(bytes - 1);
+  switch (b.burst) {
+    case 0:  // FIXED
+      return b.addr;
+    case 2: {  // WRAP
+      uint64_t wrap = bytes * (b.len + 1);
+      uint64_t base = b.addr & ~(wrap - 1);
+      return base + ((aligned - base + i * bytes) & (wrap - 1));
+    }
+    default:  // INCR
+      return i ? aligned + i * bytes : b.addr;
+  }
+}
@@ -0,0 +1,199 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// Host-side console, see tb/ara_console.sv. The strobed bytes of Ara's W beats
+// that fall into the console window are printed on the standard output, in
+// order. The output is buffered, and written line by line.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string>
+
+#include "axi_burst.h"
+#include "dpi_state.h"
+#include "svdpi.h"
+
+namespace {
+
+class Console {
+ public:
+  Console(uint32_t beat_bytes, uint64_t base, uint64_t length)
+      : beat_bytes_(beat_bytes), base_(base), length_(length), beat_(0) {}
+
+  ~Console() { Print(line_.size()); }
+
+  // Print the last, unterminated, line and drop the bursts in flight, e.g.
+  // between the tests of a batch run
+  void Reset() {
+    Print(line_.size());
+    bursts_.clear();
+    beats_.clear();
+    beat_ = 0;
+  }
+
+  void Aw(uint64_t addr, uint32_t len, uint32_t size, uint32_t burst) {
+    bursts_.push_back(AxiBurst{addr, len, size, burst});
+    Flush();
+  }
+
+  void W(const svBitVecVal *data, const svBitVecVal *strb, bool last) {
+    Beat beat;
+    beat.strb = strb[0];
+    if (beat_bytes_ > 32) {
+      beat.strb |= (uint64_t)strb[1] << 32;
+    }
+    memcpy(beat.data, data, beat_bytes_);
+    beat.last = last;
+    beats_.push_back(beat);
+    Flush();
+  }
+
+  void Save(DpiStateWriter &w) const {
+    w.Put(beat_bytes_);
+    w.Put(base_);
+    w.Put(length_);
+    w.Put(beat_);
+    w.PutSequence(bursts_);
+    w.PutSequence(beats_);
+    w.PutString(line_);
+  }
+
+  // nullptr if the state is malformed
+  static Console *Restore(DpiStateReader &r) {
+    uint32_t beat_bytes;
+    uint64_t base, length;
+    if (!r.Get(beat_bytes) || !r.Get(base) || !r.Get(length)) {
+      return nullptr;
+    }
+    Console *console = new Console(beat_bytes, base, length);
+    if (!r.Get(console->beat_) || !r.GetSequence(console->bursts_) ||
+        !r.GetSequence(console->beats_) || !r.GetString(console->line_)) {
+      delete console;
+      return nullptr;
+    }
+    return console;
+  }
+
+ private:
+  struct Beat {
+    uint64_t strb;
+    uint8_t data[64];
+    bool last;
+  };
+
+  uint32_t beat_bytes_;
+  uint64_t base_;
+  uint64_t length_;
+  // Beat of the oldest burst
+  uint32_t beat_;
+  // Bursts whose data has not been seen yet, in order
+  std::deque<AxiBurst> bursts_;
+  // Beats that arrived before the address of their burst
+  std::deque<Beat> beats_;
+  // Characters not printed yet
+  std::string line_;
+
+  // Collect the console bytes of the beats whose address is known
+  void Flush() {
+    while (!beats_.empty() && !bursts_.empty()) {
+      const Beat &beat = beats_.front();
+      uint64_t addr = AxiBeatAddress(bursts_.front(), beat_);
+      if (beat.last) {
+        beat_ = 0;
+        bursts_.pop_front();
+      } else {
+        ++beat_;
+      }
+
+      addr &= ~(uint64_t)(beat_bytes_ - 1);
+      for (uint32_t b = 0; b < beat_bytes_; ++b) {
+        if ((beat.strb & (1ULL << b)) && addr + b - base_ < length_) {
+          line_ += (char)beat.data[b];
+        }
+      }
+      beats_.pop_front();
+    }
+
+    size_t eol = line_.rfind('\n');
+    if (eol != std::string::npos) {
+      Print(eol + 1);
+    }
+  }
+
+  // Print the first |n| characters
+  void Print(size_t n) {
+    if (n) {
+      fwrite(line_.data(), 1, n, stdout);
+      fflush(stdout);
+      line_.erase(0, n);
+    }
+  }
+};
+
+DpiInstances<Console> consoles;
+
+}  // namespace
+
+std::string console_save_state() {
+  DpiStateWriter w;
+  w.Put<uint64_t>(consoles.size());
+  for (size_t i = 1; i <= consoles.size(); ++i) {
+    const Console *console = consoles.Get(i);
+    w.Put<uint8_t>(console != nullptr);
+    if (console) {
+      console->Save(w);
+    }
+  }
+  return w.state();
+}
+
+bool console_restore_state(const std::string &state) {
+  DpiStateReader r(state);
+  uint64_t size;
+  if (!r.Get(size)) {
+    return false;
+  }
+  consoles.Clear();
+  for (uint64_t i = 0; i < size; ++i) {
+    uint8_t open;
+    if (!r.Get(open)) {
+      return false;
+    }
+    Console *console = nullptr;
+    if (open && !(console = Console::Restore(r))) {
+      return false;
+    }
+    consoles.Add(console);
+  }
+  return r.Done();
+}
+
+extern "C" {
+
+// 0 if the bus width is not supported
+int console_open(int beat_bytes, long long base, long long length) {
+  if (beat_bytes <= 0 || beat_bytes > 64 || (beat_bytes & (beat_bytes - 1))) {
+    fprintf(stderr, "ERROR: Unsupported bus width of %d bytes for the console\n",
+            beat_bytes);
+    return 0;
+  }
+  return consoles.Add(new Console(beat_bytes, base, length));
+}
+
+void console_aw(int console, long long addr, int len, int size, int burst) {
+  consoles.Get(console)->Aw(addr, len, size, burst);
+}
+
+void console_w(int console, const svBitVecVal *data, const svBitVecVal *strb,
+               svBit last) {
+  consoles.Get(console)->W(data, strb, last);
+}
+
+void console_reset(int console) { consoles.Get(console)->Reset(); }
+
+void console_close(int console) { consoles.Remove(console); }
+}
@@ -0,0 +1,136 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// State of the DPI models in the checkpoints of the Verilator model, see
+// tb/verilator/dpi_checkpoint.h.
+//
+// The testbench refers to the instances of a model with integer handles, not
+// with chandles. A handle is part of the state of the design, and still refers
+// to the same instance once a checkpoint is restored by another process, where
+// the initial blocks that opened the instances do not run again.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Instances of a model: handle i refers to the i-th one, 0 to none
+template <typename T>
+class DpiInstances {
+ public:
+  int Add(T *instance) {
+    instances_.emplace_back(instance);
+    return instances_.size();
+  }
+
+  T *Get(int handle) const { return instances_[handle - 1].get(); }
+
+  void Remove(int handle) { instances_[handle - 1].reset(); }
+
+  // Slots, including the ones of the removed instances
+  size_t size() const { return instances_.size(); }
+
+  void Clear() { instances_.clear(); }
+
+ private:
+  std::vector<std::unique_ptr<T>> instances_;
+};
+
+// Serialize the state of a model into a byte string
+class DpiStateWriter {
+ public:
+  template <typename T>
+  void Put(const T &value) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only plain values are copied");
+    state_.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  void PutString(const std::string &s) {
+    Put<uint64_t>(s.size());
+    state_ += s;
+  }
+
+  // Any container of plain values
+  template <typename C>
+  void PutSequence(const C &c) {
+    Put<uint64_t>(c.size());
+    for (const auto &value : c) {
+      Put(value);
+    }
+  }
+
+  const std::string &state() const { return state_; }
+
+ private:
+  std::string state_;
+};
+
+// Deserialize a state written by DpiStateWriter. Every getter returns false
+// once the state is exhausted.
+class DpiStateReader {
+ public:
+  explicit DpiStateReader(const std::string &state) : state_(state), pos_(0) {}
+
+  template <typename T>
+  bool Get(T &value) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only plain values are copied");
+    if (state_.size() - pos_ < sizeof(T)) {
+      return false;
+    }
+    memcpy(&value, state_.data() + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+
+  bool GetString(std::string &s) {
+    uint64_t size;
+    if (!Get(size) || state_.size() - pos_ < size) {
+      return false;
+    }
+    s.assign(state_, pos_, size);
+    pos_ += size;
+    return true;
+  }
+
+  // Any container of plain values with push_back()
+  template <typename C>
+  bool GetSequence(C &c) {
+    uint64_t size;
+    if (!Get(size)) {
+      return false;
+    }
+    c.clear();
+    for (uint64_t i = 0; i < size; ++i) {
+      typename C::value_type value;
+      if (!Get(value)) {
+        return false;
+      }
+      c.push_back(value);
+    }
+    return true;
+  }
+
+  bool Done() const { return pos_ == state_.size(); }
+
+ private:
+  const std::string &state_;
+  size_t pos_;
+};
+
+// State of all the instances of each model. A restored state replaces the
+// current instances; false if it is malformed, or if a resource of the model,
+// e.g. the vector trace, cannot be opened again.
+std::string console_save_state();
+bool console_restore_state(const std::string &state);
+std::string dram_model_save_state();
+bool dram_model_restore_state(const std::string &state);
+std::string vtrace_save_state();
+bool vtrace_restore_state(const std::string &state);
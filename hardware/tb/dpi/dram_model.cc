@@ -0,0 +1,304 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// DRAM timing model of the L2 memory, see tb/ara_dram_model.sv.
+//
+// The model only decides when a request is granted and when its response is
+// returned, the data is kept by the SRAM of the SoC. Every request transfers
+// one word of the memory interface. A request goes through:
+// - its bank, which has to open the addressed row first (row-buffer hit,
+//   miss on a closed bank, or conflict with another open row),
+// - the data bus, shared by all the banks, with a limited bandwidth,
+// - a fixed latency for the controller and the interconnect.
+// Responses are returned in order, at most one per cycle, and at most
+// max_outstanding requests are in flight.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+#include "dpi_state.h"
+#include "svdpi.h"
+
+namespace {
+
+struct DramConfig {
+  uint32_t word_bytes;
+  uint32_t max_outstanding;
+  // Fixed latency of the controller and the interconnect [cycles]
+  uint32_t latency;
+  // Data bus bandwidth [bytes/cycle]
+  double bandwidth;
+  uint32_t banks;
+  uint32_t row_bytes;
+  // Column access, row activation and precharge times [cycles]
+  uint32_t t_cas;
+  uint32_t t_rcd;
+  uint32_t t_rp;
+};
+
+struct DramStats {
+  uint64_t cycles;
+  uint64_t busy_cycles;
+  uint64_t reads;
+  uint64_t writes;
+  uint64_t row_hits;
+  uint64_t row_misses;
+  uint64_t row_conflicts;
+  uint64_t stall_cycles;
+  uint64_t latency_sum;
+  uint64_t latency_max;
+  uint64_t outstanding_sum;
+  uint64_t outstanding_max;
+};
+
+class DramModel {
+ public:
+  explicit DramModel(const DramConfig &cfg)
+      : cfg_(cfg), banks_(cfg.banks), cycle_(0), bus_free_(0), last_done_(0),
+        stats_() {}
+
+  // Called on every cycle of a reset, e.g. between the tests of a batch run:
+  // the statistics of the previous test are printed once, then cleared
+  void Reset() {
+    if (stats_.reads + stats_.writes) {
+      PrintStatistics();
+    }
+    stats_ = DramStats();
+    pending_.clear();
+    for (auto &bank : banks_) {
+      bank = Bank();
+    }
+    bus_free_ = cycle_;
+    last_done_ = cycle_;
+  }
+
+  // Advance by one cycle. |req| and |gnt| are the request and grant of the
+  // cycle that just ended, |gnt_next| and |rvalid_next| the grant and the
+  // response valid of the next one.
+  void Clock(bool req, bool gnt, bool we, uint64_t addr, bool &gnt_next,
+             bool &rvalid_next) {
+    ++stats_.cycles;
+    if (!pending_.empty()) {
+      ++stats_.busy_cycles;
+    }
+    stats_.outstanding_sum += pending_.size();
+    if (req && !gnt) {
+      ++stats_.stall_cycles;
+    }
+    if (req && gnt) {
+      Accept(we, addr);
+    }
+
+    ++cycle_;
+    rvalid_next = !pending_.empty() && pending_.front().done <= cycle_;
+    if (rvalid_next) {
+      uint64_t latency = cycle_ - pending_.front().accepted;
+      stats_.latency_sum += latency;
+      stats_.latency_max = std::max(stats_.latency_max, latency);
+      pending_.pop_front();
+    }
+    gnt_next = pending_.size() < cfg_.max_outstanding;
+  }
+
+  void PrintStatistics() const {
+    uint64_t requests = stats_.reads + stats_.writes;
+    double bytes = (double)requests * cfg_.word_bytes;
+    printf("[DRAM] Requests: %lu (%lu reads, %lu writes)\n",
+           (unsigned long)requests, (unsigned long)stats_.reads,
+           (unsigned long)stats_.writes);
+    printf("[DRAM] Row buffer: %lu hits, %lu misses, %lu conflicts\n",
+           (unsigned long)stats_.row_hits, (unsigned long)stats_.row_misses,
+           (unsigned long)stats_.row_conflicts);
+    printf("[DRAM] Bandwidth: %.3f B/cycle overall, %.3f B/cycle while busy "
+           "(peak %.3f B/cycle)\n",
+           stats_.cycles ? bytes / stats_.cycles : 0.0,
+           stats_.busy_cycles ? bytes / stats_.busy_cycles : 0.0,
+           cfg_.bandwidth);
+    printf("[DRAM] Latency: %.2f cycles average, %lu cycles max\n",
+           requests ? (double)stats_.latency_sum / requests : 0.0,
+           (unsigned long)stats_.latency_max);
+    printf("[DRAM] Queue: %.2f requests average, %lu max (limit %u), "
+           "%lu stall cycles\n",
+           stats_.cycles ? (double)stats_.outstanding_sum / stats_.cycles : 0.0,
+           (unsigned long)stats_.outstanding_max, cfg_.max_outstanding,
+           (unsigned long)stats_.stall_cycles);
+  }
+
+  void Save(DpiStateWriter &w) const {
+    w.Put(cfg_);
+    w.PutSequence(banks_);
+    w.PutSequence(pending_);
+    w.Put(cycle_);
+    w.Put(bus_free_);
+    w.Put(last_done_);
+    w.Put(stats_);
+  }
+
+  // nullptr if the state is malformed
+  static DramModel *Restore(DpiStateReader &r) {
+    DramConfig cfg;
+    if (!r.Get(cfg)) {
+      return nullptr;
+    }
+    DramModel *model = new DramModel(cfg);
+    if (!r.GetSequence(model->banks_) || !r.GetSequence(model->pending_) ||
+        !r.Get(model->cycle_) || !r.Get(model->bus_free_) ||
+        !r.Get(model->last_done_) || !r.Get(model->stats_) ||
+        model->banks_.size() != cfg.banks) {
+      delete model;
+      return nullptr;
+    }
+    return model;
+  }
+
+ private:
+  struct Bank {
+    Bank() : open(false), row(0), ready(0) {}
+    bool open;
+    uint64_t row;
+    uint64_t ready;
+  };
+
+  struct Request {
+    uint64_t accepted;
+    uint64_t done;
+  };
+
+  DramConfig cfg_;
+  std::vector<Bank> banks_;
+  std::deque<Request> pending_;
+  uint64_t cycle_;
+  double bus_free_;
+  uint64_t last_done_;
+  DramStats stats_;
+
+  void Accept(bool we, uint64_t addr) {
+    ++(we ? stats_.writes : stats_.reads);
+
+    // Consecutive rows are interleaved over the banks
+    uint64_t row_addr = addr / cfg_.row_bytes;
+    Bank &bank = banks_[row_addr % cfg_.banks];
+    uint64_t row = row_addr / cfg_.banks;
+
+    uint64_t activate = 0;
+    if (bank.open && bank.row == row) {
+      ++stats_.row_hits;
+    } else if (!bank.open) {
+      ++stats_.row_misses;
+      activate = cfg_.t_rcd;
+    } else {
+      ++stats_.row_conflicts;
+      activate = cfg_.t_rp + cfg_.t_rcd;
+    }
+    bank.open = true;
+    bank.row = row;
+
+    // The bank serializes its accesses, the data bus is shared
+    uint64_t start = std::max(cycle_, bank.ready);
+    double transfer = (double)cfg_.word_bytes / cfg_.bandwidth;
+    double bus_start = std::max((double)(start + activate + cfg_.t_cas),
+                                bus_free_);
+    bus_free_ = bus_start + transfer;
+    bank.ready = start + activate + (uint64_t)std::ceil(transfer);
+
+    // In order, at most one response per cycle, not before the SRAM data
+    uint64_t done = (uint64_t)std::ceil(bus_free_) + cfg_.latency;
+    done = std::max(done, std::max(last_done_ + 1, cycle_ + 1));
+    last_done_ = done;
+
+    pending_.push_back(Request{cycle_, done});
+    stats_.outstanding_max =
+        std::max<uint64_t>(stats_.outstanding_max, pending_.size());
+  }
+};
+
+DpiInstances<DramModel> models;
+
+}  // namespace
+
+std::string dram_model_save_state() {
+  DpiStateWriter w;
+  w.Put<uint64_t>(models.size());
+  for (size_t i = 1; i <= models.size(); ++i) {
+    const DramModel *model = models.Get(i);
+    w.Put<uint8_t>(model != nullptr);
+    if (model) {
+      model->Save(w);
+    }
+  }
+  return w.state();
+}
+
+bool dram_model_restore_state(const std::string &state) {
+  DpiStateReader r(state);
+  uint64_t size;
+  if (!r.Get(size)) {
+    return false;
+  }
+  models.Clear();
+  for (uint64_t i = 0; i < size; ++i) {
+    uint8_t open;
+    if (!r.Get(open)) {
+      return false;
+    }
+    DramModel *model = nullptr;
+    if (open && !(model = DramModel::Restore(r))) {
+      return false;
+    }
+    models.Add(model);
+  }
+  return r.Done();
+}
+
+extern "C" {
+
+// 0 if the configuration is invalid
+int dram_model_init(int word_bytes, int max_outstanding, int latency,
+                    double bandwidth, int banks, int row_bytes, int t_cas,
+                    int t_rcd, int t_rp) {
+  if (word_bytes <= 0 || max_outstanding <= 0 || latency < 0 ||
+      bandwidth <= 0 || banks <= 0 || row_bytes <= 0 || t_cas < 0 ||
+      t_rcd < 0 || t_rp < 0) {
+    fprintf(stderr, "[DRAM] ERROR: Invalid timing model configuration.\n");
+    return 0;
+  }
+
+  DramConfig cfg;
+  cfg.word_bytes = word_bytes;
+  cfg.max_outstanding = max_outstanding;
+  cfg.latency = latency;
+  cfg.bandwidth = bandwidth;
+  cfg.banks = banks;
+  cfg.row_bytes = row_bytes;
+  cfg.t_cas = t_cas;
+  cfg.t_rcd = t_rcd;
+  cfg.t_rp = t_rp;
+
+  printf("[DRAM] Timing model: %u outstanding, latency %u, %.3f B/cycle, "
+         "%u banks of %u B rows, tCAS %u, tRCD %u, tRP %u\n",
+         cfg.max_outstanding, cfg.latency, cfg.bandwidth, cfg.banks,
+         cfg.row_bytes, cfg.t_cas, cfg.t_rcd, cfg.t_rp);
+  return models.Add(new DramModel(cfg));
+}
+
+void dram_model_reset(int model) { models.Get(model)->Reset(); }
+
+void dram_model_clock(int model, svBit req, svBit gnt, svBit we,
+                      long long addr, svBit *gnt_next, svBit *rvalid_next) {
+  bool g, r;
+  models.Get(model)->Clock(req, gnt, we, addr, g, r);
+  *gnt_next = g;
+  *rvalid_next = r;
+}
+
+void dram_model_final(int model) {
+  models.Get(model)->PrintStatistics();
+  models.Remove(model);
+}
+}
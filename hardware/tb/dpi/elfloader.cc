@@ -1 +0,0 @@
-../../deps/cva6/corev_apu/tb/dpi/elfloader.cc
\ No newline at end of file
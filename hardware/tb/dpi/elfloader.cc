@@ -0,0 +1,205 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// ELF loader of the QuestaSim test-bench, see the "DRAM Initialization"
+// section of tb/ara_tb.sv.
+//
+// The ELF file is mapped into memory and its loadable segments are served
+// straight from the mapping:
+// - read_elf() opens the file and lists its segments,
+// - get_section() returns them one after the other,
+// - read_section() copies a segment into a byte array,
+// - load_section() writes a whole segment into a memory array of the design
+//   with a single DPI call.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "svdpi.h"
+
+namespace {
+
+struct Section {
+  uint64_t addr;
+  // Bytes in the file, the rest up to |mem_size| is zero
+  const uint8_t *data;
+  uint64_t file_size;
+  uint64_t mem_size;
+};
+
+struct ElfImage {
+  void *map;
+  size_t map_size;
+  std::vector<Section> sections;
+  size_t next;
+};
+
+ElfImage elf = {nullptr, 0, {}, 0};
+
+void CloseElf() {
+  if (elf.map) {
+    munmap(elf.map, elf.map_size);
+  }
+  elf.map = nullptr;
+  elf.map_size = 0;
+  elf.sections.clear();
+  elf.next = 0;
+}
+
+template <typename Ehdr, typename Phdr>
+bool ReadSegments(const char *filename) {
+  const uint8_t *base = static_cast<const uint8_t *>(elf.map);
+  const Ehdr *eh = reinterpret_cast<const Ehdr *>(base);
+  if (eh->e_phoff + (uint64_t)eh->e_phnum * sizeof(Phdr) > elf.map_size) {
+    fprintf(stderr, "ERROR: Truncated program headers in %s\n", filename);
+    return false;
+  }
+
+  const Phdr *ph = reinterpret_cast<const Phdr *>(base + eh->e_phoff);
+  for (unsigned i = 0; i < eh->e_phnum; ++i) {
+    if (ph[i].p_type != PT_LOAD || ph[i].p_memsz == 0) {
+      continue;
+    }
+    if (ph[i].p_offset + ph[i].p_filesz > elf.map_size) {
+      fprintf(stderr, "ERROR: Truncated segment %u in %s\n", i, filename);
+      return false;
+    }
+    elf.sections.push_back(Section{ph[i].p_paddr, base + ph[i].p_offset,
+                                   ph[i].p_filesz, ph[i].p_memsz});
+  }
+  return true;
+}
+
+const Section *FindSection(uint64_t addr) {
+  for (const Section &s : elf.sections) {
+    if (s.addr == addr) {
+      return &s;
+    }
+  }
+  fprintf(stderr, "ERROR: No section at address 0x%lx\n", (unsigned long)addr);
+  return nullptr;
+}
+
+}  // namespace
+
+extern "C" {
+
+void read_elf(const char *filename) {
+  CloseElf();
+
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "ERROR: Could not open %s\n", filename);
+    return;
+  }
+  struct stat st;
+  if (fstat(fd, &st) || (size_t)st.st_size < EI_NIDENT) {
+    fprintf(stderr, "ERROR: %s is not an ELF file\n", filename);
+    close(fd);
+    return;
+  }
+  elf.map_size = st.st_size;
+  elf.map = mmap(nullptr, elf.map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (elf.map == MAP_FAILED) {
+    fprintf(stderr, "ERROR: Could not map %s\n", filename);
+    elf.map = nullptr;
+    CloseElf();
+    return;
+  }
+
+  const unsigned char *ident = static_cast<const unsigned char *>(elf.map);
+  bool ok = false;
+  if (memcmp(ident, ELFMAG, SELFMAG) != 0) {
+    fprintf(stderr, "ERROR: %s is not an ELF file\n", filename);
+  } else if (ident[EI_CLASS] == ELFCLASS64 &&
+             elf.map_size >= sizeof(Elf64_Ehdr)) {
+    ok = ReadSegments<Elf64_Ehdr, Elf64_Phdr>(filename);
+  } else if (ident[EI_CLASS] == ELFCLASS32 &&
+             elf.map_size >= sizeof(Elf32_Ehdr)) {
+    ok = ReadSegments<Elf32_Ehdr, Elf32_Phdr>(filename);
+  } else {
+    fprintf(stderr, "ERROR: Unsupported ELF class in %s\n", filename);
+  }
+  if (!ok) {
+    CloseElf();
+  }
+}
+
+// Get the address and the length of the next section
+char get_section(long long *address, long long *len) {
+  if (elf.next >= elf.sections.size()) {
+    return 0;
+  }
+  *address = elf.sections[elf.next].addr;
+  *len = elf.sections[elf.next].mem_size;
+  ++elf.next;
+  return 1;
+}
+
+// Copy the section at |address| into |buffer|
+char read_section(long long address, const svOpenArrayHandle buffer) {
+  const Section *s = FindSection(address);
+  if (!s) {
+    return 0;
+  }
+
+  uint64_t size = svSize(buffer, 1);
+  uint8_t *dst = static_cast<uint8_t *>(svGetArrayPtr(buffer));
+  for (uint64_t i = 0; i < size; ++i) {
+    uint8_t byte = i < s->file_size ? s->data[i] : 0;
+    if (dst) {
+      dst[i] = byte;
+    } else {
+      *static_cast<uint8_t *>(svGetArrElemPtr1(buffer, i)) = byte;
+    }
+  }
+  return 1;
+}
+
+// Write the section at |address| into the memory array |mem| of
+// |word_bytes|-byte words, whose first word is at address |mem_base|. The
+// bytes around an unaligned section keep their value.
+char load_section(long long address, long long mem_base, int word_bytes,
+                  const svOpenArrayHandle mem) {
+  const Section *s = FindSection(address);
+  if (!s) {
+    return 0;
+  }
+
+  uint64_t offset = address - mem_base;
+  uint64_t mem_bytes = (uint64_t)svSize(mem, 1) * word_bytes;
+  if ((uint64_t)address < (uint64_t)mem_base || offset > mem_bytes ||
+      s->mem_size > mem_bytes - offset) {
+    fprintf(stderr,
+            "ERROR: Section 0x%lx (0x%lx bytes) does not fit in the memory\n",
+            (unsigned long)address, (unsigned long)s->mem_size);
+    return 0;
+  }
+
+  int low = svLow(mem, 1);
+  for (uint64_t i = 0; i < s->mem_size;) {
+    uint64_t word = (offset + i) / word_bytes;
+    svLogicVecVal *w =
+        static_cast<svLogicVecVal *>(svGetArrElemPtr1(mem, low + word));
+    // Bytes of the section within this word
+    for (uint64_t b = (offset + i) % word_bytes;
+         b < (uint64_t)word_bytes && i < s->mem_size; ++b, ++i) {
+      uint32_t byte = i < s->file_size ? s->data[i] : 0;
+      unsigned shift = 8 * (b % 4);
+      w[b / 4].aval = (w[b / 4].aval & ~(0xffu << shift)) | (byte << shift);
+      w[b / 4].bval &= ~(0xffu << shift);
+    }
+  }
+  return 1;
+}
+}
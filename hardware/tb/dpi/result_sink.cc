@@ -0,0 +1,138 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// Binary capture of the data stored by Ara, see the "Stored values" section of
+// tb/ara_tb.sv. Compare two captures with scripts/compare_results.py.
+//
+// File format (little endian):
+//   header: "ARARES01", u32 bytes per beat
+//   record: u64 address, u64 strobe, one byte per strobe bit that is set
+// There is one record per W beat with at least one strobe bit set. The
+// address is the one of the first byte of the bus word.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+
+#include "axi_burst.h"
+#include "svdpi.h"
+
+namespace {
+
+const char kMagic[8] = {'A', 'R', 'A', 'R', 'E', 'S', '0', '1'};
+const size_t kBufferSize = 1 << 20;
+
+class ResultSink {
+ public:
+  ResultSink(FILE *fp, uint32_t beat_bytes)
+      : fp_(fp), beat_bytes_(beat_bytes), beat_(0), buffer_(new char[kBufferSize]) {
+    setvbuf(fp_, buffer_, _IOFBF, kBufferSize);
+    fwrite(kMagic, 1, sizeof(kMagic), fp_);
+    fwrite(&beat_bytes_, sizeof(beat_bytes_), 1, fp_);
+  }
+
+  ~ResultSink() {
+    fclose(fp_);
+    delete[] buffer_;
+  }
+
+  void Aw(uint64_t addr, uint32_t len, uint32_t size, uint32_t burst) {
+    bursts_.push_back(AxiBurst{addr, len, size, burst});
+    Flush();
+  }
+
+  void W(const svBitVecVal *data, const svBitVecVal *strb, bool last,
+         bool record) {
+    Beat beat;
+    beat.strb = strb[0];
+    if (beat_bytes_ > 32) {
+      beat.strb |= (uint64_t)strb[1] << 32;
+    }
+    memcpy(beat.data, data, beat_bytes_);
+    beat.last = last;
+    beat.record = record;
+    beats_.push_back(beat);
+    Flush();
+  }
+
+ private:
+  struct Beat {
+    uint64_t strb;
+    uint8_t data[64];
+    bool last;
+    // Is the beat captured? The others only advance the bursts.
+    bool record;
+  };
+
+  FILE *fp_;
+  uint32_t beat_bytes_;
+  // Beat of the oldest burst
+  uint32_t beat_;
+  char *buffer_;
+  // Bursts whose data has not been written yet, in order
+  std::deque<AxiBurst> bursts_;
+  // Beats that arrived before the address of their burst
+  std::deque<Beat> beats_;
+
+  // Write the beats whose address is known
+  void Flush() {
+    while (!beats_.empty() && !bursts_.empty()) {
+      const Beat &beat = beats_.front();
+      uint64_t addr = AxiBeatAddress(bursts_.front(), beat_);
+      if (beat.last) {
+        beat_ = 0;
+        bursts_.pop_front();
+      } else {
+        ++beat_;
+      }
+
+      if (beat.record && beat.strb) {
+        addr &= ~(uint64_t)(beat_bytes_ - 1);
+        fwrite(&addr, sizeof(addr), 1, fp_);
+        fwrite(&beat.strb, sizeof(beat.strb), 1, fp_);
+        for (uint32_t b = 0; b < beat_bytes_; ++b) {
+          if (beat.strb & (1ULL << b)) {
+            fputc(beat.data[b], fp_);
+          }
+        }
+      }
+      beats_.pop_front();
+    }
+  }
+};
+
+}  // namespace
+
+extern "C" {
+
+void *result_sink_open(const char *path, int beat_bytes) {
+  if (beat_bytes <= 0 || beat_bytes > 64 || (beat_bytes & (beat_bytes - 1))) {
+    fprintf(stderr, "ERROR: Unsupported bus width of %d bytes for %s\n",
+            beat_bytes, path);
+    return nullptr;
+  }
+  FILE *fp = fopen(path, "wb");
+  if (!fp) {
+    fprintf(stderr, "ERROR: Could not open %s\n", path);
+    return nullptr;
+  }
+  return new ResultSink(fp, beat_bytes);
+}
+
+void result_sink_aw(void *sink, long long addr, int len, int size,
+                    int burst) {
+  static_cast<ResultSink *>(sink)->Aw(addr, len, size, burst);
+}
+
+void result_sink_w(void *sink, const svBitVecVal *data,
+                   const svBitVecVal *strb, svBit last, svBit record) {
+  static_cast<ResultSink *>(sink)->W(data, strb, last, record);
+}
+
+void result_sink_close(void *sink) {
+  delete static_cast<ResultSink *>(sink);
+}
+}
@@ -0,0 +1,334 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// Streaming reader of the vector instruction traces of the ideal dispatcher,
+// see src/accel_dispatcher_ideal.sv.
+//
+// Every entry of a trace holds the instruction, rs1 and rs2. The traces written
+// by apps/ideal_dispatcher/scripts/vtrace_extract.cc are binary: the "ARAVTR01"
+// magic, then 20-byte little-endian records (u32 instruction, u64 rs1, u64
+// rs2). Text traces have one entry per line, as a single hexadecimal number of
+// up to 160 bits. Like with $readmemh, shorter numbers are right-aligned, and
+// empty lines and // comments are skipped.
+//
+// A thread parses the file ahead of the simulation into blocks of entries,
+// so that the dispatcher only pops parsed entries from memory.
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "dpi_state.h"
+#include "svdpi.h"
+
+namespace {
+
+struct VtraceEntry {
+  uint32_t insn;
+  uint64_t rs1;
+  uint64_t rs2;
+};
+
+class VtraceReader {
+ public:
+  explicit VtraceReader(const std::string &path) : path_(path) {}
+
+  ~VtraceReader() { Stop(); }
+
+  // Start (again) from the first entry
+  bool Rewind() {
+    Stop();
+    fp_ = fopen(path_.c_str(), "rb");
+    if (!fp_) {
+      fprintf(stderr, "ERROR: Could not open the vector trace %s\n",
+              path_.c_str());
+      return false;
+    }
+    char magic[sizeof(kMagic)];
+    binary_ = fread(magic, 1, sizeof(magic), fp_) == sizeof(magic) &&
+              memcmp(magic, kMagic, sizeof(magic)) == 0;
+    if (!binary_) {
+      rewind(fp_);
+    }
+    block_.clear();
+    next_ = 0;
+    line_ = 0;
+    done_ = false;
+    stop_ = false;
+    entries_ = 0;
+    prefetcher_ = std::thread(&VtraceReader::Prefetch, this);
+    return true;
+  }
+
+  bool Next(VtraceEntry &entry) {
+    if (next_ == block_.size()) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      filled_.wait(lock, [this] { return !blocks_.empty() || done_; });
+      if (blocks_.empty()) {
+        return false;
+      }
+      block_.swap(blocks_.front());
+      blocks_.pop_front();
+      next_ = 0;
+      drained_.notify_one();
+    }
+    entry = block_[next_++];
+    ++entries_;
+    return true;
+  }
+
+  uint64_t entries() const { return entries_; }
+
+  // The position in the trace is the number of entries popped
+  void Save(DpiStateWriter &w) const {
+    w.PutString(path_);
+    w.Put(entries_);
+  }
+
+  // nullptr if the state is malformed, or if the trace cannot be opened or is
+  // shorter than the restored position
+  static VtraceReader *Restore(DpiStateReader &r) {
+    std::string path;
+    uint64_t entries;
+    if (!r.GetString(path) || !r.Get(entries)) {
+      return nullptr;
+    }
+    VtraceReader *reader = new VtraceReader(path);
+    bool ok = reader->Rewind();
+    VtraceEntry entry;
+    while (ok && reader->entries() < entries) {
+      ok = reader->Next(entry);
+    }
+    if (!ok) {
+      fprintf(stderr, "ERROR: Could not restore the position in the vector "
+                      "trace %s\n", path.c_str());
+      delete reader;
+      return nullptr;
+    }
+    return reader;
+  }
+
+ private:
+  static const size_t kBlockEntries = 4096;
+  static const size_t kMaxBlocks = 4;
+  static constexpr char kMagic[8] = {'A', 'R', 'A', 'V', 'T', 'R', '0', '1'};
+
+  std::string path_;
+  FILE *fp_ = nullptr;
+  bool binary_ = false;
+  std::thread prefetcher_;
+  std::mutex mutex_;
+  std::condition_variable filled_;
+  std::condition_variable drained_;
+  // Parsed blocks, in order, and the block being consumed
+  std::deque<std::vector<VtraceEntry>> blocks_;
+  std::vector<VtraceEntry> block_;
+  size_t next_ = 0;
+  bool done_ = false;
+  bool stop_ = false;
+  uint64_t line_ = 0;
+  uint64_t entries_ = 0;
+
+  void Stop() {
+    if (prefetcher_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+      }
+      drained_.notify_one();
+      prefetcher_.join();
+    }
+    blocks_.clear();
+    if (fp_) {
+      fclose(fp_);
+      fp_ = nullptr;
+    }
+  }
+
+  // Parse the file into blocks, at most kMaxBlocks ahead of the consumer
+  void Prefetch() {
+    std::vector<VtraceEntry> block;
+    bool eof = false;
+    while (!eof) {
+      block.clear();
+      block.reserve(kBlockEntries);
+      VtraceEntry entry;
+      while (block.size() < kBlockEntries) {
+        if (!(binary_ ? ReadRecord(entry) : ParseLine(entry))) {
+          eof = true;
+          break;
+        }
+        block.push_back(entry);
+      }
+
+      std::unique_lock<std::mutex> lock(mutex_);
+      drained_.wait(lock,
+                    [this] { return blocks_.size() < kMaxBlocks || stop_; });
+      if (stop_) {
+        return;
+      }
+      if (!block.empty()) {
+        blocks_.push_back(std::move(block));
+      }
+      done_ = eof;
+      filled_.notify_one();
+    }
+  }
+
+  // Read the next binary entry, false at the end of the file
+  bool ReadRecord(VtraceEntry &entry) {
+    uint8_t rec[20];
+    size_t n = fread(rec, 1, sizeof(rec), fp_);
+    if (n != sizeof(rec)) {
+      if (n) {
+        fprintf(stderr, "WARNING: Truncated entry in the vector trace %s\n",
+                path_.c_str());
+      }
+      return false;
+    }
+    entry.insn = 0;
+    entry.rs1 = 0;
+    entry.rs2 = 0;
+    for (int b = 7; b >= 0; --b) {
+      if (b < 4) {
+        entry.insn = entry.insn << 8 | rec[b];
+      }
+      entry.rs1 = entry.rs1 << 8 | rec[4 + b];
+      entry.rs2 = entry.rs2 << 8 | rec[12 + b];
+    }
+    return true;
+  }
+
+  // Parse the next text entry, false at the end of the file
+  bool ParseLine(VtraceEntry &entry) {
+    char buf[256];
+    while (fgets(buf, sizeof(buf), fp_)) {
+      ++line_;
+      // 160-bit value, as five 32-bit words from the most significant one
+      uint32_t words[5] = {0, 0, 0, 0, 0};
+      unsigned digits = 0;
+      bool bad = false;
+      for (const char *c = buf; *c && *c != '\n'; ++c) {
+        unsigned int nibble;
+        if (*c >= '0' && *c <= '9') {
+          nibble = *c - '0';
+        } else if (*c >= 'a' && *c <= 'f') {
+          nibble = *c - 'a' + 10;
+        } else if (*c >= 'A' && *c <= 'F') {
+          nibble = *c - 'A' + 10;
+        } else if (*c == '/' && c[1] == '/') {
+          break;
+        } else if (*c == ' ' || *c == '\t' || *c == '\r' || *c == '_') {
+          continue;
+        } else {
+          bad = true;
+          break;
+        }
+        for (int w = 0; w < 4; ++w) {
+          words[w] = words[w] << 4 | words[w + 1] >> 28;
+        }
+        words[4] = words[4] << 4 | nibble;
+        ++digits;
+      }
+      if (bad || digits > 40) {
+        fprintf(stderr, "WARNING: Skipping line %lu of the vector trace %s\n",
+                (unsigned long)line_, path_.c_str());
+        continue;
+      }
+      if (digits == 0) {
+        continue;
+      }
+      entry.insn = words[0];
+      entry.rs1 = (uint64_t)words[1] << 32 | words[2];
+      entry.rs2 = (uint64_t)words[3] << 32 | words[4];
+      return true;
+    }
+    return false;
+  }
+};
+
+constexpr char VtraceReader::kMagic[8];
+
+DpiInstances<VtraceReader> readers;
+
+}  // namespace
+
+std::string vtrace_save_state() {
+  DpiStateWriter w;
+  w.Put<uint64_t>(readers.size());
+  for (size_t i = 1; i <= readers.size(); ++i) {
+    const VtraceReader *reader = readers.Get(i);
+    w.Put<uint8_t>(reader != nullptr);
+    if (reader) {
+      reader->Save(w);
+    }
+  }
+  return w.state();
+}
+
+bool vtrace_restore_state(const std::string &state) {
+  DpiStateReader r(state);
+  uint64_t size;
+  if (!r.Get(size)) {
+    return false;
+  }
+  readers.Clear();
+  for (uint64_t i = 0; i < size; ++i) {
+    uint8_t open;
+    if (!r.Get(open)) {
+      return false;
+    }
+    VtraceReader *reader = nullptr;
+    if (open && !(reader = VtraceReader::Restore(r))) {
+      return false;
+    }
+    readers.Add(reader);
+  }
+  return r.Done();
+}
+
+extern "C" {
+
+// 0 if the trace cannot be opened
+int vtrace_open(const char *path) {
+  VtraceReader *reader = new VtraceReader(path);
+  if (!reader->Rewind()) {
+    delete reader;
+    return 0;
+  }
+  return readers.Add(reader);
+}
+
+// Nothing to do if no entry was popped yet
+void vtrace_rewind(int reader) {
+  VtraceReader *r = readers.Get(reader);
+  if (r->entries()) {
+    r->Rewind();
+  }
+}
+
+// Pop the next entry, 0 at the end of the trace
+svBit vtrace_next(int reader, int *insn, long long *rs1, long long *rs2) {
+  VtraceEntry entry;
+  if (!readers.Get(reader)->Next(entry)) {
+    return 0;
+  }
+  *insn = entry.insn;
+  *rs1 = entry.rs1;
+  *rs2 = entry.rs2;
+  return 1;
+}
+
+long long vtrace_entries(int reader) { return readers.Get(reader)->entries(); }
+
+void vtrace_close(int reader) { readers.Remove(reader); }
+}
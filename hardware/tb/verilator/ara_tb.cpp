@@ -9,9 +9,19 @@
 #include <fstream>
 #include <iostream>
 
+#include "axi_monitor.h"
+#include "dpi_checkpoint.h"
+#include "perf_counters.h"
+#ifdef ARA_COSIM
+#include "spike_cosim.h"
+#endif
+#ifdef ARA_FAST_FORWARD
+#include "spike_fast_forward.h"
+#endif
 #include "verilated_toplevel.h"
 #include "verilator_memutil.h"
 #include "verilator_sim_ctrl.h"
+#include "watchdog.h"
 
 int main(int argc, char **argv) {
   // Create an instance of the DUT
@@ -22,13 +32,61 @@ int main(int argc, char **argv) {
   VerilatorSimCtrl &simctrl = VerilatorSimCtrl::GetInstance();
   simctrl.SetTop(tb, &tb->clk_i, &tb->rst_ni,
                  VerilatorSimCtrlFlags::ResetPolarityNegative);
+  simctrl.SetEventTrigger(&tb->event_trigger_o);
+  simctrl.SetExitSignal(&tb->exit_o);
+
+  // Configuration of the model, for the statistics report
+  simctrl.AddModelParameter("nr_lanes", NR_LANES);
+  simctrl.AddModelParameter("vlen", ARA_VLEN);
 
   // Initialize the DRAM
-  MemAreaLoc l2_mem = {.base=0x80000000, .size=0x00100000};
+  MemAreaLoc l2_mem = {.base=0x80000000, .size=0x01000000};
   memutil.RegisterMemoryArea(
                              "ram", "TOP.ara_tb_verilator.dut.i_ara_soc.i_dram", 64*NR_LANES/2, &l2_mem);
   simctrl.RegisterExtension(&memutil);
 
+  // Count the performance events of the design
+  PerfCounters perf_counters(&tb->perf_events_o);
+  simctrl.RegisterExtension(&perf_counters);
+
+  // Profile the AXI traffic of Ara and of the crossbar
+  AxiMonitor axi_monitor({{"vlsu", &tb->axi_probe_vlsu_o, 4 * NR_LANES},
+                          {"system", &tb->axi_probe_system_o, 4 * NR_LANES},
+                          {"l2", &tb->axi_probe_l2_o, 4 * NR_LANES}});
+  simctrl.RegisterExtension(&axi_monitor);
+
+  // Stop the simulation when it does not make forward progress anymore
+  Watchdog watchdog({&tb->cosim_commit_o,
+                     &tb->cosim_pc0_o,
+                     &tb->cosim_ara_o,
+                     &tb->axi_probe_system_o,
+                     &tb->axi_probe_vlsu_o,
+                     &tb->watchdog_ara_o,
+                     &tb->watchdog_lanes_o},
+                    NR_LANES);
+  simctrl.RegisterExtension(&watchdog);
+
+  // Keep the state of the DPI models in the checkpoints
+  DpiCheckpoint dpi_checkpoint;
+  simctrl.RegisterExtension(&dpi_checkpoint);
+
+#ifdef ARA_COSIM
+  // Check the retired instructions and the VRF against Spike
+  SpikeCosim cosim({&tb->cosim_commit_o,
+                    {&tb->cosim_pc0_o, &tb->cosim_pc1_o},
+                    {&tb->cosim_wdata0_o, &tb->cosim_wdata1_o},
+                    &tb->cosim_ara_o,
+                    &tb->cosim_vrf_eew_o},
+                   NR_LANES, ARA_VLEN);
+  simctrl.RegisterExtension(&cosim);
+#endif
+
+#ifdef ARA_FAST_FORWARD
+  // Run the setup phase of the program on Spike, after the ELF file is loaded
+  SpikeFastForward fast_forward(memutil.GetUnderlying(), l2_mem, ARA_VLEN);
+  simctrl.RegisterExtension(&fast_forward);
+#endif
+
   simctrl.SetInitialResetDelay(5);
   simctrl.SetResetDuration(5);
 
@@ -44,6 +102,9 @@ int main(int argc, char **argv) {
 
   simctrl.RunSimulation();
 
-    
+  // A batch run fails if any of its tests did
+  if (simctrl.IsBatchMode()) {
+    return simctrl.WasSimulationSuccessful() ? 0 : 1;
+  }
   return tb->dut().exit_o >> 1;
 }
@@ -0,0 +1,470 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// AXI traffic monitor of the Verilator test-bench.
+
+#include "axi_monitor.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+
+#include "dpi_state.h"
+#include "verilator_sim_ctrl.h"
+
+// This is defined by the user when verilating with --savable
+#ifndef VM_SAVABLE
+#define VM_SAVABLE 0
+#endif
+
+#if VM_SAVABLE == 1
+#include <verilated_save.h>
+#endif
+
+// Fields of an AXI probe, see ara_tb_verilator.sv
+static const QData kProbeArHs = 1ULL << 0;
+static const QData kProbeRHs = 1ULL << 1;
+static const QData kProbeRLast = 1ULL << 2;
+static const QData kProbeAwHs = 1ULL << 3;
+static const QData kProbeWHs = 1ULL << 4;
+static const QData kProbeBHs = 1ULL << 6;
+static const QData kProbeArStall = 1ULL << 56;
+static const QData kProbeRStall = 1ULL << 57;
+static const QData kProbeAwStall = 1ULL << 58;
+static const QData kProbeWStall = 1ULL << 59;
+
+static unsigned int ProbeField(QData probe, unsigned int lsb) {
+  return (probe >> lsb) & 0xff;
+}
+
+// Checkpoint state of the per-ID maps
+template <typename V>
+static void PutMap(DpiStateWriter &w, const std::map<unsigned int, V> &map) {
+  w.Put<uint64_t>(map.size());
+  for (const auto &it : map) {
+    w.Put(it.first);
+    w.Put(it.second);
+  }
+}
+
+static void PutMap(DpiStateWriter &w,
+                   const std::map<unsigned int, std::deque<unsigned long>> &map) {
+  w.Put<uint64_t>(map.size());
+  for (const auto &it : map) {
+    w.Put(it.first);
+    w.PutSequence(it.second);
+  }
+}
+
+template <typename V>
+static bool GetMap(DpiStateReader &r, std::map<unsigned int, V> &map) {
+  uint64_t size;
+  if (!r.Get(size)) {
+    return false;
+  }
+  map.clear();
+  for (uint64_t i = 0; i < size; ++i) {
+    unsigned int id;
+    if (!r.Get(id) || !r.Get(map[id])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool GetMap(DpiStateReader &r,
+                   std::map<unsigned int, std::deque<unsigned long>> &map) {
+  uint64_t size;
+  if (!r.Get(size)) {
+    return false;
+  }
+  map.clear();
+  for (uint64_t i = 0; i < size; ++i) {
+    unsigned int id;
+    if (!r.Get(id) || !r.GetSequence(map[id])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+AxiMonitor::AxiMonitor(const std::vector<Port> &ports)
+    : stats_report_(false), window_cycles_(1000), cycles_(0) {
+  for (const Port &port : ports) {
+    PortStats ps = {};
+    ps.port = port;
+    ports_.push_back(ps);
+  }
+}
+
+bool AxiMonitor::ParseCLIArguments(int argc, char **argv, bool &exit_app) {
+  const struct option long_options[] = {
+      {"axi-report", required_argument, nullptr, 'A'},
+      {"axi-timeseries", required_argument, nullptr, 'T'},
+      {"axi-window", required_argument, nullptr, 'W'},
+      {"stats-report", required_argument, nullptr, 'r'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, no_argument, nullptr, 0}};
+
+  // Reset the command parsing index in-case other utils have already parsed
+  // some arguments
+  optind = 1;
+  while (1) {
+    int c = getopt_long(argc, argv, ":h", long_options, nullptr);
+    if (c == -1) {
+      break;
+    }
+
+    // Disable error reporting by getopt
+    opterr = 0;
+
+    switch (c) {
+      case 0:
+        break;
+      case 'A':
+        report_file_ = optarg;
+        break;
+      case 'T':
+        timeseries_file_ = optarg;
+        break;
+      case 'W':
+        if (atol(optarg) < 1) {
+          std::cerr << "ERROR: The AXI window must be at least one cycle."
+                    << std::endl;
+          return false;
+        }
+        window_cycles_ = atol(optarg);
+        break;
+      case 'r':
+        // Parsed by VerilatorSimCtrl, the totals are part of the report
+        stats_report_ = true;
+        break;
+      case 'h':
+        std::cout << "AXI monitor:\n\n"
+                     "--axi-report=FILE\n"
+                     "  Profile the AXI traffic and write the profile to FILE "
+                     "as JSON\n\n"
+                     "--axi-timeseries=FILE\n"
+                     "  Write the bandwidth of every window to FILE, for "
+                     "scripts/plot2d.py --axi\n\n"
+                     "--axi-window=N\n"
+                     "  Measure the bandwidth over windows of N cycles "
+                     "(default: 1000)\n\n";
+        return true;
+      case ':':  // missing argument
+        std::cerr << "ERROR: Missing argument." << std::endl << std::endl;
+        return false;
+      case '?':
+      default:;
+        // Ignore unrecognized options since they might be consumed by
+        // other utils
+    }
+  }
+
+  return true;
+}
+
+void AxiMonitor::OnClock(unsigned long sim_time) {
+  if (!Enabled()) {
+    return;
+  }
+
+  for (PortStats &ps : ports_) {
+    Sample(ps);
+  }
+  ++cycles_;
+
+  if (cycles_ % window_cycles_ == 0) {
+    for (PortStats &ps : ports_) {
+      ps.series.push_back(ps.window);
+      ps.window = Window{cycles_, 0, 0};
+    }
+  }
+}
+
+void AxiMonitor::Sample(PortStats &ps) {
+  QData probe = *ps.port.sig_probe;
+
+  if (probe & kProbeArHs) {
+    ++ps.ar_len_hist[ProbeField(probe, 8) + 1];
+    ps.ar_pending[ProbeField(probe, 24)].push_back(cycles_);
+  }
+  if (probe & kProbeAwHs) {
+    ++ps.aw_len_hist[ProbeField(probe, 16) + 1];
+    ps.aw_pending[ProbeField(probe, 40)].push_back(cycles_);
+  }
+
+  unsigned int beats = 0;
+  if (probe & kProbeRHs) {
+    ++beats;
+    ++ps.r_beats;
+    ++ps.window.r_beats;
+    // The burst ends with its last beat, bursts of one ID are in order
+    if (probe & kProbeRLast) {
+      auto &pending = ps.ar_pending[ProbeField(probe, 32)];
+      if (!pending.empty()) {
+        Latency &l = ps.r_latency[ProbeField(probe, 32)];
+        unsigned long latency = cycles_ - pending.front();
+        pending.pop_front();
+        ++l.count;
+        l.sum += latency;
+        l.min = std::min(l.min, latency);
+        l.max = std::max(l.max, latency);
+      }
+    }
+  }
+  if (probe & kProbeWHs) {
+    ++beats;
+    ++ps.w_beats;
+    ++ps.window.w_beats;
+  }
+  ++ps.beats_hist[beats];
+
+  if (probe & kProbeBHs) {
+    auto &pending = ps.aw_pending[ProbeField(probe, 48)];
+    if (!pending.empty()) {
+      Latency &l = ps.b_latency[ProbeField(probe, 48)];
+      unsigned long latency = cycles_ - pending.front();
+      pending.pop_front();
+      ++l.count;
+      l.sum += latency;
+      l.min = std::min(l.min, latency);
+      l.max = std::max(l.max, latency);
+    }
+  }
+
+  ps.ar_stalls += !!(probe & kProbeArStall);
+  ps.r_stalls += !!(probe & kProbeRStall);
+  ps.aw_stalls += !!(probe & kProbeAwStall);
+  ps.w_stalls += !!(probe & kProbeWStall);
+}
+
+void AxiMonitor::PostExec() {
+  if (!Enabled()) {
+    return;
+  }
+
+  // Close the last, partial, window
+  if (cycles_ % window_cycles_ != 0) {
+    for (PortStats &ps : ports_) {
+      ps.series.push_back(ps.window);
+    }
+  }
+
+  std::string report_file = ReportFile(report_file_);
+  std::string timeseries_file = ReportFile(timeseries_file_);
+  if (!report_file_.empty() && WriteReport(report_file)) {
+    std::cout << "AXI profile written to " << report_file << std::endl;
+  }
+  if (!timeseries_file_.empty() && WriteTimeSeries(timeseries_file)) {
+    std::cout << "AXI bandwidth time series written to " << timeseries_file
+              << std::endl;
+  }
+}
+
+bool AxiMonitor::LoadTest(const std::string &image) {
+  // Every test of a batch is profiled on its own, the bursts in flight are
+  // dropped by the reset
+  test_image_ = image;
+  for (PortStats &ps : ports_) {
+    Port port = ps.port;
+    ps = PortStats();
+    ps.port = port;
+  }
+  cycles_ = 0;
+  return true;
+}
+
+std::string AxiMonitor::ReportFile(const std::string &file) const {
+  return test_image_.empty() ? file : TestReportFile(file, test_image_);
+}
+
+void AxiMonitor::GetStatistics(std::vector<SimStatistic> &stats) const {
+  if (!Enabled()) {
+    return;
+  }
+
+  double cycles = cycles_ ? cycles_ : 1;
+  for (const PortStats &ps : ports_) {
+    std::string name = "AXI " + ps.port.name;
+    unsigned long bytes = ps.port.beat_bytes;
+    stats.push_back({name + " read", (double)(ps.r_beats * bytes), "B"});
+    stats.push_back({name + " write", (double)(ps.w_beats * bytes), "B"});
+    stats.push_back(
+        {name + " read bandwidth", ps.r_beats * bytes / cycles, "B/cycle"});
+    stats.push_back(
+        {name + " write bandwidth", ps.w_beats * bytes / cycles, "B/cycle"});
+    stats.push_back(
+        {name + " read latency", AverageLatency(ps.r_latency), "cycles"});
+    stats.push_back(
+        {name + " write latency", AverageLatency(ps.b_latency), "cycles"});
+    stats.push_back({name + " stalls",
+                     (double)(ps.ar_stalls + ps.r_stalls + ps.aw_stalls +
+                              ps.w_stalls),
+                     "cycles"});
+  }
+}
+
+void AxiMonitor::Save(VerilatedSave &os) {
+#if VM_SAVABLE == 1
+  DpiStateWriter w;
+  w.Put(cycles_);
+  w.Put<uint64_t>(ports_.size());
+  for (const PortStats &ps : ports_) {
+    w.Put(ps.ar_len_hist);
+    w.Put(ps.aw_len_hist);
+    w.Put(ps.beats_hist);
+    w.Put(ps.r_beats);
+    w.Put(ps.w_beats);
+    w.Put(ps.ar_stalls);
+    w.Put(ps.r_stalls);
+    w.Put(ps.aw_stalls);
+    w.Put(ps.w_stalls);
+    PutMap(w, ps.ar_pending);
+    PutMap(w, ps.aw_pending);
+    PutMap(w, ps.r_latency);
+    PutMap(w, ps.b_latency);
+    w.Put(ps.window);
+    w.PutSequence(ps.series);
+  }
+  std::string state = w.state();
+  os << state;
+#endif
+}
+
+void AxiMonitor::Restore(VerilatedRestore &os) {
+#if VM_SAVABLE == 1
+  std::string state;
+  os >> state;
+  DpiStateReader r(state);
+  uint64_t nr_ports;
+  bool ok = r.Get(cycles_) && r.Get(nr_ports) && nr_ports == ports_.size();
+  for (size_t i = 0; ok && i < ports_.size(); ++i) {
+    PortStats &ps = ports_[i];
+    ok = r.Get(ps.ar_len_hist) && r.Get(ps.aw_len_hist) &&
+         r.Get(ps.beats_hist) && r.Get(ps.r_beats) && r.Get(ps.w_beats) &&
+         r.Get(ps.ar_stalls) && r.Get(ps.r_stalls) && r.Get(ps.aw_stalls) &&
+         r.Get(ps.w_stalls) && GetMap(r, ps.ar_pending) &&
+         GetMap(r, ps.aw_pending) && GetMap(r, ps.r_latency) &&
+         GetMap(r, ps.b_latency) && r.Get(ps.window) &&
+         r.GetSequence(ps.series);
+  }
+  if (!ok || !r.Done()) {
+    std::cerr << "ERROR: Could not restore the AXI monitor." << std::endl;
+    VerilatorSimCtrl::GetInstance().RequestStop(false);
+  }
+#endif
+}
+
+double AxiMonitor::AverageLatency(
+    const std::map<unsigned int, Latency> &latency) {
+  unsigned long count = 0, sum = 0;
+  for (const auto &it : latency) {
+    count += it.second.count;
+    sum += it.second.sum;
+  }
+  return count ? (double)sum / count : 0;
+}
+
+void AxiMonitor::WriteHistogram(std::ostream &os, const unsigned long *hist,
+                                size_t size, size_t offset) {
+  os << "{";
+  bool first = true;
+  for (size_t i = offset; i < size; ++i) {
+    if (!hist[i]) {
+      continue;
+    }
+    os << (first ? "" : ", ") << "\"" << i << "\": " << hist[i];
+    first = false;
+  }
+  os << "}";
+}
+
+void AxiMonitor::WriteLatencies(
+    std::ostream &os, const std::map<unsigned int, Latency> &latency) {
+  os << "{";
+  bool first = true;
+  for (const auto &it : latency) {
+    const Latency &l = it.second;
+    os << (first ? "" : ",") << std::endl
+       << "        \"" << it.first << "\": {\"count\": " << l.count
+       << ", \"avg\": " << (double)l.sum / l.count << ", \"min\": " << l.min
+       << ", \"max\": " << l.max << "}";
+    first = false;
+  }
+  os << (first ? "}" : "\n      }");
+}
+
+bool AxiMonitor::WriteReport(const std::string &file) const {
+  std::ofstream os(file);
+  if (!os) {
+    std::cerr << "ERROR: Could not open AXI report `" << file << "'."
+              << std::endl;
+    return false;
+  }
+
+  os << "{" << std::endl
+     << "  \"cycles\": " << cycles_ << "," << std::endl
+     << "  \"window_cycles\": " << window_cycles_ << "," << std::endl
+     << "  \"ports\": {";
+  bool first = true;
+  for (const PortStats &ps : ports_) {
+    unsigned long bytes = ps.port.beat_bytes;
+    double cycles = cycles_ ? cycles_ : 1;
+    os << (first ? "" : ",") << std::endl
+       << "    \"" << ps.port.name << "\": {" << std::endl
+       << "      \"beat_bytes\": " << bytes << "," << std::endl
+       << "      \"read_bytes\": " << ps.r_beats * bytes << "," << std::endl
+       << "      \"write_bytes\": " << ps.w_beats * bytes << "," << std::endl
+       << "      \"read_bandwidth\": " << ps.r_beats * bytes / cycles << ","
+       << std::endl
+       << "      \"write_bandwidth\": " << ps.w_beats * bytes / cycles << ","
+       << std::endl
+       << "      \"read_utilization\": " << ps.r_beats / cycles << ","
+       << std::endl
+       << "      \"write_utilization\": " << ps.w_beats / cycles << ","
+       << std::endl
+       << "      \"stall_cycles\": {\"ar\": " << ps.ar_stalls
+       << ", \"r\": " << ps.r_stalls << ", \"aw\": " << ps.aw_stalls
+       << ", \"w\": " << ps.w_stalls << "}," << std::endl
+       << "      \"beats_per_cycle\": ";
+    WriteHistogram(os, ps.beats_hist.data(), ps.beats_hist.size(), 0);
+    os << "," << std::endl << "      \"ar_burst_length\": ";
+    WriteHistogram(os, ps.ar_len_hist.data(), ps.ar_len_hist.size(), 1);
+    os << "," << std::endl << "      \"aw_burst_length\": ";
+    WriteHistogram(os, ps.aw_len_hist.data(), ps.aw_len_hist.size(), 1);
+    os << "," << std::endl << "      \"read_latency\": ";
+    WriteLatencies(os, ps.r_latency);
+    os << "," << std::endl << "      \"write_latency\": ";
+    WriteLatencies(os, ps.b_latency);
+    os << std::endl << "    }";
+    first = false;
+  }
+  os << std::endl << "  }" << std::endl << "}" << std::endl;
+  return true;
+}
+
+bool AxiMonitor::WriteTimeSeries(const std::string &file) const {
+  std::ofstream os(file);
+  if (!os) {
+    std::cerr << "ERROR: Could not open AXI time series `" << file << "'."
+              << std::endl;
+    return false;
+  }
+
+  // One line per port and window: port, first cycle of the window, read and
+  // write bandwidth [bytes/cycle]
+  for (const PortStats &ps : ports_) {
+    for (const Window &w : ps.series) {
+      unsigned long length = std::min(window_cycles_, cycles_ - w.cycle);
+      os << ps.port.name << " " << w.cycle << " "
+         << (double)w.r_beats * ps.port.beat_bytes / length << " "
+         << (double)w.w_beats * ps.port.beat_bytes / length << std::endl;
+    }
+  }
+  return true;
+}
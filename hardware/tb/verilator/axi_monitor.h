@@ -0,0 +1,145 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// AXI traffic monitor of the Verilator test-bench.
+
+#pragma once
+
+#include <array>
+#include <deque>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <verilated.h>
+
+#include "sim_ctrl_extension.h"
+
+/**
+ * Profile the traffic on the AXI ports of the design
+ *
+ * Each port is sampled through one of the axi_probe_*_o ports of
+ * ara_tb_verilator. The monitor histograms the burst lengths and the beats per
+ * cycle, measures the latency of the bursts per AXI ID, and the read and
+ * write bandwidth over windows of cycles.
+ *
+ * Monitoring is enabled with --axi-report=FILE, which receives the profile as
+ * JSON once the simulation has finished, and/or with --axi-timeseries=FILE,
+ * which receives the bandwidth of every window for scripts/plot2d.py. In a
+ * batch run, the files are written once each test has finished, named after
+ * the test (see TestReportFile()). The totals of every port are also part of
+ * the statistics report (--stats-report).
+ */
+class AxiMonitor : public SimCtrlExtension {
+ public:
+  /**
+   * An AXI port to monitor
+   */
+  struct Port {
+    std::string name;
+    const QData *sig_probe;
+    // Width of the data bus [bytes]
+    unsigned int beat_bytes;
+  };
+
+  explicit AxiMonitor(const std::vector<Port> &ports);
+
+  // Declared in SimCtrlExtension
+  bool ParseCLIArguments(int argc, char **argv, bool &exit_app) override;
+  void OnClock(unsigned long sim_time) override;
+  unsigned long ClockPeriod() const override { return Enabled() ? 1 : 0; }
+  void PostExec() override;
+  bool LoadTest(const std::string &image) override;
+  void GetStatistics(std::vector<SimStatistic> &stats) const override;
+  void Save(VerilatedSave &os) override;
+  void Restore(VerilatedRestore &os) override;
+
+ private:
+  static const unsigned int kMaxBurstLength = 256;
+
+  struct Latency {
+    Latency() : count(0), sum(0), min(~0UL), max(0) {}
+    unsigned long count;
+    unsigned long sum;
+    unsigned long min;
+    unsigned long max;
+  };
+
+  struct Window {
+    unsigned long cycle;
+    unsigned long r_beats;
+    unsigned long w_beats;
+  };
+
+  struct PortStats {
+    Port port;
+    std::array<unsigned long, kMaxBurstLength + 1> ar_len_hist;
+    std::array<unsigned long, kMaxBurstLength + 1> aw_len_hist;
+    // Cycles with 0, 1 and 2 beats (R and W)
+    std::array<unsigned long, 3> beats_hist;
+    unsigned long r_beats;
+    unsigned long w_beats;
+    unsigned long ar_stalls;
+    unsigned long r_stalls;
+    unsigned long aw_stalls;
+    unsigned long w_stalls;
+    // Start cycle of the outstanding bursts per ID, in order
+    std::map<unsigned int, std::deque<unsigned long>> ar_pending;
+    std::map<unsigned int, std::deque<unsigned long>> aw_pending;
+    std::map<unsigned int, Latency> r_latency;
+    std::map<unsigned int, Latency> b_latency;
+    Window window;
+    std::vector<Window> series;
+  };
+
+  std::vector<PortStats> ports_;
+  std::string report_file_;
+  std::string timeseries_file_;
+  // Monitoring for the statistics report only
+  bool stats_report_;
+  // Image of the current test of a batch run
+  std::string test_image_;
+  unsigned long window_cycles_;
+  unsigned long cycles_;
+
+  /**
+   * Is the traffic monitored (--axi-report, --axi-timeseries or
+   * --stats-report)?
+   */
+  bool Enabled() const {
+    return !report_file_.empty() || !timeseries_file_.empty() || stats_report_;
+  }
+
+  /**
+   * Account for the traffic of one port in the current cycle
+   */
+  void Sample(PortStats &ps);
+
+  /**
+   * Name of |file| for the current test, if any
+   */
+  std::string ReportFile(const std::string &file) const;
+
+  /**
+   * Write the profile to |file|
+   */
+  bool WriteReport(const std::string &file) const;
+
+  /**
+   * Write the bandwidth of every window to |file|
+   */
+  bool WriteTimeSeries(const std::string &file) const;
+
+  static void WriteHistogram(std::ostream &os,
+                             const unsigned long *hist, size_t size,
+                             size_t offset);
+  static void WriteLatencies(std::ostream &os,
+                             const std::map<unsigned int, Latency> &latency);
+
+  /**
+   * Average latency over all IDs
+   */
+  static double AverageLatency(const std::map<unsigned int, Latency> &latency);
+};
@@ -0,0 +1,45 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// Checkpoints of the DPI models of the Verilator test-bench.
+
+#include "dpi_checkpoint.h"
+
+#include <iostream>
+#include <string>
+
+#include "dpi_state.h"
+#include "verilator_sim_ctrl.h"
+
+// This is defined by the user when verilating with --savable
+#ifndef VM_SAVABLE
+#define VM_SAVABLE 0
+#endif
+
+#if VM_SAVABLE == 1
+#include <verilated_save.h>
+#endif
+
+void DpiCheckpoint::Save(VerilatedSave &os) {
+#if VM_SAVABLE == 1
+  std::string console = console_save_state();
+  std::string dram_model = dram_model_save_state();
+  std::string vtrace = vtrace_save_state();
+  os << console << dram_model << vtrace;
+#endif
+}
+
+void DpiCheckpoint::Restore(VerilatedRestore &os) {
+#if VM_SAVABLE == 1
+  std::string console, dram_model, vtrace;
+  os >> console >> dram_model >> vtrace;
+  if (!console_restore_state(console) ||
+      !dram_model_restore_state(dram_model) || !vtrace_restore_state(vtrace)) {
+    std::cerr << "ERROR: Could not restore the state of the DPI models."
+              << std::endl;
+    VerilatorSimCtrl::GetInstance().RequestStop(false);
+  }
+#endif
+}
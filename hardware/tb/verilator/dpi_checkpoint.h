@@ -0,0 +1,25 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// Checkpoints of the DPI models of the Verilator test-bench.
+
+#pragma once
+
+#include "sim_ctrl_extension.h"
+
+/**
+ * Save and restore the state of the DPI models with the simulation checkpoints
+ *
+ * The models of tb/dpi (the console, the DRAM timing model and the vector trace
+ * reader) keep their state in C++, out of the reach of Verilator's --savable.
+ * Their instances are saved with every checkpoint, and replace the ones of the
+ * restoring process, see tb/dpi/dpi_state.h.
+ */
+class DpiCheckpoint : public SimCtrlExtension {
+ public:
+  // Declared in SimCtrlExtension
+  void Save(VerilatedSave &os) override;
+  void Restore(VerilatedRestore &os) override;
+};
@@ -10,6 +10,7 @@
 #include <iostream>
 #include <libelf.h>
 #include <sstream>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <vector>
@@ -27,11 +28,56 @@ extern "C" {
 extern void simutil_memload(const char *file);
 
 /**
- * Write a 32 bit word |val| to memory at index |index|
+ * Write |num_words| words, starting at index |index|, from the segment staged
+ * with simutil_bulk_get_words()
  *
  * @return 1 if successful, 0 otherwise
  */
-extern int simutil_set_mem(int index, const svBitVecVal *val);
+extern int simutil_set_mem_bulk(int index, int num_words);
+
+/**
+ * Zero all words of a memory
+ *
+ * @return 1 if successful, 0 otherwise
+ */
+extern int simutil_clear_mem();
+}
+
+namespace {
+// Segment staged for simutil_set_mem_bulk()
+struct BulkSegment {
+  const uint8_t *data;
+  size_t size;
+  uint32_t width_byte;
+};
+BulkSegment bulk_segment = {.data = nullptr, .size = 0, .width_byte = 0};
+}  // namespace
+
+// DPI Imports
+extern "C" {
+
+/**
+ * Copy the words of the staged segment, starting at word |offset|, to the
+ * open array |words|, zero-padding past the end of the segment
+ *
+ * Called by simutil_set_mem_bulk() once for every chunk of words it writes.
+ */
+void simutil_bulk_get_words(int offset, const svOpenArrayHandle words) {
+  assert(bulk_segment.width_byte);
+  int low = svLow(words, 1);
+  int size = svSize(words, 1);
+  for (int i = 0; i < size; ++i) {
+    uint8_t *dst = static_cast<uint8_t *>(svGetArrElemPtr1(words, low + i));
+    size_t src_byte = ((size_t)offset + i) * bulk_segment.width_byte;
+    size_t len = std::min((size_t)bulk_segment.width_byte,
+                          bulk_segment.size - std::min(src_byte,
+                                                       bulk_segment.size));
+    if (len) {
+      memcpy(dst, bulk_segment.data + src_byte, len);
+    }
+    memset(dst + len, 0, 64 - len);
+  }
+}
 }
 
 namespace {
@@ -50,7 +96,8 @@ class ElfError : public std::exception {
   std::string msg_;
 };
 
-// Class wrapping an open ELF file
+// Class wrapping an open ELF file. The file is mapped into memory, so that
+// segments can be written to the memories straight from the mapping.
 class ElfFile {
  public:
   ElfFile(const std::string &path) : path_(path) {
@@ -64,14 +111,31 @@ class ElfFile {
       throw ElfError(path, "could not open file.");
     }
 
-    ptr_ = elf_begin(fd_, ELF_C_READ, NULL);
+    struct stat statbuf;
+    if (fstat(fd_, &statbuf) != 0 || statbuf.st_size == 0) {
+      close(fd_);
+      throw ElfError(path, "could not get the file size.");
+    }
+    size_ = statbuf.st_size;
+
+    // A private mapping is never written back to the file. Pages are only
+    // read, unless libelf has to convert the file in place.
+    data_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd_, 0);
+    if (data_ == MAP_FAILED) {
+      close(fd_);
+      throw ElfError(path, "could not map file.");
+    }
+
+    ptr_ = elf_memory(static_cast<char *>(data_), size_);
     if (!ptr_) {
+      munmap(data_, size_);
       close(fd_);
       throw ElfError(path, elf_errmsg(-1));
     }
 
     if (elf_kind(ptr_) != ELF_K_ELF) {
       elf_end(ptr_);
+      munmap(data_, size_);
       close(fd_);
       throw ElfError(path, "not an ELF file.");
     }
@@ -79,6 +143,7 @@ class ElfFile {
 
   ~ElfFile() {
     elf_end(ptr_);
+    munmap(data_, size_);
     close(fd_);
   }
 
@@ -97,10 +162,71 @@ class ElfFile {
     return phdrs;
   }
 
+  const uint8_t *GetData() const { return static_cast<uint8_t *>(data_); }
+  size_t GetSize() const { return size_; }
+
   std::string path_;
   int fd_;
+  void *data_;
+  size_t size_;
   Elf *ptr_;
 };
+
+// A loadable segment of an ELF file. |data| points into the mapped file and
+// holds |file_size| bytes; the segment is zero-extended up to |mem_size|.
+struct ElfSegment {
+  int idx;
+  uint64_t lma;
+  const uint8_t *data;
+  size_t file_size;
+  size_t mem_size;
+};
+
+// Get the PT_LOAD segments of |elf| that occupy memory, checking that they
+// fit in the file and in the address space. No segment data is copied.
+std::vector<ElfSegment> GetLoadSegments(ElfFile &elf) {
+  size_t phnum = elf.GetPhdrNum();
+  const Elf64_Phdr *phdrs = elf.GetPhdrs();
+
+  std::vector<ElfSegment> segs;
+  for (size_t i = 0; i < phnum; ++i) {
+    const Elf64_Phdr &phdr = phdrs[i];
+    if (phdr.p_type != PT_LOAD)
+      continue;
+
+    if (phdr.p_memsz == 0)
+      continue;
+
+    Elf64_Addr seg_top = phdr.p_paddr + (phdr.p_memsz - 1);
+    if (seg_top < phdr.p_paddr) {
+      std::ostringstream oss;
+      oss << "phdr for segment " << i << " has start 0x" << std::hex
+          << phdr.p_paddr << " and size 0x" << phdr.p_memsz
+          << ", which overflows the address space.";
+      throw ElfError(elf.path_, oss.str());
+    }
+
+    // Where does the segment finish in the file image? We don't need
+    // to worry about overflow here, because we're adding two
+    // uint32_t's into a size_t. But we do need to check the segment
+    // actually fits in the file
+    size_t off_end = (size_t)phdr.p_offset + phdr.p_filesz;
+    if (elf.GetSize() < off_end) {
+      std::ostringstream oss;
+      oss << "phdr for segment " << i << " claims to end at offset 0x"
+          << std::hex << off_end - 1 << ", but the file only has size 0x"
+          << elf.GetSize() << ".";
+      throw ElfError(elf.path_, oss.str());
+    }
+
+    segs.push_back({.idx = (int)i,
+                    .lma = phdr.p_paddr,
+                    .data = elf.GetData() + phdr.p_offset,
+                    .file_size = std::min(phdr.p_filesz, phdr.p_memsz),
+                    .mem_size = phdr.p_memsz});
+  }
+  return segs;
+}
 }  // namespace
 
 // Convert a string to a MemImageType, throwing a std::runtime_error
@@ -137,179 +263,73 @@ static MemImageType DetectMemImageType(const std::string &filepath) {
   return image_type;
 }
 
-// Generate a single array of bytes representing the contents of PT_LOAD
-// segments of the ELF file. Like objcopy, this generates a single "giant
-// segment" whose first byte corresponds to the first byte of the lowest
-// addressed segment and whose last byte corresponds to the last byte of the
-// highest address.
-static std::vector<uint8_t> FlattenElfFile(const std::string &filepath) {
-  ElfFile elf(filepath);
-
-  size_t phnum = elf.GetPhdrNum();
-  const Elf64_Phdr *phdrs = elf.GetPhdrs();
-
-  // To mimic what objcopy does (that is, the binary target of BFD), we need to
-  // iterate over all loadable program headers, find the lowest address, and
-  // then copy in our loadable data based on their offset with respect to the
-  // found base address.
-
-  bool any = false;
-  Elf64_Addr low = 0, high = 0;
-  for (size_t i = 0; i < phnum; i++) {
-    const Elf64_Phdr &phdr = phdrs[i];
-
-    if (phdr.p_type != PT_LOAD) {
-      std::cout << "Program header number " << i << " in `" << filepath
-                << "' is not of type PT_LOAD; ignoring." << std::endl;
-      continue;
-    }
-
-    if (phdr.p_memsz == 0 || phdr.p_filesz == 0) {
-      std::cout << "Program header number " << i << " in `" << filepath
-                << "' has size 0; ignoring." << std::endl;
-      continue;
-    }
-
-    if (!any || phdr.p_paddr < low) {
-      low = phdr.p_paddr;
-      std::cout << "Program header number " << i << " in `" << filepath
-                << "' low is " << std::hex << low << std::endl;
-    }
-
-    Elf64_Addr seg_top = phdr.p_paddr + (phdr.p_memsz - 1);
-    if (seg_top < phdr.p_paddr) {
-      std::ostringstream oss;
-      oss << "phdr for segment " << i << " has start 0x" << std::hex
-          << phdr.p_paddr << " and size 0x" << phdr.p_memsz
-          << ", which overflows the address space.";
-      throw ElfError(filepath, oss.str());
-    }
-
-    if (!any || seg_top > high) {
-      high = seg_top;
-      std::cout << "Program header number " << i << " in `" << filepath
-                << "' high is " << std::hex << high << std::endl;
-    }
-
-    any = true;
-  }
-
-  // If any is false, there were no segments that contributed to the
-  // file. Return nothing.
-  if (!any)
-    return std::vector<uint8_t>();
-
-  // Otherwise, we know every valid byte of data has an address in the
-  // range [low, high] (inclusive).
-  assert(low <= high);
-
-  size_t file_size;
-  const char *file_data = elf_rawfile(elf.ptr_, &file_size);
-  assert(file_data);
-
-  StagedMem ret;
-
-  for (size_t i = 0; i < phnum; i++) {
-    const Elf64_Phdr &phdr = phdrs[i];
-
-    if (phdr.p_type != PT_LOAD) {
-      continue;
-    }
-    if (phdr.p_memsz == 0 || phdr.p_filesz == 0) {
-      continue;
-    }
-
-    // Check the segment actually fits in the file
-    if (file_size < phdr.p_offset + phdr.p_filesz) {
-      std::ostringstream oss;
-      oss << "phdr for segment " << i << " claims to end at offset 0x"
-          << std::hex << phdr.p_offset + phdr.p_filesz
-          << ", but the file only has size 0x" << file_size << ".";
-      throw ElfError(filepath, oss.str());
-    }
-
-    uint64_t off = phdr.p_paddr - low;
-    uint64_t dst_len = phdr.p_memsz;
-    uint64_t src_len = std::min(phdr.p_filesz, dst_len);
-
-    if (!dst_len)
-      continue;
-
-    std::vector<uint8_t> seg(dst_len, 0);
-    memcpy(&seg[0], file_data + phdr.p_offset, src_len);
-    ret.AddSegment(off, std::move(seg));
-  }
-
-  return ret.GetFlat();
-}
-
-// Write a "segment" of data to the given memory area.
-static void WriteSegment(const MemArea &m, uint32_t offset,
-                         const std::vector<uint8_t> &data) {
+// Write a "segment" of data to the given memory area. The first |data_size|
+// bytes come from |data|, the following ones up to |mem_size| are zero.
+static void WriteSegment(const MemArea &m, uint32_t offset, const uint8_t *data,
+                         size_t data_size, size_t mem_size) {
   std::cout << "Set `" << m.name << " "
       << m.location << " "
       << m.width_byte << " "
       "0x" << std::hex << m.addr_loc.base << " "
       "0x" << std::hex << m.addr_loc.size << " "
       << "write with offset: 0x" << std::hex << offset << " "
-      << "write with size: 0x" << std::hex << data.size() << "\n";
+      << "write with size: 0x" << std::hex << mem_size << "\n";
   assert(m.width_byte <= 64);
-  assert(m.addr_loc.size == 0 || offset + data.size() <= m.addr_loc.size);
+  assert(data_size <= mem_size);
+  assert(m.addr_loc.size == 0 || offset + mem_size <= m.addr_loc.size);
   assert((offset % m.width_byte) == 0);
 
   // If this fails to set scope, it will throw an error which should
   // be caught at this function's callsite.
   SVScoped scoped(m.location.data());
 
-  // This "mini buffer" is used to transfer each write to SystemVerilog. It's
-  // not massively efficient, but doing so ensures that we pass 512 bits (64
-  // bytes) of initialised data each time. This is for simutil_set_mem (defined
-  // in prim_util_memload.svh), whose "val" argument has SystemVerilog type bit
-  // [511:0].
-  uint8_t minibuf[64];
-  memset(minibuf, 0, sizeof minibuf);
-  assert(m.width_byte <= sizeof minibuf);
+  uint32_t all_words = (mem_size + m.width_byte - 1) / m.width_byte;
+  uint32_t word_offset = offset / m.width_byte;
 
-  uint32_t all_words = (data.size() + m.width_byte - 1) / m.width_byte;
-  uint32_t full_data_words = data.size() / m.width_byte;
-  uint32_t part_data_word_len = data.size() % m.width_byte;
-  bool has_part_data_word = part_data_word_len != 0;
+  // Transfer the whole segment with a single DPI export call, instead of one
+  // simutil_set_mem call per word. The memory pulls the words (zero-padded
+  // past |data_size|) in chunks through simutil_bulk_get_words().
+  bulk_segment = {.data = data, .size = data_size, .width_byte = m.width_byte};
+  int bulk_ok = simutil_set_mem_bulk(word_offset, all_words);
+  bulk_segment = {.data = nullptr, .size = 0, .width_byte = 0};
+  if (!bulk_ok) {
+    std::ostringstream oss;
+    oss << "Could not set `" << m.name << "' memory at byte offset 0x"
+        << std::hex << offset << " (0x" << mem_size << " bytes).";
+    throw std::runtime_error(oss.str());
+  }
+}
 
-  uint32_t word_offset = offset / m.width_byte;
+// Write the PT_LOAD segments of an ELF file to the given memory area. Like
+// objcopy, the lowest addressed segment goes to the start of the memory and
+// the other segments keep their offset with respect to it. Each segment is
+// written straight from the mapped file; the gaps between segments are not
+// touched, so the load time depends on the payload and not on the address
+// span of the file.
+static void WriteElfToMem(const MemArea &m, const std::string &filepath) {
+  ElfFile elf(filepath);
+  std::vector<ElfSegment> segs = GetLoadSegments(elf);
+  if (segs.empty())
+    return;
 
-  // Copy the full data words
-  for (uint32_t i = 0; i < full_data_words; ++i) {
-    uint32_t dst_word = word_offset + i;
-    uint32_t src_byte = i * m.width_byte;
-    memcpy(minibuf, &data[src_byte], m.width_byte);
-    if (!simutil_set_mem(dst_word, (svBitVecVal *)minibuf)) {
-      std::ostringstream oss;
-      oss << "Could not set `" << m.name << "' memory at byte offset 0x"
-          << std::hex << dst_word * m.width_byte << ".";
-      throw std::runtime_error(oss.str());
-    }
+  uint64_t low = segs[0].lma;
+  for (const ElfSegment &seg : segs) {
+    low = std::min(low, seg.lma);
   }
 
-  // Copy any partial data, zeroing minibuf first to ensure that the latter
-  // bytes in the word are zero.
-  if (has_part_data_word) {
-    memset(minibuf, 0, sizeof minibuf);
-    uint32_t dst_word = word_offset + full_data_words;
-    uint32_t src_byte = full_data_words * m.width_byte;
-    memcpy(minibuf, &data[src_byte], part_data_word_len);
-    if (!simutil_set_mem(dst_word, (svBitVecVal *)minibuf)) {
+  for (const ElfSegment &seg : segs) {
+    uint64_t offset = seg.lma - low;
+    if (offset % m.width_byte) {
       std::ostringstream oss;
-      oss << "Could not set `" << m.name << "' memory at byte offset 0x"
-          << std::hex << dst_word * m.width_byte << " (partial data word).";
-      throw std::runtime_error(oss.str());
+      oss << "Segment " << seg.idx << " has LMA 0x" << std::hex << seg.lma
+          << ", which is not aligned to the word width of " << std::dec
+          << 8 * m.width_byte << " bits of memory `" << m.name << "'.";
+      throw ElfError(filepath, oss.str());
     }
+    WriteSegment(m, offset, seg.data, seg.file_size, seg.mem_size);
   }
 }
 
-static void WriteElfToMem(const MemArea &m, const std::string &filepath) {
-  WriteSegment(m, 0, FlattenElfFile(filepath));
-}
-
 static void WriteVmemToMem(const MemArea &m, const std::string &filepath) {
   SVScoped scoped(m.location.data());
   // TODO: Add error handling.
@@ -540,86 +560,105 @@ void DpiMemUtil::LoadFileToNamedMem(bool verbose, const std::string &name,
 }
 
 void DpiMemUtil::LoadElfToMemories(bool verbose, const std::string &filepath) {
-  // Load the contents of the ELF file into the staging area
-  StageElf(verbose, filepath);
+  ElfFile elf(filepath);
 
-  for (const auto &pr : staging_area_) {
-    const std::string &mem_name = pr.first;
-    const StagedMem &staged_mem = pr.second;
+  // Write every segment straight from the mapped file into its memory
+  for (const ElfSegment &seg : GetLoadSegments(elf)) {
+    const MemArea &mem_area =
+        GetRegionForSegment(filepath, seg.idx, seg.lma, seg.mem_size);
+    uint32_t local_base = seg.lma - mem_area.addr_loc.base;
 
-    auto mem_area_it = name_to_mem_.find(mem_name);
-    assert(mem_area_it != name_to_mem_.end());
+    if (verbose) {
+      std::cout << "Loading segment " << seg.idx << " from ELF file `"
+                << filepath << "' into memory `" << mem_area.name << "'."
+                << std::endl;
+    }
 
-    const MemArea &mem_area = mem_area_it->second;
+    try {
+      WriteSegment(mem_area, local_base, seg.data, seg.file_size,
+                   seg.mem_size);
+    } catch (const SVScoped::Error &err) {
+      std::cout << "No memory found at `" << err.scope_name_
+          << "' (the scope associated with region `" << mem_area.name
+          << "', used by a segment that starts at LMA 0x" << std::hex
+          << seg.lma << ")." << std::dec << std::endl;
+    }
+  }
+}
 
-    for (const auto seg_pr : staged_mem.GetSegs()) {
-      const AddrRange<uint32_t> &seg_rng = seg_pr.first;
-      const std::vector<uint8_t> &seg_data = seg_pr.second;
-      try {
-        WriteSegment(mem_area, seg_rng.lo, seg_data);
-      } catch (const SVScoped::Error &err) {
+void DpiMemUtil::ClearMemories(bool verbose) {
+  for (const auto &pr : name_to_mem_) {
+    const MemArea &m = pr.second;
+    // Only the memories in the address space receive the test images
+    if (!m.addr_loc.size) {
+      continue;
+    }
+
+    if (verbose) {
+      std::cout << "Clearing memory `" << m.name << "'." << std::endl;
+    }
+
+    // The memory zeroes itself, nothing is copied through the DPI
+    try {
+      SVScoped scoped(m.location.data());
+      if (!simutil_clear_mem()) {
         std::ostringstream oss;
-        std::cout << "No memory found at `" << err.scope_name_
-            << "' (the scope associated with region `" << mem_area.name
-            << "', used by a segment that starts at LMA 0x" << std::hex
-            << mem_area.addr_loc.base + seg_rng.lo << ").";
-        // throw std::runtime_warn(oss.str());
+        oss << "Could not clear `" << m.name << "' memory.";
+        throw std::runtime_error(oss.str());
       }
+    } catch (const SVScoped::Error &err) {
+      std::ostringstream oss;
+      oss << "No memory found at `" << err.scope_name_
+          << "' (the scope associated with region `" << m.name << "').";
+      throw std::runtime_error(oss.str());
     }
   }
 }
 
+void DpiMemUtil::WriteMemory(uint32_t addr, const uint8_t *data, size_t size) {
+  if (!size) {
+    return;
+  }
+
+  auto mem_area_it = addr_to_mem_.find(addr);
+  if (mem_area_it == addr_to_mem_.end()) {
+    std::ostringstream oss;
+    oss << "No memory region is registered that contains the address 0x"
+        << std::hex << addr << ".";
+    throw std::runtime_error(oss.str());
+  }
+  const MemArea &m = *mem_area_it->second;
+  uint32_t offset = addr - m.addr_loc.base;
+  if (size > m.addr_loc.size - offset || offset % m.width_byte) {
+    std::ostringstream oss;
+    oss << "Cannot write 0x" << std::hex << size << " bytes at offset 0x"
+        << offset << " of the memory region `" << m.name << "'.";
+    throw std::runtime_error(oss.str());
+  }
+
+  try {
+    WriteSegment(m, offset, data, size, size);
+  } catch (const SVScoped::Error &err) {
+    std::ostringstream oss;
+    oss << "No memory found at `" << err.scope_name_
+        << "' (the scope associated with region `" << m.name << "').";
+    throw std::runtime_error(oss.str());
+  }
+}
+
 void DpiMemUtil::StageElf(bool verbose, const std::string &path) {
   // Clear out anything that was in the staging area before
   staging_area_.clear();
 
   ElfFile elf(path);
 
-  size_t file_size;
-  const char *file_data = elf_rawfile(elf.ptr_, &file_size);
-  assert(file_data);
-
-  size_t phnum = elf.GetPhdrNum();
-  const Elf64_Phdr *phdrs = elf.GetPhdrs();
-
-  for (size_t i = 0; i < phnum; ++i) {
-    const Elf64_Phdr &phdr = phdrs[i];
-    if (phdr.p_type != PT_LOAD)
-      continue;
-
-    if (phdr.p_memsz == 0)
-      continue;
-
+  for (const ElfSegment &seg : GetLoadSegments(elf)) {
     const MemArea &mem_area =
-        GetRegionForSegment(path, i, phdr.p_paddr, phdr.p_memsz);
-
-    // Check that the segment is aligned correctly for the memory
-    uint32_t local_base = phdr.p_paddr - mem_area.addr_loc.base;
-    if (local_base % mem_area.width_byte) {
-      std::ostringstream oss;
-      oss << "Segment " << i << " has LMA 0x" << std::hex << phdr.p_paddr
-          << ", which starts at offset 0x" << local_base
-          << " in the memory region `" << mem_area.name
-          << "'. This offset is not aligned to the region's word width of "
-          << std::dec << 8 * mem_area.width_byte << " bits.";
-      throw ElfError(path, oss.str());
-    }
-
-    // Where does the segment finish in the file image? We don't need
-    // to worry about overflow here, because we're adding two
-    // uint32_t's into a size_t. But we do need to check the segment
-    // actually fits in the file
-    size_t off_end = (size_t)phdr.p_offset + phdr.p_filesz;
-    if (file_size < off_end) {
-      std::ostringstream oss;
-      oss << "phdr for segment " << i << " claims to end at offset 0x"
-          << std::hex << off_end - 1 << ", but the file only has size 0x"
-          << file_size << ".";
-      throw ElfError(path, oss.str());
-    }
+        GetRegionForSegment(path, seg.idx, seg.lma, seg.mem_size);
+    uint32_t local_base = seg.lma - mem_area.addr_loc.base;
 
     if (verbose) {
-      std::cout << "Loading segment " << i << " from ELF file `" << path
+      std::cout << "Loading segment " << seg.idx << " from ELF file `" << path
                 << "' into memory `" << mem_area.name << "'." << std::endl;
     }
 
@@ -627,9 +666,8 @@ void DpiMemUtil::StageElf(bool verbose, const std::string &path) {
     // there isn't one, make a new empty one.
     StagedMem &staged_mem = staging_area_[mem_area.name];
 
-    const char *seg_data = file_data + phdr.p_offset;
-    std::vector<uint8_t> vec(phdr.p_memsz, 0);
-    memcpy(&vec[0], seg_data, std::min(phdr.p_filesz, phdr.p_memsz));
+    std::vector<uint8_t> vec(seg.mem_size, 0);
+    memcpy(&vec[0], seg.data, seg.file_size);
 
     staged_mem.AddSegment(local_base, std::move(vec));
   }
@@ -678,5 +716,16 @@ const MemArea &DpiMemUtil::GetRegionForSegment(const std::string &path,
     throw ElfError(path, oss.str());
   }
 
+  // Check that the segment is aligned correctly for the memory
+  if (local_base % mem_area->width_byte) {
+    std::ostringstream oss;
+    oss << "Segment " << seg_idx << " has LMA 0x" << std::hex << lma
+        << ", which starts at offset 0x" << local_base
+        << " in the memory region `" << mem_area->name
+        << "'. This offset is not aligned to the region's word width of "
+        << std::dec << 8 * mem_area->width_byte << " bits.";
+    throw ElfError(path, oss.str());
+  }
+
   return *mem_area;
 }
@@ -67,7 +67,8 @@ class StagedMem {
  *
  * These utilities require the corresponding DPI functions:
  * simutil_memload()
- * simutil_set_mem()
+ * simutil_set_mem_bulk()
+ * simutil_clear_mem()
  * to be defined somewhere as SystemVerilog functions.
  */
 class DpiMemUtil {
@@ -78,7 +79,7 @@ class DpiMemUtil {
    * The |name| must be a unique identifier. The function will return false if
    * |name| is already used. |location| is the path to the scope of the
    * instantiated memory, which needs to support the DPI-C interfaces
-   * 'simutil_memload' and 'simutil_set_mem' used for 'vmem' and 'elf' files,
+   * 'simutil_memload' and 'simutil_set_mem_bulk' used for 'vmem' and 'elf' files,
    * respectively.
    *
    * The |width_bit| argument specifies the with in bits of the target memory
@@ -127,10 +128,29 @@ class DpiMemUtil {
   /**
    * Load an ELF file, placing segments in memories by LMA.
    *
-   * Replaces any data currently in the staging area.
+   * Segments are written straight from the mapped file, without going
+   * through the staging area.
    */
   void LoadElfToMemories(bool verbose, const std::string &filepath);
 
+  /**
+   * Zero every registered memory with a known address range.
+   *
+   * Used to bring the memories back to a clean state before loading the next
+   * image into the same simulation.
+   */
+  void ClearMemories(bool verbose);
+
+  /**
+   * Write |size| bytes of |data| at address |addr|, into the memory that
+   * contains it.
+   *
+   * |addr| must be aligned to the word width of the memory, a partial last
+   * word is zero-padded. If the write fails, raises a std::exception with
+   * information about what happened.
+   */
+  void WriteMemory(uint32_t addr, const uint8_t *data, size_t size);
+
   /**
    * Load an ELF file into a staging area in this object, which can then be
    * accessed with GetMemoryData().
@@ -159,7 +179,8 @@ class DpiMemUtil {
 
   /**
    * Find a region containing for the given segment's addresses.
-   * Raises a std::exception if none is found.
+   * Raises a std::exception if none is found, or if the segment is not
+   * aligned to the word width of the region.
    */
   const MemArea &GetRegionForSegment(const std::string &path, int seg_idx,
                                      uint32_t lma, uint32_t mem_sz) const;
@@ -6,6 +6,7 @@
 
 #include <array>
 #include <cassert>
+#include <chrono>
 #include <cstring>
 #include <getopt.h>
 #include <iostream>
@@ -84,11 +85,13 @@ static void PrintHelp() {
                "  Show help\n\n";
 }
 
-VerilatorMemUtil::VerilatorMemUtil() : allocation_(new DpiMemUtil()) {
+VerilatorMemUtil::VerilatorMemUtil()
+    : allocation_(new DpiMemUtil()), load_time_s_(0) {
   mem_util_ = allocation_.get();
 }
 
-VerilatorMemUtil::VerilatorMemUtil(DpiMemUtil *mem_util) : mem_util_(mem_util) {
+VerilatorMemUtil::VerilatorMemUtil(DpiMemUtil *mem_util)
+    : mem_util_(mem_util), load_time_s_(0) {
   assert(mem_util);
 }
 
@@ -169,6 +172,7 @@ bool VerilatorMemUtil::ParseCLIArguments(int argc, char **argv,
     }
   }
 
+  auto load_begin = std::chrono::steady_clock::now();
   for (const LoadArg &arg : load_args) {
     try {
       if (!arg.name.empty()) {
@@ -178,11 +182,45 @@ bool VerilatorMemUtil::ParseCLIArguments(int argc, char **argv,
         assert(arg.type == kMemImageElf);
         mem_util_->LoadElfToMemories(verbose, arg.filepath);
       }
+      images_.push_back(arg.filepath);
     } catch (const std::exception &err) {
       std::cerr << "ERROR: " << err.what() << std::endl;
       return false;
     }
   }
+  load_time_s_ += std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - load_begin)
+                      .count();
 
   return true;
 }
+
+bool VerilatorMemUtil::LoadTest(const std::string &image) {
+  // Nothing of the previous test may leak into this one, and the statistics
+  // are the ones of this test
+  images_.clear();
+  load_time_s_ = 0;
+  auto load_begin = std::chrono::steady_clock::now();
+  try {
+    mem_util_->ClearMemories(false);
+    mem_util_->LoadElfToMemories(false, image);
+    images_.push_back(image);
+  } catch (const std::exception &err) {
+    std::cerr << "ERROR: " << err.what() << std::endl;
+    return false;
+  }
+  load_time_s_ += std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - load_begin)
+                      .count();
+
+  return true;
+}
+
+void VerilatorMemUtil::GetStatistics(std::vector<SimStatistic> &stats) const {
+  stats.push_back(
+      {.name = "Memory load time", .value = load_time_s_, .unit = "s"});
+}
+
+void VerilatorMemUtil::GetImages(std::vector<std::string> &images) const {
+  images.insert(images.end(), images_.begin(), images_.end());
+}
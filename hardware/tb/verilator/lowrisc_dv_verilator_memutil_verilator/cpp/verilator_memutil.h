@@ -9,6 +9,8 @@
 //
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "dpi_memutil.h"
 #include "sim_ctrl_extension.h"
@@ -22,6 +24,10 @@ class VerilatorMemUtil : public SimCtrlExtension {
 
   // Declared in SimCtrlExtension
   bool ParseCLIArguments(int argc, char **argv, bool &exit_app) override;
+  void GetStatistics(std::vector<SimStatistic> &stats) const override;
+  void GetImages(std::vector<std::string> &images) const override;
+  bool LoadTest(const std::string &image) override;
+  unsigned long ClockPeriod() const override { return 0; }
 
   // Get underlying DpiMemUtil object
   DpiMemUtil *GetUnderlying() { return mem_util_; }
@@ -39,4 +45,8 @@ class VerilatorMemUtil : public SimCtrlExtension {
  private:
   DpiMemUtil *mem_util_;
   std::unique_ptr<DpiMemUtil> allocation_;
+  // Wallclock time spent loading memory images, in seconds
+  double load_time_s_;
+  // Files loaded into the memories, in order
+  std::vector<std::string> images_;
 };
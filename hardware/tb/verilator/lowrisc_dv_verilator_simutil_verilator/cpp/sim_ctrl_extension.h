@@ -5,6 +5,37 @@
 #ifndef OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_SIM_CTRL_EXTENSION_H_
 #define OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_SIM_CTRL_EXTENSION_H_
 
+#include <string>
+#include <vector>
+
+class VerilatedSave;
+class VerilatedRestore;
+
+/**
+ * A statistics value reported by an extension once the simulation has finished
+ */
+struct SimStatistic {
+  std::string name;
+  double value;
+  std::string unit;
+};
+
+/**
+ * Name of the file that receives the report on one test of a batch run
+ *
+ * The file name of the test image is inserted before the extension of |file|,
+ * e.g. perf.json becomes perf.fmatmul.json for the image bin/fmatmul.
+ */
+inline std::string TestReportFile(const std::string &file,
+                                  const std::string &image) {
+  std::string test = image.substr(image.find_last_of('/') + 1);
+  size_t dot = file.find_last_of('.');
+  if (dot == std::string::npos || dot < file.find_last_of('/') + 1) {
+    return file + "." + test;
+  }
+  return file.substr(0, dot) + "." + test + file.substr(dot);
+}
+
 class SimCtrlExtension {
  public:
   virtual ~SimCtrlExtension() = default;
@@ -28,14 +59,64 @@ class SimCtrlExtension {
   virtual void PreExec() {}
 
   /**
-   * Function to be called every clock cycle
+   * Function to be called every ClockPeriod() clock cycles
    */
   virtual void OnClock(unsigned long sim_time) {}
 
+  /**
+   * Number of clock cycles between two calls to OnClock(), 0 to never call it
+   *
+   * Queried once, after PreExec(). Extensions that do not sample the design
+   * return 0, so that the run loop skips them.
+   */
+  virtual unsigned long ClockPeriod() const { return 1; }
+
   /**
    * Function to be called after executing the simulation
+   *
+   * In a batch run, called after every test instead, in the process that ran
+   * the test. Reports written to files should be named per test then, see
+   * TestReportFile().
    */
   virtual void PostExec() {}
+
+  /**
+   * Prepare the next test of a batch run
+   *
+   * Called while the design is held in reset, with the path of the ELF file
+   * of the test (e.g. to clear and reload the memories).
+   *
+   * @return Can the test be run?
+   */
+  virtual bool LoadTest(const std::string &image) { return true; }
+
+  /**
+   * Append the statistics of the extension to |stats|
+   *
+   * Called after PostExec(). The values are reported along with the
+   * simulation statistics.
+   */
+  virtual void GetStatistics(std::vector<SimStatistic> &stats) const {}
+
+  /**
+   * Append the paths of the program images loaded by the extension to |images|
+   *
+   * The images are identified by their path and content hash in the
+   * statistics report.
+   */
+  virtual void GetImages(std::vector<std::string> &images) const {}
+
+  /**
+   * Append the extension state to a simulation checkpoint
+   */
+  virtual void Save(VerilatedSave &os) {}
+
+  /**
+   * Restore the extension state from a simulation checkpoint
+   *
+   * Called in the same order as Save() was, before the simulation starts.
+   */
+  virtual void Restore(VerilatedRestore &os) {}
 };
 
 #endif  // OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_SIM_CTRL_EXTENSION_H_
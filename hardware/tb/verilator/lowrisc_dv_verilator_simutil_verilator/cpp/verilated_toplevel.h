@@ -9,6 +9,7 @@
 #error "TOPLEVEL_NAME must be set to the name of the toplevel."
 #endif
 
+#include <string>
 #include <verilated.h>
 
 #define STR(s) #s
@@ -43,6 +44,18 @@
 #endif
 #endif
 
+// VM_SAVABLE must be set by the user when calling Verilator with --savable.
+#ifndef VM_SAVABLE
+#define VM_SAVABLE 0
+#endif
+
+#if VM_SAVABLE == 1
+#include "verilated_save.h"
+#else
+class VerilatedSave;
+class VerilatedRestore;
+#endif
+
 #if VM_TRACE == 1
 /**
  * "Base" for all tracers in Verilator with common functionality
@@ -67,6 +80,10 @@ class VerilatedTracer {
 
   void dump(vluint64_t timeui) { impl_->dump(timeui); }
 
+  void dumpvars(int level, const std::string &hier) {
+    impl_->dumpvars(level, hier);
+  }
+
   operator VM_TRACE_CLASS_NAME *() const {
     assert(impl_);
     return impl_;
@@ -87,6 +104,7 @@ class VerilatedTracer {
   void open(const char *filename){};
   void close(){};
   void dump(vluint64_t timeui) {}
+  void dumpvars(int level, const std::string &hier) {}
 };
 #endif  // VM_TRACE == 1
 
@@ -122,6 +140,8 @@ class VerilatedToplevel {
   virtual void final() = 0;
   virtual const char *name() const = 0;
   virtual void trace(VerilatedTracer &tfp, int levels, int options) = 0;
+  virtual void save(VerilatedSave &os) = 0;
+  virtual void restore(VerilatedRestore &os) = 0;
 
   /**
    * Get the Verilator-generated device under test
@@ -148,6 +168,20 @@ class TOPLEVEL_NAME : public VERILATED_TOPLEVEL_NAME, public VerilatedToplevel {
                                    levels, options);
 #else
     assert(0 && "Tracing not enabled.");
+#endif
+  }
+  void save(VerilatedSave &os) {
+#if VM_SAVABLE == 1
+    os << static_cast<VERILATED_TOPLEVEL_NAME &>(*this);
+#else
+    assert(0 && "Model not verilated with --savable.");
+#endif
+  }
+  void restore(VerilatedRestore &os) {
+#if VM_SAVABLE == 1
+    os >> static_cast<VERILATED_TOPLEVEL_NAME &>(*this);
+#else
+    assert(0 && "Model not verilated with --savable.");
 #endif
   }
 };
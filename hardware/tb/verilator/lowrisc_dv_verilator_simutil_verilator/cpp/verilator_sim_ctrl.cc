@@ -4,10 +4,25 @@
 
 #include "verilator_sim_ctrl.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
 #include <getopt.h>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <poll.h>
+#include <sched.h>
 #include <signal.h>
+#include <sstream>
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <verilated.h>
 
 // This is defined by Verilator and passed through the command line
@@ -15,6 +30,11 @@
 #define VM_TRACE 0
 #endif
 
+// This is defined by the user when verilating with --savable
+#ifndef VM_SAVABLE
+#define VM_SAVABLE 0
+#endif
+
 /**
  * Get the current simulation time
  *
@@ -34,6 +54,144 @@ void vl_stop(const char *filename, int linenum, const char *hier) VL_MT_UNSAFE {
 }
 #endif
 
+/**
+ * Get the IDs of all threads of this process, in ascending order
+ */
+static std::vector<pid_t> GetThreadIds() {
+  std::vector<pid_t> tids;
+  DIR *dir = opendir("/proc/self/task");
+  if (!dir) {
+    return tids;
+  }
+  while (struct dirent *ent = readdir(dir)) {
+    if (ent->d_name[0] == '.') {
+      continue;
+    }
+    tids.push_back(atoi(ent->d_name));
+  }
+  closedir(dir);
+  std::sort(tids.begin(), tids.end());
+  return tids;
+}
+
+/**
+ * Escape a string for use in a JSON document
+ */
+static std::string JsonEscape(const std::string &str) {
+  std::ostringstream os;
+  for (char c : str) {
+    switch (c) {
+      case '"':
+        os << "\\\"";
+        break;
+      case '\\':
+        os << "\\\\";
+        break;
+      case '\n':
+        os << "\\n";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          os << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+             << static_cast<int>(c) << std::dec;
+        } else {
+          os << c;
+        }
+    }
+  }
+  return os.str();
+}
+
+/**
+ * Escape a string for use in an XML document
+ */
+static std::string XmlEscape(const std::string &str) {
+  std::ostringstream os;
+  for (char c : str) {
+    switch (c) {
+      case '<':
+        os << "&lt;";
+        break;
+      case '>':
+        os << "&gt;";
+        break;
+      case '&':
+        os << "&amp;";
+        break;
+      case '"':
+        os << "&quot;";
+        break;
+      default:
+        os << c;
+    }
+  }
+  return os.str();
+}
+
+/**
+ * Quote a field of a CSV document if needed
+ */
+static std::string CsvEscape(const std::string &str) {
+  if (str.find_first_of(",\"\n") == std::string::npos) {
+    return str;
+  }
+  std::string quoted = "\"";
+  for (char c : str) {
+    quoted += c;
+    if (c == '"') {
+      quoted += c;
+    }
+  }
+  return quoted + "\"";
+}
+
+/**
+ * Format a number without losing digits: integral values, e.g. counts, as
+ * integers, the other ones with 17 significant digits
+ */
+static std::string ExactNumber(double value) {
+  std::ostringstream os;
+  if (std::isfinite(value) && value == std::trunc(value) &&
+      std::fabs(value) < 9.2e18) {
+    os << (long long)value;
+  } else {
+    os << std::setprecision(17) << value;
+  }
+  return os.str();
+}
+
+/**
+ * Format a number for a JSON document, which has no infinities or NaNs
+ */
+static std::string JsonNumber(double value) {
+  if (!std::isfinite(value)) {
+    return "null";
+  }
+  return ExactNumber(value);
+}
+
+/**
+ * Hash the content of a file with 64-bit FNV-1a
+ *
+ * @return The hash as 16 hexadecimal digits, empty if the file cannot be read
+ */
+static std::string HashFile(const std::string &path) {
+  std::ifstream is(path, std::ios::binary);
+  if (!is) {
+    return "";
+  }
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  char buf[65536];
+  while (is.read(buf, sizeof(buf)) || is.gcount()) {
+    for (std::streamsize i = 0; i < is.gcount(); ++i) {
+      hash = (hash ^ (unsigned char)buf[i]) * 0x100000001b3ULL;
+    }
+  }
+  std::ostringstream os;
+  os << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return os.str();
+}
+
 VerilatorSimCtrl &VerilatorSimCtrl::GetInstance() {
   static VerilatorSimCtrl instance;
   return instance;
@@ -45,6 +203,23 @@ void VerilatorSimCtrl::SetTop(VerilatedToplevel *top, CData *sig_clk,
   sig_clk_ = sig_clk;
   sig_rst_ = sig_rst;
   flags_ = flags;
+
+  // The worker pool of a multi-threaded model is created with the model. This
+  // assumes that no other thread was started before the model was constructed:
+  // the threads started later, e.g. the FST writers or the prefetcher of the
+  // vector trace reader, are not part of the model.
+  model_tids_ = GetThreadIds();
+}
+
+void VerilatorSimCtrl::SetEventTrigger(QData *sig_event_trigger) {
+  sig_event_trigger_ = sig_event_trigger;
+}
+
+void VerilatorSimCtrl::SetExitSignal(QData *sig_exit) { sig_exit_ = sig_exit; }
+
+void VerilatorSimCtrl::AddModelParameter(const std::string &name,
+                                         unsigned long value) {
+  model_params_.push_back(std::make_pair(name, value));
 }
 
 std::pair<int, bool> VerilatorSimCtrl::Exec(int argc, char **argv) {
@@ -64,11 +239,23 @@ bool VerilatorSimCtrl::ParseCommandArgs(int argc, char **argv, bool &exit_app) {
   const struct option long_options[] = {
       {"term-after-cycles", required_argument, nullptr, 'c'},
       {"trace", no_argument, nullptr, 't'},
+      {"trace-start", required_argument, nullptr, 's'},
+      {"trace-end", required_argument, nullptr, 'e'},
+      {"trace-scope", required_argument, nullptr, 'S'},
+      {"pin-threads", required_argument, nullptr, 'p'},
+      {"checkpoint", required_argument, nullptr, 'k'},
+      {"restore", required_argument, nullptr, 'R'},
+      {"batch", required_argument, nullptr, 'b'},
+      {"batch-report", required_argument, nullptr, 'B'},
+      {"junit-report", required_argument, nullptr, 'J'},
+      {"batch-logs", required_argument, nullptr, 'L'},
+      {"jobs", required_argument, nullptr, 'j'},
+      {"stats-report", required_argument, nullptr, 'r'},
       {"help", no_argument, nullptr, 'h'},
       {nullptr, no_argument, nullptr, 0}};
 
   while (1) {
-    int c = getopt_long(argc, argv, ":c:th", long_options, nullptr);
+    int c = getopt_long(argc, argv, ":c:j:th", long_options, nullptr);
     if (c == -1) {
       break;
     }
@@ -86,11 +273,77 @@ bool VerilatorSimCtrl::ParseCommandArgs(int argc, char **argv, bool &exit_app) {
           exit_app = true;
           return false;
         }
+        trace_requested_ = true;
         TraceOn();
         break;
+      case 's':
+      case 'e':
+      case 'S':
+        if (!tracing_possible_) {
+          std::cerr << "ERROR: Tracing has not been enabled at compile time."
+                    << std::endl;
+          exit_app = true;
+          return false;
+        }
+        trace_requested_ = true;
+        if (c == 's') {
+          trace_start_cycle_ = atol(optarg);
+        } else if (c == 'e') {
+          trace_end_cycle_ = atol(optarg);
+        } else {
+          trace_scopes_.push_back(optarg);
+        }
+        break;
       case 'c':
         term_after_cycles_ = atoi(optarg);
         break;
+      case 'p':
+        pin_threads_first_cpu_ = atoi(optarg);
+        if (pin_threads_first_cpu_ < 0) {
+          std::cerr << "ERROR: Invalid CPU index for --pin-threads."
+                    << std::endl;
+          exit_app = true;
+          return false;
+        }
+        break;
+      case 'k':
+      case 'R':
+        if (!checkpoint_possible_) {
+          std::cerr << "ERROR: Checkpoints have not been enabled at compile "
+                       "time."
+                    << std::endl;
+          exit_app = true;
+          return false;
+        }
+        if (c == 'k') {
+          checkpoint_file_ = optarg;
+        } else {
+          restore_file_ = optarg;
+        }
+        break;
+      case 'b':
+        batch_file_ = optarg;
+        break;
+      case 'B':
+        batch_report_file_ = optarg;
+        break;
+      case 'J':
+        batch_junit_file_ = optarg;
+        break;
+      case 'L':
+        batch_log_dir_ = optarg;
+        break;
+      case 'j':
+        if (atoi(optarg) < 1) {
+          std::cerr << "ERROR: Invalid number of jobs for --jobs." << std::endl;
+          exit_app = true;
+          return false;
+        }
+        batch_jobs_ = atoi(optarg);
+        break;
+      case 'r':
+        stats_report_file_ = optarg;
+        break;
       case 'h':
         PrintHelp();
         exit_app = true;
@@ -106,6 +359,17 @@ bool VerilatorSimCtrl::ParseCommandArgs(int argc, char **argv, bool &exit_app) {
     }
   }
 
+  if (IsBatchMode() && (!checkpoint_file_.empty() || !restore_file_.empty())) {
+    std::cerr << "ERROR: Checkpoints cannot be used in batch mode." << std::endl;
+    exit_app = true;
+    return false;
+  }
+  if (batch_jobs_ > 1 && trace_requested_) {
+    std::cerr << "ERROR: Tracing cannot be combined with --jobs." << std::endl;
+    exit_app = true;
+    return false;
+  }
+
   // Pass args to verilator
   Verilated::commandArgs(argc, argv);
 
@@ -135,14 +399,25 @@ void VerilatorSimCtrl::RunSimulation() {
   for (auto it = extension_array_.begin(); it != extension_array_.end(); ++it) {
     (*it)->PreExec();
   }
+  ScheduleExtensions();
   // Run the simulation
-  Run();
-  // Call all extension post-exec methods
-  for (auto it = extension_array_.begin(); it != extension_array_.end(); ++it) {
-    (*it)->PostExec();
+  if (IsBatchMode()) {
+    RunBatch();
+  } else {
+    Run();
+  }
+  // Call all extension post-exec methods, after every test of a batch run
+  if (!IsBatchMode()) {
+    for (auto it = extension_array_.begin(); it != extension_array_.end();
+         ++it) {
+      (*it)->PostExec();
+    }
   }
   // Print simulation speed info
   PrintStatistics();
+  if (!stats_report_file_.empty() && !WriteStatsReport()) {
+    simulation_success_ = false;
+  }
   // Print helper message for tracing
   if (TracingEverEnabled()) {
     std::cout << std::endl
@@ -161,26 +436,57 @@ void VerilatorSimCtrl::SetResetDuration(unsigned int cycles) {
 
 void VerilatorSimCtrl::RequestStop(bool simulation_success) {
   request_stop_ = true;
+  stop_loop_ = true;
   simulation_success_ &= simulation_success;
 }
 
+void VerilatorSimCtrl::NotifyFinish() {
+  Verilated::gotFinish(true);
+  stop_loop_ = true;
+}
+
+#ifdef VL_USER_FINISH
+// Replaces Verilator's handler of $finish(), so that the run loop only has to
+// check stop_loop_
+void vl_finish(const char *filename, int linenum, const char *hier) {
+  std::cout << "- " << filename << ":" << linenum << ": Verilog $finish"
+            << std::endl;
+  VerilatorSimCtrl::GetInstance().NotifyFinish();
+}
+#endif
+
 void VerilatorSimCtrl::RegisterExtension(SimCtrlExtension *ext) {
   extension_array_.push_back(ext);
 }
 
 VerilatorSimCtrl::VerilatorSimCtrl()
     : top_(nullptr),
+      sig_event_trigger_(nullptr),
+      sig_exit_(nullptr),
+      event_trigger_q_(0),
       time_(0),
+      time_restored_(0),
       tracing_enabled_(false),
       tracing_enabled_changed_(false),
       tracing_ever_enabled_(false),
       tracing_possible_(VM_TRACE),
+      trace_requested_(false),
+      checkpoint_possible_(VM_SAVABLE),
+      trace_start_cycle_(-1),
+      trace_end_cycle_(-1),
+      batch_report_file_("batch_report.json"),
+      batch_log_dir_("."),
+      batch_jobs_(1),
+      stop_reason_(kStopFinish),
       initial_reset_delay_cycles_(2),
       reset_duration_cycles_(2),
       request_stop_(false),
+      stop_loop_(false),
       simulation_success_(true),
+      trace_time_(0),
       tracer_(VerilatedTracer()),
-      term_after_cycles_(0) {}
+      term_after_cycles_(0),
+      pin_threads_first_cpu_(-1) {}
 
 void VerilatorSimCtrl::RegisterSignalHandler() {
   struct sigaction sigIntHandler;
@@ -214,10 +520,51 @@ void VerilatorSimCtrl::PrintHelp() const {
   std::cout << "Execute a simulation model for " << GetName() << "\n\n";
   if (tracing_possible_) {
     std::cout << "-t|--trace\n"
-                 "  Write a trace file from the start\n\n";
+                 "  Write a trace file from the start\n\n"
+                 "--trace-start=CYCLE\n"
+                 "  Start tracing at CYCLE\n\n"
+                 "--trace-end=CYCLE\n"
+                 "  Stop tracing at CYCLE\n\n"
+                 "--trace-scope=SCOPE\n"
+                 "  Only trace the signals below SCOPE, e.g.\n"
+                 "  TOP.ara_tb_verilator.dut. Can be given more than once.\n\n"
+                 "Once tracing is requested with any of the options above, the\n"
+                 "software starts (stops) tracing by writing "
+              << kEventTriggerTraceOn << " (-1) to the\n"
+                 "event_trigger register.\n\n";
+  }
+  if (checkpoint_possible_) {
+    std::cout << "--checkpoint=FILE\n"
+                 "  Save the simulation state to FILE when the software writes "
+              << kEventTriggerCheckpoint
+              << "\n"
+                 "  to the event_trigger register\n\n"
+                 "--restore=FILE\n"
+                 "  Resume the simulation from the state saved in FILE\n\n";
   }
   std::cout << "-c|--term-after-cycles=N\n"
                "  Terminate simulation after N cycles\n\n"
+               "--batch=FILE\n"
+               "  Run all test images listed in FILE (one per line) one after\n"
+               "  the other, resetting the design in between\n\n"
+               "--batch-report=FILE\n"
+               "  Write the results of a batch run to FILE (default: "
+               "batch_report.json)\n\n"
+               "--junit-report=FILE\n"
+               "  Also write the results of a batch run to FILE as JUnit XML\n\n"
+               "-j N|--jobs=N\n"
+               "  Run up to N tests of a batch in parallel, in processes forked\n"
+               "  from the model once it has been reset\n\n"
+               "--batch-logs=DIR\n"
+               "  Write the output of each test run by --jobs to DIR/TEST.log\n"
+               "  (default: .)\n\n"
+               "--stats-report=FILE\n"
+               "  Write the model parameters, the program images, the\n"
+               "  simulation speed and the statistics of the extensions to\n"
+               "  FILE, as CSV if FILE ends with .csv, as JSON otherwise\n\n"
+               "--pin-threads=CPU\n"
+               "  Pin the main thread to CPU and the model worker threads to\n"
+               "  the following CPUs\n\n"
                "-h|--help\n"
                "  Show help\n\n"
                "All arguments are passed to the design and can be used "
@@ -245,18 +592,56 @@ bool VerilatorSimCtrl::TraceOff() {
 }
 
 void VerilatorSimCtrl::PrintStatistics() const {
-  double speed_hz = time_ / 2 / (GetExecutionTimeMs() / 1000.0);
+  // Cycles simulated before a restored checkpoint do not count
+  unsigned long cycles = (time_ - time_restored_) / 2;
+  double speed_hz = cycles / (GetExecutionTimeMs() / 1000.0);
   double speed_khz = speed_hz / 1000.0;
 
   std::cout << std::endl
             << "Simulation statistics" << std::endl
             << "=====================" << std::endl
-            << "Executed cycles:  " << time_ / 2 << std::endl
+            << "Executed cycles:  " << cycles << std::endl
             << "Wallclock time:   " << GetExecutionTimeMs() / 1000.0 << " s"
             << std::endl
             << "Simulation speed: " << speed_hz << " cycles/s "
             << "(" << speed_khz << " kHz)" << std::endl;
 
+  for (const SimStatistic &stat : GetStatistics()) {
+    std::cout << std::left << std::setw(18) << stat.name + ":" << std::right
+              << stat.value;
+    if (!stat.unit.empty()) {
+      std::cout << " " << stat.unit;
+    }
+    std::cout << std::endl;
+  }
+
+  // Per-thread CPU time, only meaningful for multi-threaded models. The
+  // workers of the model spin while they wait for each other, so this is no
+  // measure of the load balance of the model.
+  if (thread_stats_.size() > 1) {
+    double wallclock_s = GetExecutionTimeMs() / 1000.0;
+    for (const ThreadStat &stat : thread_stats_) {
+      std::cout << "Thread " << stat.tid << " ("
+                << (stat.model ? "model" : "other") << ", CPU " << stat.cpu
+                << ") CPU time: " << stat.cpu_time_s << " s";
+      if (wallclock_s > 0) {
+        std::cout << " (" << 100.0 * stat.cpu_time_s / wallclock_s
+                  << " % of wallclock)";
+      }
+      std::cout << std::endl;
+    }
+  }
+
+  if (TracingEverEnabled()) {
+    double wallclock_s = GetExecutionTimeMs() / 1000.0;
+    double trace_s = std::chrono::duration<double>(trace_time_).count();
+    std::cout << "Trace overhead:   " << trace_s << " s";
+    if (wallclock_s > 0) {
+      std::cout << " (" << 100.0 * trace_s / wallclock_s << " % of wallclock)";
+    }
+    std::cout << std::endl;
+  }
+
   int trace_size_byte;
   if (tracing_enabled_ && FileSize(GetTraceFileName(), trace_size_byte)) {
     std::cout << "Trace file size:  " << trace_size_byte << " B" << std::endl;
@@ -271,9 +656,7 @@ const char *VerilatorSimCtrl::GetTraceFileName() const {
 #endif
 }
 
-void VerilatorSimCtrl::Run() {
-  assert(top_ && "Use SetTop() first.");
-
+bool VerilatorSimCtrl::Init() {
   // We always need to enable this as tracing can be enabled at runtime
   if (tracing_possible_) {
     Verilated::traceEverOn(true);
@@ -282,65 +665,753 @@ void VerilatorSimCtrl::Run() {
 
   Trace();
 
+  if (!restore_file_.empty() && !RestoreCheckpoint()) {
+    time_begin_ = time_end_ = std::chrono::steady_clock::now();
+    return false;
+  }
+
   // Evaluate all initial blocks, including the DPI setup routines
   top_->eval();
 
+  // The thread pool of a multi-threaded model exists once the model is
+  // constructed, see SetTop()
+  if (pin_threads_first_cpu_ >= 0) {
+    PinThreads();
+  }
+
   std::cout << std::endl
             << "Simulation running, end by pressing CTRL-c." << std::endl;
 
   time_begin_ = std::chrono::steady_clock::now();
-  UnsetReset();
+  return true;
+}
 
-  unsigned long start_reset_cycle_ = initial_reset_delay_cycles_;
-  unsigned long end_reset_cycle_ = start_reset_cycle_ + reset_duration_cycles_;
+void VerilatorSimCtrl::Finish() {
+  top_->final();
 
-  while (1) {
-    unsigned long cycle_ = time_ / 2;
+  // Closing the trace waits for the writer thread to drain its buffers
+  if (TracingEverEnabled()) {
+    auto close_begin = std::chrono::steady_clock::now();
+    tracer_.close();
+    trace_time_ += std::chrono::steady_clock::now() - close_begin;
+  }
 
-    if (cycle_ == start_reset_cycle_) {
-      SetReset();
-    } else if (cycle_ == end_reset_cycle_) {
-      UnsetReset();
+  time_end_ = std::chrono::steady_clock::now();
+
+  CollectThreadStatistics();
+}
+
+void VerilatorSimCtrl::ScheduleExtensions() {
+  clocked_extensions_.clear();
+  for (auto it = extension_array_.begin(); it != extension_array_.end(); ++it) {
+    unsigned long period = (*it)->ClockPeriod();
+    if (period) {
+      clocked_extensions_.push_back(ClockedExtension{*it, period, 0});
     }
+  }
+}
+
+void VerilatorSimCtrl::Cycle(unsigned long cycle) {
+  // Rising edge, with the extensions that are due
+  *sig_clk_ = 1;
+  for (ClockedExtension &ce : clocked_extensions_) {
+    if (cycle >= ce.next_cycle) {
+      ce.ext->OnClock(time_);
+      ce.next_cycle = cycle + ce.period;
+    }
+  }
+
+  top_->eval();
+  time_++;
+
+  Trace();
+
+  if (sig_event_trigger_ && *sig_event_trigger_ != event_trigger_q_) {
+    event_trigger_q_ = *sig_event_trigger_;
+    OnEventTrigger(event_trigger_q_);
+  }
+
+  FallingEdge();
+}
 
-    *sig_clk_ = !*sig_clk_;
+void VerilatorSimCtrl::FallingEdge() {
+  // It cannot be skipped: Verilator detects the edges against the value of the
+  // clock at the previous evaluation, and the clock gates latch their enable
+  // while the clock is low.
+  *sig_clk_ = 0;
+  top_->eval();
+  time_++;
+
+  Trace();
+}
+
+VerilatorSimCtrl::StopReason VerilatorSimCtrl::RunLoop(bool reset) {
+  // A checkpoint saved on the event trigger resumes after the rising edge
+  if (time_ & 1) {
+    FallingEdge();
+  }
+
+  unsigned long first_cycle = time_ / 2;
+  unsigned long start_reset_cycle = first_cycle + initial_reset_delay_cycles_;
+  unsigned long end_reset_cycle = start_reset_cycle + reset_duration_cycles_;
+  unsigned long timeout_cycle =
+      term_after_cycles_ ? first_cycle + term_after_cycles_ : ULONG_MAX;
 
-    // Call all extension on-clock methods
-    if (*sig_clk_) {
-      for (auto it = extension_array_.begin(); it != extension_array_.end();
-           ++it) {
-        (*it)->OnClock(time_);
+  unsigned long cycle = first_cycle;
+  while (1) {
+    if (reset) {
+      if (cycle == start_reset_cycle) {
+        SetReset();
+      } else if (cycle == end_reset_cycle) {
+        UnsetReset();
       }
     }
 
-    top_->eval();
-    time_++;
+    // Tracing window given on the command line
+    if ((long)cycle == trace_start_cycle_) {
+      TraceOn();
+    } else if ((long)cycle == trace_end_cycle_) {
+      TraceOff();
+    }
 
-    Trace();
+    // The cycles up to the next reset, tracing or timeout event only check
+    // for a stop request or $finish(), with a single flag if Verilator reports
+    // $finish() through vl_finish()
+    unsigned long next_event = timeout_cycle;
+    for (long event : {reset ? (long)start_reset_cycle : -1L,
+                       reset ? (long)end_reset_cycle : -1L, trace_start_cycle_,
+                       trace_end_cycle_}) {
+      if (event > (long)cycle && (unsigned long)event < next_event) {
+        next_event = event;
+      }
+    }
+    stop_loop_ = request_stop_ || Verilated::gotFinish();
+    do {
+      Cycle(cycle++);
+#ifdef VL_USER_FINISH
+    } while (cycle < next_event && !stop_loop_);
+#else
+    } while (cycle < next_event && !stop_loop_ && !Verilated::gotFinish());
+#endif
 
     if (request_stop_) {
       std::cout << "Received stop request, shutting down simulation."
                 << std::endl;
-      break;
+      return kStopRequested;
     }
     if (Verilated::gotFinish()) {
       std::cout << "Received $finish() from Verilog, shutting down simulation."
                 << std::endl;
-      break;
+      return kStopFinish;
     }
-    if (term_after_cycles_ && (time_ / 2 >= term_after_cycles_)) {
+    if (cycle >= timeout_cycle) {
       std::cout << "Simulation timeout of " << term_after_cycles_
                 << " cycles reached, shutting down simulation." << std::endl;
+      return kStopTimeout;
+    }
+  }
+}
+
+void VerilatorSimCtrl::Run() {
+  assert(top_ && "Use SetTop() first.");
+
+  if (!Init()) {
+    return;
+  }
+
+  UnsetReset();
+  // A restored checkpoint has gone through the reset sequence already
+  stop_reason_ = RunLoop(restore_file_.empty());
+
+  Finish();
+}
+
+void VerilatorSimCtrl::RunBatch() {
+  assert(top_ && "Use SetTop() first.");
+  assert(sig_exit_ && "Use SetExitSignal() first.");
+
+  std::ifstream batch_file(batch_file_);
+  if (!batch_file) {
+    std::cerr << "ERROR: Could not open batch file `" << batch_file_ << "'."
+              << std::endl;
+    simulation_success_ = false;
+    return;
+  }
+
+  // One image per line, empty lines and lines starting with '#' are skipped
+  batch_results_.clear();
+  std::string line;
+  while (std::getline(batch_file, line)) {
+    size_t first = line.find_first_not_of(" \t");
+    if (first == std::string::npos || line[first] == '#') {
+      continue;
+    }
+    size_t last = line.find_last_not_of(" \t\r");
+    std::string image = line.substr(first, last - first + 1);
+
+    BatchResult result = {.image = image,
+                          .log = "",
+                          .status = "skipped",
+                          .exit_code = 0,
+                          .cycles = 0,
+                          .wallclock_s = 0,
+                          .stats = {}};
+    if (batch_jobs_ > 1) {
+      result.log =
+          batch_log_dir_ + "/" + image.substr(image.find_last_of('/') + 1) +
+          ".log";
+    }
+    batch_results_.push_back(result);
+  }
+
+  if (!Init()) {
+    return;
+  }
+
+  if (batch_jobs_ > 1) {
+    RunBatchForked();
+  } else {
+    RunBatchSerial();
+  }
+
+  Finish();
+
+  unsigned int passed = 0;
+  for (const BatchResult &result : batch_results_) {
+    passed += result.status == "pass";
+  }
+  std::cout << std::endl
+            << "Batch run: " << passed << " of " << batch_results_.size()
+            << " tests passed." << std::endl;
+  if (passed != batch_results_.size()) {
+    simulation_success_ = false;
+  }
+
+  if (!WriteBatchReport()) {
+    simulation_success_ = false;
+  }
+  if (!batch_junit_file_.empty() && !WriteBatchJUnit()) {
+    simulation_success_ = false;
+  }
+}
+
+void VerilatorSimCtrl::RunBatchSerial() {
+  for (BatchResult &result : batch_results_) {
+    // A stop request aborts the whole batch
+    if (request_stop_) {
       break;
     }
+
+    std::cout << std::endl << "Running test " << result.image << std::endl;
+    auto test_begin = std::chrono::steady_clock::now();
+
+    HoldReset();
+    RunBatchTest(result);
+
+    result.wallclock_s = std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::steady_clock::now() - test_begin)
+                             .count() /
+                         1000.0;
+    std::cout << "Test " << result.image << ": " << result.status << " ("
+              << result.cycles << " cycles)" << std::endl;
+  }
+}
+
+void VerilatorSimCtrl::RunBatchForked() {
+  // fork() only duplicates the calling thread
+  if (GetThreadIds().size() > 1) {
+    std::cerr << "ERROR: --jobs requires a single-threaded model." << std::endl;
+    simulation_success_ = false;
+    return;
+  }
+
+  // All workers start from the same state, at the end of the reset sequence
+  HoldReset();
+
+  struct Worker {
+    size_t idx;
+    int result_fd;
+    std::chrono::steady_clock::time_point begin;
+    // Result received so far
+    std::string msg;
+  };
+  std::map<pid_t, Worker> workers;
+  size_t next = 0;
+
+  while (1) {
+    while (!request_stop_ && workers.size() < batch_jobs_ &&
+           next < batch_results_.size()) {
+      BatchResult &result = batch_results_[next];
+
+      int fds[2];
+      if (pipe(fds) != 0) {
+        std::cerr << "ERROR: Could not create a pipe for test `"
+                  << result.image << "'." << std::endl;
+        RequestStop(false);
+        break;
+      }
+
+      // Buffered output would be written by the worker, too
+      std::cout.flush();
+      std::cerr.flush();
+      fflush(nullptr);
+
+      pid_t pid = fork();
+      if (pid < 0) {
+        std::cerr << "ERROR: Could not fork a worker for test `"
+                  << result.image << "'." << std::endl;
+        close(fds[0]);
+        close(fds[1]);
+        RequestStop(false);
+        break;
+      }
+      if (pid == 0) {
+        close(fds[0]);
+        RunBatchWorker(result, fds[1]);
+      }
+
+      close(fds[1]);
+      workers[pid] = {.idx = next,
+                      .result_fd = fds[0],
+                      .begin = std::chrono::steady_clock::now()};
+      std::cout << "Started test " << result.image << " (log: " << result.log
+                << ")" << std::endl;
+      ++next;
+    }
+
+    if (workers.empty()) {
+      break;
+    }
+
+    // The results are read while the workers run: a worker blocks on a
+    // result bigger than the pipe buffer until it is read. A worker is reaped
+    // once its end of the pipe is closed, right before it exits (or when it
+    // crashes).
+    std::vector<struct pollfd> fds;
+    for (const auto &worker : workers) {
+      fds.push_back({.fd = worker.second.result_fd, .events = POLLIN});
+    }
+    if (poll(fds.data(), fds.size(), -1) < 0) {
+      // Interrupted by a signal, e.g. a stop request
+      if (errno == EINTR) {
+        continue;
+      }
+      std::cerr << "ERROR: Lost track of the worker processes." << std::endl;
+      RequestStop(false);
+      break;
+    }
+
+    auto it = workers.begin();
+    for (size_t i = 0; i < fds.size(); ++i, ++it) {
+      if (fds[i].revents) {
+        break;
+      }
+    }
+    char buf[4096];
+    ssize_t len = read(it->second.result_fd, buf, sizeof(buf));
+    if (len > 0) {
+      it->second.msg.append(buf, len);
+      continue;
+    }
+    if (len < 0 && errno == EINTR) {
+      continue;
+    }
+    close(it->second.result_fd);
+
+    int status;
+    pid_t pid;
+    do {
+      pid = waitpid(it->first, &status, 0);
+    } while (pid < 0 && errno == EINTR);
+
+    BatchResult &result = batch_results_[it->second.idx];
+    result.wallclock_s = std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::steady_clock::now() -
+                             it->second.begin)
+                             .count() /
+                         1000.0;
+
+    // The worker reports "<status> <exit code> <cycles>", then one
+    // "<value>\t<unit>\t<name>" line per statistic
+    std::istringstream is(it->second.msg);
+    if (pid < 0 || !WIFEXITED(status) ||
+        !(is >> result.status >> result.exit_code >> result.cycles)) {
+      result.status = "error";
+    }
+    std::string line;
+    std::getline(is, line);
+    while (std::getline(is, line)) {
+      size_t unit = line.find('\t');
+      size_t name = line.find('\t', unit + 1);
+      if (unit == std::string::npos || name == std::string::npos) {
+        continue;
+      }
+      result.stats.push_back({line.substr(name + 1),
+                              strtod(line.c_str(), nullptr),
+                              line.substr(unit + 1, name - unit - 1)});
+    }
+
+    std::cout << "Test " << result.image << ": " << result.status << " ("
+              << result.cycles << " cycles)" << std::endl;
+    workers.erase(it);
+  }
+}
+
+void VerilatorSimCtrl::RunBatchWorker(BatchResult &result, int result_fd) {
+  int log_fd = open(result.log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (log_fd >= 0) {
+    dup2(log_fd, STDOUT_FILENO);
+    dup2(log_fd, STDERR_FILENO);
+    close(log_fd);
   }
 
+  RunBatchTest(result);
+  // The final blocks close the files written by the design, e.g. by DPI sinks
   top_->final();
-  time_end_ = std::chrono::steady_clock::now();
 
-  if (TracingEverEnabled()) {
-    tracer_.close();
+  std::ostringstream os;
+  os << result.status << " " << result.exit_code << " " << result.cycles
+     << std::endl
+     << std::setprecision(17);
+  for (const SimStatistic &stat : result.stats) {
+    os << stat.value << "\t" << stat.unit << "\t" << stat.name << std::endl;
+  }
+  std::string msg = os.str();
+  for (size_t done = 0; done < msg.size();) {
+    ssize_t len = write(result_fd, msg.data() + done, msg.size() - done);
+    if (len < 0 && errno != EINTR) {
+      std::cerr << "ERROR: Could not report the test result." << std::endl;
+      break;
+    }
+    done += len > 0 ? len : 0;
+  }
+  close(result_fd);
+
+  // Skip the destructors of the state shared with the parent process
+  std::cout.flush();
+  std::cerr.flush();
+  fflush(nullptr);
+  _exit(0);
+}
+
+void VerilatorSimCtrl::HoldReset() {
+  SetReset();
+  for (unsigned int i = 0; i < reset_duration_cycles_; ++i) {
+    Cycle(time_ / 2);
+  }
+}
+
+void VerilatorSimCtrl::RunBatchTest(BatchResult &result) {
+  // The memories are reloaded while the design is held in reset
+  bool loaded = true;
+  for (auto it = extension_array_.begin(); it != extension_array_.end(); ++it) {
+    loaded &= (*it)->LoadTest(result.image);
   }
+  UnsetReset();
+
+  // The $finish() of the previous test must not end this one
+  Verilated::gotFinish(false);
+
+  if (!loaded) {
+    result.status = "error";
+    return;
+  }
+
+  unsigned long first_cycle = time_ / 2;
+  StopReason reason = RunLoop(false);
+  result.cycles = time_ / 2 - first_cycle;
+  result.exit_code = *sig_exit_ >> 1;
+
+  result.status = GetStatus(reason);
+
+  // The extensions report on each test, e.g. to the files of their reports
+  for (auto it = extension_array_.begin(); it != extension_array_.end(); ++it) {
+    (*it)->PostExec();
+  }
+  result.stats = GetStatistics();
+}
+
+std::string VerilatorSimCtrl::GetStatus(StopReason reason) const {
+  switch (reason) {
+    case kStopFinish:
+      if (!sig_exit_) {
+        return "finish";
+      }
+      return (*sig_exit_ & 1) && (*sig_exit_ >> 1) == 0 ? "pass" : "fail";
+    case kStopTimeout:
+      return "timeout";
+    case kStopRequested:
+    default:
+      return "aborted";
+  }
+}
+
+std::vector<SimStatistic> VerilatorSimCtrl::GetStatistics() const {
+  std::vector<SimStatistic> stats;
+  for (auto it = extension_array_.begin(); it != extension_array_.end(); ++it) {
+    (*it)->GetStatistics(stats);
+  }
+  return stats;
+}
+
+bool VerilatorSimCtrl::WriteStatsReport() const {
+  std::ofstream os(stats_report_file_);
+  if (!os) {
+    std::cerr << "ERROR: Could not open statistics report `"
+              << stats_report_file_ << "'." << std::endl;
+    return false;
+  }
+
+  // The images of a batch are loaded by the test processes, if forked
+  std::vector<std::string> images;
+  if (IsBatchMode()) {
+    for (const BatchResult &result : batch_results_) {
+      images.push_back(result.image);
+    }
+  } else {
+    for (auto it = extension_array_.begin(); it != extension_array_.end();
+         ++it) {
+      (*it)->GetImages(images);
+    }
+  }
+
+  unsigned long cycles = (time_ - time_restored_) / 2;
+  double wallclock_s = GetExecutionTimeMs() / 1000.0;
+  double speed_hz = wallclock_s > 0 ? cycles / wallclock_s : 0;
+  double trace_s = std::chrono::duration<double>(trace_time_).count();
+  std::string status;
+  if (IsBatchMode()) {
+    unsigned int passed = 0;
+    for (const BatchResult &result : batch_results_) {
+      passed += result.status == "pass";
+    }
+    status = passed == batch_results_.size() ? "pass" : "fail";
+  } else {
+    status = GetStatus(stop_reason_);
+  }
+
+  // The statistics of a batch run are the ones of each test, which ran in
+  // the workers of --jobs
+  std::vector<BatchResult> records;
+  if (IsBatchMode()) {
+    records = batch_results_;
+  } else {
+    records.push_back({.image = "",
+                       .log = "",
+                       .status = status,
+                       .exit_code = 0,
+                       .cycles = cycles,
+                       .wallclock_s = wallclock_s,
+                       .stats = GetStatistics()});
+  }
+
+  size_t dot = stats_report_file_.find_last_of('.');
+  if (dot != std::string::npos && stats_report_file_.substr(dot) == ".csv") {
+    // One header and one record, or one record per test of a batch. The
+    // images of a record are separated by spaces. The columns of the
+    // statistics are the ones of all records.
+    std::vector<std::string> columns;
+    for (const BatchResult &record : records) {
+      for (const SimStatistic &stat : record.stats) {
+        std::string column =
+            stat.name + (stat.unit.empty() ? "" : " [" + stat.unit + "]");
+        if (std::find(columns.begin(), columns.end(), column) ==
+            columns.end()) {
+          columns.push_back(column);
+        }
+      }
+    }
+
+    os << "model";
+    for (const auto &param : model_params_) {
+      os << "," << CsvEscape(param.first);
+    }
+    os << ",images,image_hashes,status,cycles,wallclock_s,speed_hz,"
+          "trace_overhead_s";
+    for (const std::string &column : columns) {
+      os << "," << CsvEscape(column);
+    }
+    os << std::endl;
+
+    for (const BatchResult &record : records) {
+      std::vector<std::string> record_images = images;
+      if (IsBatchMode()) {
+        record_images = {record.image};
+      }
+      std::string paths, hashes;
+      for (const std::string &image : record_images) {
+        paths += (paths.empty() ? "" : " ") + image;
+        hashes += (hashes.empty() ? "" : " ") + HashFile(image);
+      }
+
+      os << CsvEscape(GetName());
+      for (const auto &param : model_params_) {
+        os << "," << param.second;
+      }
+      os << "," << CsvEscape(paths) << "," << hashes << "," << record.status
+         << "," << record.cycles << "," << ExactNumber(record.wallclock_s)
+         << ","
+         << ExactNumber(record.wallclock_s > 0
+                            ? record.cycles / record.wallclock_s
+                            : 0)
+         << "," << ExactNumber(trace_s);
+      for (const std::string &column : columns) {
+        os << ",";
+        for (const SimStatistic &stat : record.stats) {
+          if (stat.name + (stat.unit.empty() ? "" : " [" + stat.unit + "]") ==
+              column) {
+            os << ExactNumber(stat.value);
+            break;
+          }
+        }
+      }
+      os << std::endl;
+    }
+  } else {
+    os << "{" << std::endl
+       << "  \"model\": \"" << JsonEscape(GetName()) << "\"," << std::endl
+       << "  \"parameters\": {";
+    for (size_t i = 0; i < model_params_.size(); ++i) {
+      os << (i ? ", " : "") << "\"" << JsonEscape(model_params_[i].first)
+         << "\": " << model_params_[i].second;
+    }
+    os << "}," << std::endl << "  \"images\": [";
+    for (size_t i = 0; i < images.size(); ++i) {
+      os << (i ? "," : "") << std::endl
+         << "    {\"path\": \"" << JsonEscape(images[i]) << "\", "
+         << "\"fnv1a64\": \"" << HashFile(images[i]) << "\"}";
+    }
+    os << (images.empty() ? "]," : "\n  ],") << std::endl
+       << "  \"status\": \"" << status << "\"," << std::endl
+       << "  \"cycles\": " << cycles << "," << std::endl
+       << "  \"wallclock_s\": " << JsonNumber(wallclock_s) << "," << std::endl
+       << "  \"speed_hz\": " << JsonNumber(speed_hz) << "," << std::endl
+       << "  \"trace_overhead_s\": " << JsonNumber(trace_s) << "," << std::endl;
+    if (IsBatchMode()) {
+      os << "  \"tests\": [";
+      for (size_t i = 0; i < records.size(); ++i) {
+        const BatchResult &record = records[i];
+        os << (i ? "," : "") << std::endl
+           << "    {\"image\": \"" << JsonEscape(record.image) << "\", "
+           << "\"status\": \"" << record.status << "\", "
+           << "\"cycles\": " << record.cycles << ", "
+           << "\"wallclock_s\": " << JsonNumber(record.wallclock_s) << ","
+           << std::endl
+           << "     \"statistics\": ";
+        WriteJsonStatistics(os, record.stats, "     ");
+        os << "}";
+      }
+      os << (records.empty() ? "]" : "\n  ]") << std::endl;
+    } else {
+      os << "  \"statistics\": ";
+      WriteJsonStatistics(os, records[0].stats, "  ");
+      os << std::endl;
+    }
+    os << "}" << std::endl;
+  }
+
+  std::cout << "Statistics report written to " << stats_report_file_
+            << std::endl;
+  return true;
+}
+
+void VerilatorSimCtrl::WriteJsonStatistics(
+    std::ostream &os, const std::vector<SimStatistic> &stats,
+    const std::string &indent) {
+  os << "[";
+  for (size_t i = 0; i < stats.size(); ++i) {
+    os << (i ? "," : "") << std::endl
+       << indent << "  {\"name\": \"" << JsonEscape(stats[i].name) << "\", "
+       << "\"value\": " << JsonNumber(stats[i].value) << ", "
+       << "\"unit\": \"" << JsonEscape(stats[i].unit) << "\"}";
+  }
+  os << (stats.empty() ? "]" : "\n" + indent + "]");
+}
+
+bool VerilatorSimCtrl::WriteBatchReport() const {
+  std::ofstream os(batch_report_file_);
+  if (!os) {
+    std::cerr << "ERROR: Could not open batch report `" << batch_report_file_
+              << "'." << std::endl;
+    return false;
+  }
+
+  unsigned int passed = 0;
+  for (const BatchResult &result : batch_results_) {
+    passed += result.status == "pass";
+  }
+
+  os << "{" << std::endl
+     << "  \"model\": \"" << JsonEscape(GetName()) << "\"," << std::endl
+     << "  \"passed\": " << passed << "," << std::endl
+     << "  \"failed\": " << batch_results_.size() - passed << "," << std::endl
+     << "  \"tests\": [";
+  for (size_t i = 0; i < batch_results_.size(); ++i) {
+    const BatchResult &result = batch_results_[i];
+    os << (i ? "," : "") << std::endl
+       << "    {\"image\": \"" << JsonEscape(result.image) << "\", "
+       << "\"status\": \"" << result.status << "\", "
+       << "\"exit_code\": " << result.exit_code << ", "
+       << "\"cycles\": " << result.cycles << ", "
+       << "\"wallclock_s\": " << JsonNumber(result.wallclock_s);
+    if (!result.log.empty()) {
+      os << ", \"log\": \"" << JsonEscape(result.log) << "\"";
+    }
+    os << "}";
+  }
+  os << std::endl << "  ]" << std::endl << "}" << std::endl;
+
+  std::cout << "Batch report written to " << batch_report_file_ << std::endl;
+  return true;
+}
+
+bool VerilatorSimCtrl::WriteBatchJUnit() const {
+  std::ofstream os(batch_junit_file_);
+  if (!os) {
+    std::cerr << "ERROR: Could not open JUnit report `" << batch_junit_file_
+              << "'." << std::endl;
+    return false;
+  }
+
+  unsigned int failures = 0, errors = 0, skipped = 0;
+  double wallclock_s = 0;
+  for (const BatchResult &result : batch_results_) {
+    failures += result.status == "fail";
+    errors += result.status != "pass" && result.status != "fail" &&
+              result.status != "skipped";
+    skipped += result.status == "skipped";
+    wallclock_s += result.wallclock_s;
+  }
+
+  std::string suite = XmlEscape(GetName());
+  os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << std::endl
+     << "<testsuite name=\"" << suite << "\" tests=\""
+     << batch_results_.size() << "\" failures=\"" << failures
+     << "\" errors=\"" << errors << "\" skipped=\"" << skipped
+     << "\" time=\"" << wallclock_s << "\">" << std::endl;
+  for (const BatchResult &result : batch_results_) {
+    os << "  <testcase classname=\"" << suite << "\" name=\""
+       << XmlEscape(result.image) << "\" time=\"" << result.wallclock_s
+       << "\">" << std::endl;
+    if (result.status == "fail") {
+      os << "    <failure message=\"exit code " << result.exit_code
+         << "\"/>" << std::endl;
+    } else if (result.status == "skipped") {
+      os << "    <skipped/>" << std::endl;
+    } else if (result.status != "pass") {
+      os << "    <error message=\"" << result.status << " after "
+         << result.cycles << " cycles\"/>" << std::endl;
+    }
+    if (!result.log.empty()) {
+      os << "    <system-out>" << XmlEscape(result.log) << "</system-out>"
+         << std::endl;
+    }
+    os << "  </testcase>" << std::endl;
+  }
+  os << "</testsuite>" << std::endl;
+
+  std::cout << "JUnit report written to " << batch_junit_file_ << std::endl;
+  return true;
 }
 
 std::string VerilatorSimCtrl::GetName() const {
@@ -400,11 +1471,169 @@ void VerilatorSimCtrl::Trace() {
     return;
   }
 
+  // Time spent by the simulation thread on tracing. With a threaded tracer
+  // (--trace-threads), only handing the values over to the writer remains.
+  auto trace_begin = std::chrono::steady_clock::now();
+
   if (!tracer_.isOpen()) {
+    // The scope filter is applied when the signals are declared on open
+    for (const std::string &scope : trace_scopes_) {
+      tracer_.dumpvars(99, scope);
+    }
     tracer_.open(GetTraceFileName());
     std::cout << "Writing simulation traces to " << GetTraceFileName()
               << std::endl;
   }
 
   tracer_.dump(GetTime());
+
+  trace_time_ += std::chrono::steady_clock::now() - trace_begin;
+}
+
+void VerilatorSimCtrl::OnEventTrigger(QData value) {
+  switch (value) {
+    case kEventTriggerTraceOn:
+      // The software only marks the region of interest, tracing is up to the
+      // command line (and never requested with --jobs)
+      if (trace_requested_) {
+        TraceOn();
+      }
+      break;
+    case kEventTriggerTraceOff:
+      TraceOff();
+      break;
+    case kEventTriggerCheckpoint:
+      if (!checkpoint_file_.empty()) {
+        SaveCheckpoint();
+      }
+      break;
+  }
+}
+
+void VerilatorSimCtrl::SaveCheckpoint() {
+#if VM_SAVABLE == 1
+  VerilatedSave os;
+  os.open(checkpoint_file_.c_str());
+  if (!os.isOpen()) {
+    std::cerr << "ERROR: Could not open checkpoint file `" << checkpoint_file_
+              << "'." << std::endl;
+    RequestStop(false);
+    return;
+  }
+
+  uint64_t time = time_;
+  os << time << event_trigger_q_;
+  for (auto it = extension_array_.begin(); it != extension_array_.end(); ++it) {
+    (*it)->Save(os);
+  }
+  top_->save(os);
+  os.close();
+
+  std::cout << "Saved checkpoint at cycle " << time_ / 2 << " to "
+            << checkpoint_file_ << std::endl;
+#endif
+}
+
+bool VerilatorSimCtrl::RestoreCheckpoint() {
+#if VM_SAVABLE == 1
+  VerilatedRestore os;
+  os.open(restore_file_.c_str());
+  if (!os.isOpen()) {
+    std::cerr << "ERROR: Could not open checkpoint file `" << restore_file_
+              << "'." << std::endl;
+    simulation_success_ = false;
+    return false;
+  }
+
+  uint64_t time;
+  os >> time >> event_trigger_q_;
+  for (auto it = extension_array_.begin(); it != extension_array_.end(); ++it) {
+    (*it)->Restore(os);
+  }
+  top_->restore(os);
+  os.close();
+
+  // The reset sequence is part of the restored state and is not replayed
+  time_ = time;
+  time_restored_ = time;
+
+  std::cout << "Restored checkpoint at cycle " << time_ / 2 << " from "
+            << restore_file_ << std::endl;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void VerilatorSimCtrl::PinThreads() const {
+  long nr_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  if (nr_cpus < 1) {
+    nr_cpus = 1;
+  }
+
+  // The main thread first (its ID is the one of the process), then the
+  // workers, in any order since they are interchangeable
+  std::vector<pid_t> tids = {getpid()};
+  for (pid_t tid : model_tids_) {
+    if (tid != getpid()) {
+      tids.push_back(tid);
+    }
+  }
+
+  int cpu = pin_threads_first_cpu_;
+  for (pid_t tid : tids) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu % nr_cpus, &cpuset);
+    if (sched_setaffinity(tid, sizeof(cpuset), &cpuset) != 0) {
+      std::cerr << "WARNING: Could not pin thread " << tid << " to CPU "
+                << cpu % nr_cpus << "." << std::endl;
+    } else {
+      std::cout << "Pinned thread " << tid << " to CPU " << cpu % nr_cpus
+                << "." << std::endl;
+    }
+    ++cpu;
+  }
+}
+
+void VerilatorSimCtrl::CollectThreadStatistics() {
+  long ticks_per_s = sysconf(_SC_CLK_TCK);
+
+  thread_stats_.clear();
+  for (pid_t tid : GetThreadIds()) {
+    std::ostringstream path;
+    path << "/proc/self/task/" << tid << "/stat";
+    std::ifstream stat_file(path.str());
+    std::string line;
+    if (!std::getline(stat_file, line)) {
+      continue;
+    }
+
+    // The thread name is enclosed in parentheses and may contain spaces. The
+    // remaining fields start with the state (field 3 of proc(5)).
+    size_t name_end = line.rfind(')');
+    if (name_end == std::string::npos) {
+      continue;
+    }
+    std::istringstream fields(line.substr(name_end + 2));
+    std::vector<std::string> field;
+    std::string tok;
+    while (fields >> tok) {
+      field.push_back(tok);
+    }
+    // utime (14), stime (15) and processor (39), offset by the first 3 fields
+    if (field.size() < 37) {
+      continue;
+    }
+    unsigned long utime = std::stoul(field[14 - 3]);
+    unsigned long stime = std::stoul(field[15 - 3]);
+    int cpu = std::stoi(field[39 - 3]);
+
+    thread_stats_.push_back(
+        {.tid = tid,
+         .model = std::find(model_tids_.begin(), model_tids_.end(), tid) !=
+                  model_tids_.end(),
+         .cpu = cpu,
+         .cpu_time_s = (double)(utime + stime) / ticks_per_s});
+  }
 }
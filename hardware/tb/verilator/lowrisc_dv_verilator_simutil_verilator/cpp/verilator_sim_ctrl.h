@@ -6,7 +6,9 @@
 #define OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_VERILATOR_SIM_CTRL_H_
 
 #include <chrono>
+#include <ostream>
 #include <string>
+#include <sys/types.h>
 #include <vector>
 
 #include "sim_ctrl_extension.h"
@@ -17,6 +19,11 @@ enum VerilatorSimCtrlFlags {
   ResetPolarityNegative = 1,
 };
 
+// Values written by the software into the event_trigger control register
+const QData kEventTriggerTraceOn = 1;
+const QData kEventTriggerCheckpoint = 2;
+const QData kEventTriggerTraceOff = ~0ULL;
+
 /**
  * Simulation controller for verilated simulations
  */
@@ -34,10 +41,41 @@ class VerilatorSimCtrl {
 
   /**
    * Set the top-level design
+   *
+   * Call right after the model is constructed, before any other thread is
+   * started: the threads of the process are the ones of the model then.
    */
   void SetTop(VerilatedToplevel *top, CData *sig_clk, CData *sig_rst,
               VerilatorSimCtrlFlags flags = Defaults);
 
+  /**
+   * Set the software event trigger signal
+   *
+   * The simulation controller samples this signal on every rising clock edge
+   * and reacts to the kEventTrigger* values written by the software.
+   */
+  void SetEventTrigger(QData *sig_event_trigger);
+
+  /**
+   * Set the signal that reports the end of a test
+   *
+   * Bit 0 is set once the software has finished, the remaining bits hold its
+   * exit code. Used to judge the tests of a batch run (see --batch).
+   */
+  void SetExitSignal(QData *sig_exit);
+
+  /**
+   * Add a parameter of the model to the statistics report
+   *
+   * E.g., the configuration it was verilated with (see --stats-report).
+   */
+  void AddModelParameter(const std::string &name, unsigned long value);
+
+  /**
+   * Is a batch of tests run instead of a single simulation?
+   */
+  bool IsBatchMode() const { return !batch_file_.empty(); }
+
   /**
    * Setup and run the simulation (all in one)
    *
@@ -102,35 +140,131 @@ class VerilatorSimCtrl {
    */
   void RequestStop(bool simulation_success);
 
+  /**
+   * Report a $finish() of the design
+   *
+   * Called by vl_finish() if the model is built with VL_USER_FINISH.
+   */
+  void NotifyFinish();
+
   /**
    * Register an extension to be called automatically
    */
   void RegisterExtension(SimCtrlExtension *ext);
 
+  /**
+   * Enable tracing (if possible)
+   *
+   * Enabling tracing can fail if no tracing support has been compiled into the
+   * simulation.
+   *
+   * @return Is tracing enabled?
+   */
+  bool TraceOn();
+
+  /**
+   * Disable tracing
+   *
+   * @return Is tracing enabled?
+   */
+  bool TraceOff();
+
   /**
    * Get the current time in ticks
    */
   unsigned long GetTime() const { return time_; }
 
  private:
+  /**
+   * CPU time spent by one thread of the simulation process
+   */
+  struct ThreadStat {
+    pid_t tid;
+    // The main thread or a worker of the model
+    bool model;
+    int cpu;
+    double cpu_time_s;
+  };
+
+  /**
+   * Reason for leaving the main loop
+   */
+  enum StopReason {
+    kStopRequested,
+    kStopFinish,
+    kStopTimeout,
+  };
+
+  /**
+   * Extension called on the clock, with its sampling period
+   */
+  struct ClockedExtension {
+    SimCtrlExtension *ext;
+    unsigned long period;
+    unsigned long next_cycle;
+  };
+
+  /**
+   * Outcome of one test of a batch run
+   */
+  struct BatchResult {
+    std::string image;
+    std::string log;
+    std::string status;
+    unsigned long exit_code;
+    unsigned long cycles;
+    double wallclock_s;
+    // Statistics of the extensions for this test
+    std::vector<SimStatistic> stats;
+  };
+
   VerilatedToplevel *top_;
   CData *sig_clk_;
   CData *sig_rst_;
+  QData *sig_event_trigger_;
+  QData *sig_exit_;
+  QData event_trigger_q_;
   VerilatorSimCtrlFlags flags_;
   unsigned long time_;
+  unsigned long time_restored_;
   bool tracing_enabled_;
   bool tracing_enabled_changed_;
   bool tracing_ever_enabled_;
   bool tracing_possible_;
+  // Tracing was asked for on the command line (-t or --trace-*)
+  bool trace_requested_;
+  bool checkpoint_possible_;
+  long trace_start_cycle_;
+  long trace_end_cycle_;
+  std::vector<std::string> trace_scopes_;
+  std::string checkpoint_file_;
+  std::string restore_file_;
+  std::string batch_file_;
+  std::string batch_report_file_;
+  std::string batch_junit_file_;
+  std::string batch_log_dir_;
+  unsigned int batch_jobs_;
+  std::vector<BatchResult> batch_results_;
+  std::string stats_report_file_;
+  std::vector<std::pair<std::string, unsigned long>> model_params_;
+  StopReason stop_reason_;
   unsigned int initial_reset_delay_cycles_;
   unsigned int reset_duration_cycles_;
   volatile unsigned int request_stop_;
+  // Leave the run loop after this cycle: stop request or $finish()
+  volatile bool stop_loop_;
   volatile bool simulation_success_;
   std::chrono::steady_clock::time_point time_begin_;
   std::chrono::steady_clock::time_point time_end_;
+  std::chrono::steady_clock::duration trace_time_;
   VerilatedTracer tracer_;
   int term_after_cycles_;
+  int pin_threads_first_cpu_;
+  // The main thread and the workers of the model, see SetTop()
+  std::vector<pid_t> model_tids_;
+  std::vector<ThreadStat> thread_stats_;
   std::vector<SimCtrlExtension *> extension_array_;
+  std::vector<ClockedExtension> clocked_extensions_;
 
   /**
    * Default constructor
@@ -156,23 +290,6 @@ class VerilatorSimCtrl {
    */
   void PrintHelp() const;
 
-  /**
-   * Enable tracing (if possible)
-   *
-   * Enabling tracing can fail if no tracing support has been compiled into the
-   * simulation.
-   *
-   * @return Is tracing enabled?
-   */
-  bool TraceOn();
-
-  /**
-   * Disable tracing
-   *
-   * @return Is tracing enabled?
-   */
-  bool TraceOff();
-
   /**
    * Is tracing currently enabled?
    */
@@ -207,6 +324,123 @@ class VerilatorSimCtrl {
    */
   void Run();
 
+  /**
+   * Run every test listed in batch_file_ on the same model
+   *
+   * Before each test the design is reset and the extensions reload the
+   * memories (see SimCtrlExtension::LoadTest()). The results of all tests are
+   * written to batch_report_file_ (and batch_junit_file_).
+   */
+  void RunBatch();
+
+  /**
+   * Run the tests of a batch one after the other in this process
+   */
+  void RunBatchSerial();
+
+  /**
+   * Run the tests of a batch in up to batch_jobs_ worker processes
+   *
+   * The design is taken through the reset sequence once. Every worker is
+   * forked from this state and only loads and runs its own test, with its
+   * output redirected to the log file of the test.
+   */
+  void RunBatchForked();
+
+  /**
+   * Body of a worker process of RunBatchForked()
+   *
+   * Runs the test and the final blocks of the design, and writes the result
+   * and the statistics of the test to |result_fd|.
+   */
+  [[noreturn]] void RunBatchWorker(BatchResult &result, int result_fd);
+
+  /**
+   * Keep the design in reset for the reset duration
+   */
+  void HoldReset();
+
+  /**
+   * Load and run one test of a batch, starting with the design in reset
+   *
+   * The extensions report on the test with SimCtrlExtension::PostExec(), and
+   * their statistics are kept in |result|.
+   */
+  void RunBatchTest(BatchResult &result);
+
+  /**
+   * Prepare the model and the tracer before the first clock edge
+   *
+   * @return Can the simulation start?
+   */
+  bool Init();
+
+  /**
+   * Release the model and the tracer after the last clock edge
+   */
+  void Finish();
+
+  /**
+   * Collect the extensions to call on the clock, see
+   * SimCtrlExtension::ClockPeriod()
+   */
+  void ScheduleExtensions();
+
+  /**
+   * Advance the simulation by a clock period, from the rising edge
+   *
+   * @param cycle Current cycle, time_ / 2
+   */
+  void Cycle(unsigned long cycle);
+
+  /**
+   * Advance the simulation by half a clock period, from the rising edge
+   */
+  void FallingEdge();
+
+  /**
+   * Simulate until the design finishes or the simulation is stopped
+   *
+   * @param reset Run the reset sequence relative to the current cycle
+   * @return Why the simulation stopped
+   */
+  StopReason RunLoop(bool reset);
+
+  /**
+   * Status of a test that stopped for |reason|: pass, fail, timeout or aborted
+   */
+  std::string GetStatus(StopReason reason) const;
+
+  /**
+   * Collect the statistics of all extensions
+   */
+  std::vector<SimStatistic> GetStatistics() const;
+
+  /**
+   * Write the statistics of the simulation to stats_report_file_, as CSV if
+   * its name ends with .csv, as JSON otherwise
+   *
+   * The statistics of a batch run are the ones of each test.
+   */
+  bool WriteStatsReport() const;
+
+  /**
+   * Write |stats| as a JSON array, its lines indented by |indent|
+   */
+  static void WriteJsonStatistics(std::ostream &os,
+                                  const std::vector<SimStatistic> &stats,
+                                  const std::string &indent);
+
+  /**
+   * Write the results of a batch run to batch_report_file_ as JSON
+   */
+  bool WriteBatchReport() const;
+
+  /**
+   * Write the results of a batch run to batch_junit_file_ as JUnit XML
+   */
+  bool WriteBatchJUnit() const;
+
   /**
    * Get a name for this simulation
    *
@@ -238,6 +472,37 @@ class VerilatorSimCtrl {
    * Perform tracing in Verilator if required
    */
   void Trace();
+
+  /**
+   * React to a new value of the software event trigger
+   */
+  void OnEventTrigger(QData value);
+
+  /**
+   * Save the state of the model and of all extensions to checkpoint_file_
+   */
+  void SaveCheckpoint();
+
+  /**
+   * Restore the state of the model and of all extensions from restore_file_
+   *
+   * @return Was the checkpoint restored?
+   */
+  bool RestoreCheckpoint();
+
+  /**
+   * Pin every thread of the model to its own CPU
+   *
+   * The main thread goes to |pin_threads_first_cpu_|, the worker threads of a
+   * multi-threaded model to the following CPUs. The other threads of the
+   * process, e.g. the FST writers, are not pinned.
+   */
+  void PinThreads() const;
+
+  /**
+   * Sample the CPU time spent by every thread of the process
+   */
+  void CollectThreadStatistics();
 };
 
 #endif  // OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_VERILATOR_SIM_CTRL_H_
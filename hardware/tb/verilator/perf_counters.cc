@@ -0,0 +1,244 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// Hardware performance counters of the Verilator test-bench.
+
+#include "perf_counters.h"
+
+#include <cstring>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <sstream>
+
+#include "dpi_state.h"
+#include "verilator_sim_ctrl.h"
+
+// This is defined by the user when verilating with --savable
+#ifndef VM_SAVABLE
+#define VM_SAVABLE 0
+#endif
+
+#if VM_SAVABLE == 1
+#include <verilated_save.h>
+#endif
+
+// Names of the bits of perf_events_o, see ara_tb_verilator.sv
+static const char *const kPerfEventNames[] = {
+    "ara_busy",                 // 0: Ara is not idle
+    "vinsn_running",            // 1: a vector instruction is in flight
+    "seq_insn_stall",           // 2: the sequencer cannot accept an instruction
+    "seq_lanes_desynch_stall",  // 3: the sequencer waits for the lanes to sync
+    "seq_hazard",               // 4: in-flight instructions with dependencies
+    "lane0_valu_busy",          // 5
+    "lane0_vmfpu_busy",         // 6
+    "lane0_vtmac_busy",         // 7
+    "vldu_busy",                // 8
+    "vstu_busy",                // 9
+    "masku_busy",               // 10
+    "sldu_busy",                // 11
+    "lane0_vrf_bank_conflict",  // 12: an operand request lost a VRF bank
+    "lane0_opqueue_full",       // 13: an operand queue stalls its requester
+    "lane0_opreq_hazard",       // 14: an operand request waits for a hazard
+    "axi_ar",                   // 15: AR handshakes
+    "axi_r",                    // 16: R beats
+    "axi_aw",                   // 17: AW handshakes
+    "axi_w",                    // 18: W beats
+    "cva6_dcache_miss",         // 19
+    "cva6_icache_miss",         // 20
+    "cva6_sb_full",             // 21
+};
+static const size_t kNrPerfEvents =
+    sizeof(kPerfEventNames) / sizeof(kPerfEventNames[0]);
+
+PerfCounters::PerfCounters(const QData *sig_events)
+    : sig_events_(sig_events),
+      event_mask_((1ULL << kNrPerfEvents) - 1),
+      stats_report_(false),
+      cycles_(0),
+      counts_() {
+  static_assert(kNrPerfEvents <= kMaxEvents, "Too many performance events");
+}
+
+bool PerfCounters::ParseCLIArguments(int argc, char **argv, bool &exit_app) {
+  const struct option long_options[] = {
+      {"perf-report", required_argument, nullptr, 'P'},
+      {"perf-events", required_argument, nullptr, 'Q'},
+      {"stats-report", required_argument, nullptr, 'r'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, no_argument, nullptr, 0}};
+
+  // Reset the command parsing index in-case other utils have already parsed
+  // some arguments
+  optind = 1;
+  while (1) {
+    int c = getopt_long(argc, argv, ":h", long_options, nullptr);
+    if (c == -1) {
+      break;
+    }
+
+    // Disable error reporting by getopt
+    opterr = 0;
+
+    switch (c) {
+      case 0:
+        break;
+      case 'P':
+        report_file_ = optarg;
+        break;
+      case 'Q':
+        if (strcasecmp(optarg, "list") == 0) {
+          for (size_t i = 0; i < kNrPerfEvents; ++i) {
+            std::cout << kPerfEventNames[i] << std::endl;
+          }
+          exit_app = true;
+          return true;
+        }
+        if (!SelectEvents(optarg)) {
+          return false;
+        }
+        break;
+      case 'r':
+        // Parsed by VerilatorSimCtrl, the counts are part of the report
+        stats_report_ = true;
+        break;
+      case 'h':
+        std::cout << "Performance counters:\n\n"
+                     "--perf-report=FILE\n"
+                     "  Count the performance events and write the counts to "
+                     "FILE as JSON\n\n"
+                     "--perf-events=EVENT[,EVENT...]\n"
+                     "  Only count the given events (default: all)\n\n"
+                     "--perf-events=list\n"
+                     "  Print the performance events\n\n";
+        return true;
+      case ':':  // missing argument
+        std::cerr << "ERROR: Missing argument." << std::endl << std::endl;
+        return false;
+      case '?':
+      default:;
+        // Ignore unrecognized options since they might be consumed by
+        // other utils
+    }
+  }
+
+  return true;
+}
+
+void PerfCounters::OnClock(unsigned long sim_time) {
+  if (!Enabled()) {
+    return;
+  }
+
+  ++cycles_;
+  for (QData events = *sig_events_ & event_mask_; events;
+       events &= events - 1) {
+    ++counts_[__builtin_ctzll(events)];
+  }
+}
+
+void PerfCounters::PostExec() {
+  if (report_file_.empty()) {
+    return;
+  }
+
+  std::string file = test_image_.empty()
+                         ? report_file_
+                         : TestReportFile(report_file_, test_image_);
+  if (WriteReport(file)) {
+    std::cout << "Performance counters written to " << file << std::endl;
+  }
+}
+
+bool PerfCounters::LoadTest(const std::string &image) {
+  // Every test of a batch is counted on its own
+  test_image_ = image;
+  cycles_ = 0;
+  counts_.fill(0);
+  return true;
+}
+
+void PerfCounters::GetStatistics(std::vector<SimStatistic> &stats) const {
+  if (!Enabled()) {
+    return;
+  }
+
+  for (size_t i = 0; i < kNrPerfEvents; ++i) {
+    if (event_mask_ & (1ULL << i)) {
+      stats.push_back({std::string("Perf ") + kPerfEventNames[i],
+                       (double)counts_[i], "cycles"});
+    }
+  }
+}
+
+void PerfCounters::Save(VerilatedSave &os) {
+#if VM_SAVABLE == 1
+  DpiStateWriter w;
+  w.Put(cycles_);
+  w.Put(counts_);
+  std::string state = w.state();
+  os << state;
+#endif
+}
+
+void PerfCounters::Restore(VerilatedRestore &os) {
+#if VM_SAVABLE == 1
+  std::string state;
+  os >> state;
+  DpiStateReader r(state);
+  if (!r.Get(cycles_) || !r.Get(counts_) || !r.Done()) {
+    std::cerr << "ERROR: Could not restore the performance counters."
+              << std::endl;
+    VerilatorSimCtrl::GetInstance().RequestStop(false);
+  }
+#endif
+}
+
+bool PerfCounters::SelectEvents(const std::string &names) {
+  event_mask_ = 0;
+
+  std::istringstream is(names);
+  std::string name;
+  while (std::getline(is, name, ',')) {
+    size_t i = 0;
+    while (i < kNrPerfEvents && name != kPerfEventNames[i]) {
+      ++i;
+    }
+    if (i == kNrPerfEvents) {
+      std::cerr << "ERROR: Unknown performance event `" << name
+                << "'. Run with --perf-events=list to get a list."
+                << std::endl;
+      return false;
+    }
+    event_mask_ |= 1ULL << i;
+  }
+  return true;
+}
+
+bool PerfCounters::WriteReport(const std::string &file) const {
+  std::ofstream os(file);
+  if (!os) {
+    std::cerr << "ERROR: Could not open performance report `" << file << "'."
+              << std::endl;
+    return false;
+  }
+
+  os << "{" << std::endl
+     << "  \"cycles\": " << cycles_ << "," << std::endl
+     << "  \"events\": {";
+  bool first = true;
+  for (size_t i = 0; i < kNrPerfEvents; ++i) {
+    if (!(event_mask_ & (1ULL << i))) {
+      continue;
+    }
+    os << (first ? "" : ",") << std::endl
+       << "    \"" << kPerfEventNames[i] << "\": {\"count\": " << counts_[i]
+       << ", \"ratio\": " << (cycles_ ? (double)counts_[i] / cycles_ : 0)
+       << "}";
+    first = false;
+  }
+  os << std::endl << "  }" << std::endl << "}" << std::endl;
+  return true;
+}
@@ -0,0 +1,70 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// Hardware performance counters of the Verilator test-bench.
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <verilated.h>
+
+#include "sim_ctrl_extension.h"
+
+/**
+ * Count the cycles in which each performance event of the design is set
+ *
+ * The events are the bits of the perf_events_o port of ara_tb_verilator.
+ * Counting is enabled with --perf-report=FILE, which receives the counts as
+ * JSON once the simulation has finished, or once each test of a batch run has
+ * finished (see TestReportFile()). The counts are also part of the statistics
+ * report (--stats-report).
+ */
+class PerfCounters : public SimCtrlExtension {
+ public:
+  explicit PerfCounters(const QData *sig_events);
+
+  // Declared in SimCtrlExtension
+  bool ParseCLIArguments(int argc, char **argv, bool &exit_app) override;
+  void OnClock(unsigned long sim_time) override;
+  unsigned long ClockPeriod() const override { return Enabled() ? 1 : 0; }
+  void PostExec() override;
+  bool LoadTest(const std::string &image) override;
+  void GetStatistics(std::vector<SimStatistic> &stats) const override;
+  void Save(VerilatedSave &os) override;
+  void Restore(VerilatedRestore &os) override;
+
+ private:
+  static const size_t kMaxEvents = 64;
+
+  const QData *sig_events_;
+  // Events selected with --perf-events, all by default
+  QData event_mask_;
+  std::string report_file_;
+  // Counting for the statistics report only
+  bool stats_report_;
+  // Image of the current test of a batch run
+  std::string test_image_;
+  unsigned long cycles_;
+  std::array<unsigned long, kMaxEvents> counts_;
+
+  /**
+   * Are the events counted (--perf-report or --stats-report)?
+   */
+  bool Enabled() const { return !report_file_.empty() || stats_report_; }
+
+  /**
+   * Select the events in the comma-separated list |names|
+   *
+   * @return false if an event is unknown
+   */
+  bool SelectEvents(const std::string &names);
+
+  /**
+   * Write the counts to |file|
+   */
+  bool WriteReport(const std::string &file) const;
+};
@@ -0,0 +1,421 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// Lockstep co-simulation of the Verilator test-bench with Spike.
+
+#include "spike_cosim.h"
+
+#include <algorithm>
+#include <cstring>
+#include <getopt.h>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include "riscv/processor.h"
+#include "riscv/simif.h"
+#include "spike_memory.h"
+#include "sv_scoped.h"
+#include "verilator_sim_ctrl.h"
+
+extern "C" {
+// Exported by tc_sram, see patches/0001-tech-cells-generic-sram.patch
+extern int simutil_get_mem(int index, svBitVecVal *val);
+}
+
+// Banks of the VRF of a lane, see ara_pkg::NrVRFBanksPerLane
+static const unsigned int kVrfBanks = 8;
+
+// Fields of the co-simulation ports, see ara_tb_verilator.sv
+static const QData kCommitAck = 1ULL << 0;
+static const QData kCommitWeGpr = 1ULL << 1;
+static const QData kCommitWeFpr = 1ULL << 2;
+static const QData kCommitException = 1ULL << 32;
+static const QData kAraAccepted = 1ULL << 32;
+static const QData kAraIdle = 1ULL << 33;
+
+// Does |insn| go to Ara (OP-V, and vector loads and stores)?
+static bool IsVectorInsn(uint32_t insn) {
+  uint32_t opcode = insn & 0x7f;
+  uint32_t width = (insn >> 12) & 0x7;
+  if (opcode == 0x57) {
+    return true;
+  }
+  return (opcode == 0x07 || opcode == 0x27) && (width == 0 || width >= 5);
+}
+
+// Does |insn| write a mask, i.e., one bit per body element?
+static bool WritesMask(uint32_t insn) {
+  if ((insn & 0x7f) != 0x57) {
+    return false;
+  }
+  uint32_t funct3 = (insn >> 12) & 0x7;
+  uint32_t funct6 = insn >> 26;
+  uint32_t vs1 = (insn >> 15) & 0x1f;
+  switch (funct3) {
+    case 0:  // OPIVV
+    case 3:  // OPIVI
+    case 4:  // OPIVX
+      return funct6 == 0x11 || funct6 == 0x13 ||
+             (funct6 >= 0x18 && funct6 <= 0x1f);
+    case 1:  // OPFVV
+    case 5:  // OPFVF
+      return funct6 >= 0x18 && funct6 <= 0x1f;
+    case 2:  // OPMVV
+      return (funct6 >= 0x18 && funct6 <= 0x1f) ||
+             (funct6 == 0x14 && vs1 >= 1 && vs1 <= 3);
+    default:
+      return false;
+  }
+}
+
+// Does |insn| read a CSR, whose value Spike might not model?
+static bool IsCsrInsn(uint32_t insn) {
+  return (insn & 0x7f) == 0x73 && ((insn >> 12) & 0x7) != 0;
+}
+
+static unsigned int BitReverse(unsigned int value, unsigned int bits) {
+  unsigned int reversed = 0;
+  for (unsigned int b = 0; b < bits; ++b) {
+    reversed |= ((value >> b) & 1) << (bits - 1 - b);
+  }
+  return reversed;
+}
+
+static std::string Hex(uint64_t value) {
+  std::ostringstream os;
+  os << "0x" << std::hex << value;
+  return os.str();
+}
+
+SpikeCosim::SpikeCosim(const Signals &sig, unsigned int nr_lanes,
+                       unsigned int vlen)
+    : sig_(sig),
+      nr_lanes_(nr_lanes),
+      vlenb_(vlen / 8),
+      isa_("rv64gcv"),
+      failed_(false),
+      vrf_pending_(false),
+      vinsn_retired_(0),
+      vinsn_accepted_(0),
+      insn_retired_(0),
+      vrf_checks_(0),
+      synced_reads_(0) {}
+
+SpikeCosim::~SpikeCosim() = default;
+
+bool SpikeCosim::ParseCLIArguments(int argc, char **argv, bool &exit_app) {
+  const struct option long_options[] = {
+      {"cosim", required_argument, nullptr, 'C'},
+      {"cosim-isa", required_argument, nullptr, 'I'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, no_argument, nullptr, 0}};
+
+  // Reset the command parsing index in-case other utils have already parsed
+  // some arguments
+  optind = 1;
+  while (1) {
+    int c = getopt_long(argc, argv, ":h", long_options, nullptr);
+    if (c == -1) {
+      break;
+    }
+
+    // Disable error reporting by getopt
+    opterr = 0;
+
+    switch (c) {
+      case 0:
+        break;
+      case 'C':
+        elf_file_ = optarg;
+        break;
+      case 'I':
+        isa_ = optarg;
+        break;
+      case 'h':
+        std::cout << "Co-simulation with Spike:\n\n"
+                     "--cosim=FILE\n"
+                     "  Run the ELF file FILE on Spike in lockstep with the "
+                     "design, and stop\n"
+                     "  at the first divergence. In batch runs, every test "
+                     "replaces FILE.\n\n"
+                     "--cosim-isa=ISA\n"
+                     "  ISA string of Spike (default: rv64gcv)\n\n";
+        return true;
+      case ':':  // missing argument
+        std::cerr << "ERROR: Missing argument." << std::endl << std::endl;
+        return false;
+      case '?':
+      default:;
+        // Ignore unrecognized options since they might be consumed by
+        // other utils
+    }
+  }
+
+  return true;
+}
+
+bool SpikeCosim::Reset(const std::string &image) {
+  proc_.reset();
+  if (!mem_) {
+    mem_.reset(new SpikeMemory);
+  }
+  mem_->Clear();
+  if (!mem_->LoadElf(image)) {
+    std::cerr << "ERROR: Could not load `" << image << "' into Spike."
+              << std::endl;
+    return false;
+  }
+
+  // The constructors follow the Spike version built by `make riscv-isa-sim`
+  std::string varch = "vlen:" + std::to_string(vlenb_ * 8) + ",elen:64";
+  isa_parser_.reset(new isa_parser_t(isa_.c_str(), "MSU"));
+  proc_.reset(new processor_t(isa_parser_.get(), varch.c_str(), mem_.get(),
+                              /*id=*/0, /*halt_on_reset=*/false, stderr,
+                              std::cerr));
+  proc_->reset();
+  // CVA6 boots from the DRAM, see ara_soc.sv
+  proc_->get_state()->pc = ara_soc_map::kDramBase;
+
+  const uint8_t *vrf = static_cast<const uint8_t *>(proc_->VU.reg_file);
+  vrf_shadow_.assign(vrf, vrf + 32 * vlenb_);
+  vrf_dirty_.assign(32 * vlenb_, 0);
+  vrf_pending_ = false;
+  failed_ = false;
+  vinsn_retired_ = 0;
+  vinsn_accepted_ = 0;
+  insn_retired_ = 0;
+  vrf_checks_ = 0;
+  synced_reads_ = 0;
+  return true;
+}
+
+void SpikeCosim::PreExec() {
+  if (Enabled() && !proc_ && !Reset(elf_file_)) {
+    VerilatorSimCtrl::GetInstance().RequestStop(false);
+  }
+}
+
+bool SpikeCosim::LoadTest(const std::string &image) {
+  if (!Enabled()) {
+    return true;
+  }
+  elf_file_ = image;
+  return Reset(image);
+}
+
+void SpikeCosim::OnClock(unsigned long sim_time) {
+  if (!proc_ || failed_) {
+    return;
+  }
+
+  QData ara = *sig_.ara;
+  if ((ara & kAraAccepted) && IsVectorInsn(ara & 0xffffffff)) {
+    ++vinsn_accepted_;
+  }
+
+  QData commit = *sig_.commit;
+  if (commit & kCommitException) {
+    // The instruction of the first commit port traps
+    if (!Step(*sig_.pc[0], false, false, 0, 0)) {
+      return;
+    }
+  } else {
+    for (unsigned int p = 0; p < 2; ++p) {
+      QData port = commit >> (16 * p);
+      if ((port & kCommitAck) &&
+          !Step(*sig_.pc[p], port & kCommitWeGpr, port & kCommitWeFpr,
+                (port >> 3) & 0x1f, *sig_.wdata[p])) {
+        return;
+      }
+    }
+  }
+
+  // Ara has executed all the vector instructions retired by CVA6
+  if (vrf_pending_ && (ara & kAraIdle) && vinsn_accepted_ == vinsn_retired_) {
+    CheckVrf();
+  }
+}
+
+bool SpikeCosim::Step(uint64_t pc, bool we_gpr, bool we_fpr, unsigned int rd,
+                      uint64_t wdata) {
+  state_t *state = proc_->get_state();
+  if (state->pc != pc) {
+    Fail("CVA6 retired PC " + Hex(pc) + ", Spike expected PC " +
+         Hex(state->pc) + ".");
+    return false;
+  }
+
+  uint32_t insn = mem_->ReadInsn(pc);
+  mem_->TakeMmioAccessed();
+  proc_->step(1);
+  ++insn_retired_;
+  // Spike does not model the CSRs of CVA6 (e.g., the counters) and the
+  // peripherals: take the values read by the design
+  bool sync = IsCsrInsn(insn) || mem_->TakeMmioAccessed();
+
+  if (IsVectorInsn(insn)) {
+    ++vinsn_retired_;
+    TrackVrfWrites(insn);
+  }
+
+  if (we_gpr && rd != 0 && state->XPR[rd] != wdata) {
+    if (!sync) {
+      Fail("PC " + Hex(pc) + ": x" + std::to_string(rd) + " is " + Hex(wdata) +
+           ", Spike expected " + Hex(state->XPR[rd]) + ".");
+      return false;
+    }
+    state->XPR.write(rd, wdata);
+    ++synced_reads_;
+  }
+  if (we_fpr && state->FPR[rd].v[0] != wdata) {
+    if (!sync) {
+      Fail("PC " + Hex(pc) + ": f" + std::to_string(rd) + " is " + Hex(wdata) +
+           ", Spike expected " + Hex(state->FPR[rd].v[0]) + ".");
+      return false;
+    }
+    freg_t f = state->FPR[rd];
+    f.v[0] = wdata;
+    state->FPR.write(rd, f);
+    ++synced_reads_;
+  }
+  return true;
+}
+
+void SpikeCosim::TrackVrfWrites(uint32_t insn) {
+  const uint8_t *vrf = static_cast<const uint8_t *>(proc_->VU.reg_file);
+  if (!memcmp(vrf, vrf_shadow_.data(), vrf_shadow_.size())) {
+    return;
+  }
+
+  // Only the body bits of a mask are defined, the tail is agnostic
+  bool mask = WritesMask(insn);
+  uint64_t vl = proc_->VU.vl->read();
+  for (size_t i = 0; i < vrf_shadow_.size(); ++i) {
+    if (vrf[i] == vrf_shadow_[i]) {
+      continue;
+    }
+    uint8_t care = 0xff;
+    uint64_t bit = 8 * (i % vlenb_);
+    if (mask) {
+      care = bit >= vl ? 0 : vl - bit >= 8 ? 0xff : (1u << (vl - bit)) - 1;
+    }
+    vrf_dirty_[i] |= care;
+    vrf_shadow_[i] = vrf[i];
+    vrf_pending_ = true;
+  }
+}
+
+bool SpikeCosim::ReadVrfWord(unsigned int lane, unsigned int bank,
+                             unsigned int row, uint64_t &word) {
+  std::ostringstream scope;
+  scope << "TOP.ara_tb_verilator.dut.i_ara_soc.i_system.i_ara.gen_lanes["
+        << lane << "].i_lane.i_vrf.gen_banks[" << bank << "].data_sram";
+  svBitVecVal val[16] = {};
+  try {
+    SVScoped scoped(scope.str());
+    if (!simutil_get_mem(row, val)) {
+      return false;
+    }
+  } catch (const SVScoped::Error &err) {
+    std::cerr << "ERROR: No VRF bank found at `" << err.scope_name_ << "'."
+              << std::endl;
+    return false;
+  }
+  word = val[0] | (uint64_t)val[1] << 32;
+  return true;
+}
+
+bool SpikeCosim::CheckVrf() {
+  ++vrf_checks_;
+  vrf_pending_ = false;
+
+  // VRF words read during this check, per lane and word address
+  std::map<std::pair<unsigned int, unsigned int>, uint64_t> words;
+  unsigned int words_per_reg = vlenb_ / nr_lanes_ / kVrfBanks;
+  unsigned int mismatches = 0;
+  std::ostringstream os;
+
+  for (unsigned int v = 0; v < 32; ++v) {
+    unsigned int eew_log2 = (*sig_.vrf_eew >> (2 * v)) & 0x3;
+    unsigned int eewb = 1u << eew_log2;
+    for (unsigned int i = 0; i < vlenb_; ++i) {
+      uint8_t care = vrf_dirty_[v * vlenb_ + i];
+      if (!care) {
+        continue;
+      }
+
+      // Every group of 8 * NrLanes bytes takes one word per lane. Element e
+      // of a group goes to lane e % NrLanes, in the slot of index
+      // e / NrLanes with its bits reversed, see ara_pkg::shuffle_index
+      unsigned int elem = i % (8 * nr_lanes_) / eewb;
+      unsigned int lane = elem % nr_lanes_;
+      unsigned int slot = BitReverse(elem / nr_lanes_, 3 - eew_log2);
+      unsigned int offset = eewb * slot + i % eewb;
+      unsigned int addr = v * words_per_reg + i / (8 * nr_lanes_);
+      auto it = words.find({lane, addr});
+      if (it == words.end()) {
+        uint64_t word;
+        if (!ReadVrfWord(lane, addr % kVrfBanks, addr / kVrfBanks, word)) {
+          Fail("Could not read the VRF.");
+          return false;
+        }
+        it = words.insert({{lane, addr}, word}).first;
+      }
+
+      uint8_t ara = it->second >> (8 * offset);
+      uint8_t spike = vrf_shadow_[v * vlenb_ + i];
+      if ((ara ^ spike) & care) {
+        if (mismatches < 8) {
+          os << std::endl
+             << "  v" << v << " byte " << i << " (lane " << lane << "): Ara "
+             << Hex(ara & care) << ", Spike " << Hex(spike & care);
+        }
+        ++mismatches;
+      }
+    }
+  }
+  std::fill(vrf_dirty_.begin(), vrf_dirty_.end(), 0);
+
+  if (mismatches) {
+    Fail("The VRF differs from Spike in " + std::to_string(mismatches) +
+         " bytes after " + std::to_string(vinsn_retired_) +
+         " vector instructions:" + os.str());
+    return false;
+  }
+  return true;
+}
+
+void SpikeCosim::Fail(const std::string &msg) {
+  failed_ = true;
+  std::cerr << "ERROR: [cosim] " << msg << std::endl;
+  VerilatorSimCtrl::GetInstance().RequestStop(false);
+}
+
+void SpikeCosim::PostExec() {
+  if (!proc_) {
+    return;
+  }
+  if (!failed_ && vrf_pending_) {
+    std::cerr << "WARNING: [cosim] The last vector register writes were not "
+                 "checked, Ara did not catch up with Spike."
+              << std::endl;
+  }
+  std::cout << "[cosim] " << (failed_ ? "Diverged" : "Matched") << " after "
+            << insn_retired_ << " instructions (" << vinsn_retired_
+            << " vector), " << vrf_checks_ << " VRF checks." << std::endl;
+}
+
+void SpikeCosim::GetStatistics(std::vector<SimStatistic> &stats) const {
+  if (!proc_) {
+    return;
+  }
+  stats.push_back({"Co-simulated instructions", (double)insn_retired_, ""});
+  stats.push_back({"Co-simulated vector instructions", (double)vinsn_retired_,
+                   ""});
+  stats.push_back({"VRF checks", (double)vrf_checks_, ""});
+  stats.push_back({"Values synchronized from the design",
+                   (double)synced_reads_, ""});
+}
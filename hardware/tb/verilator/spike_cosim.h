@@ -0,0 +1,120 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// Lockstep co-simulation of the Verilator test-bench with Spike.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <verilated.h>
+
+#include "sim_ctrl_extension.h"
+
+class processor_t;
+class isa_parser_t;
+class SpikeMemory;
+
+/**
+ * Check the design against Spike, instruction by instruction
+ *
+ * Spike, linked as a library, runs the same ELF file as the design. It is
+ * stepped once per instruction retired by CVA6 (and once per exception), and
+ * the PC and the scalar register written by every instruction are compared.
+ * The values read from CSRs and from the peripherals are copied from the
+ * design into Spike, since Spike does not model them.
+ *
+ * Spike executes a vector instruction as soon as CVA6 retires it, while Ara
+ * only starts it then. The bytes of the vector registers changed by Spike are
+ * hence compared against Ara's VRF once Ara has caught up, i.e. once it is idle
+ * and has received all the vector instructions retired by CVA6. The VRF is read
+ * through the DPI functions of its SRAM banks and de-shuffled with the element
+ * width of every register.
+ *
+ * The first divergence is reported and stops the simulation as a failure.
+ * The co-simulation is enabled with --cosim=FILE, FILE being the ELF file
+ * loaded into the design.
+ */
+class SpikeCosim : public SimCtrlExtension {
+ public:
+  /**
+   * Ports of ara_tb_verilator sampled by the co-simulation
+   */
+  struct Signals {
+    const QData *commit;
+    const QData *pc[2];
+    const QData *wdata[2];
+    const QData *ara;
+    const QData *vrf_eew;
+  };
+
+  SpikeCosim(const Signals &sig, unsigned int nr_lanes, unsigned int vlen);
+  ~SpikeCosim() override;
+
+  // Declared in SimCtrlExtension
+  bool ParseCLIArguments(int argc, char **argv, bool &exit_app) override;
+  void PreExec() override;
+  void OnClock(unsigned long sim_time) override;
+  unsigned long ClockPeriod() const override { return Enabled() ? 1 : 0; }
+  void PostExec() override;
+  bool LoadTest(const std::string &image) override;
+  void GetStatistics(std::vector<SimStatistic> &stats) const override;
+
+ private:
+  Signals sig_;
+  unsigned int nr_lanes_;
+  unsigned int vlenb_;
+  std::string elf_file_;
+  std::string isa_;
+  std::unique_ptr<isa_parser_t> isa_parser_;
+  std::unique_ptr<SpikeMemory> mem_;
+  std::unique_ptr<processor_t> proc_;
+  bool failed_;
+  // Spike's vector registers, and the bits changed since the last VRF check
+  std::vector<uint8_t> vrf_shadow_;
+  std::vector<uint8_t> vrf_dirty_;
+  bool vrf_pending_;
+  // Vector instructions retired by CVA6 and accepted by Ara
+  unsigned long vinsn_retired_;
+  unsigned long vinsn_accepted_;
+  unsigned long insn_retired_;
+  unsigned long vrf_checks_;
+  unsigned long synced_reads_;
+
+  bool Enabled() const { return !elf_file_.empty(); }
+
+  /**
+   * Create Spike and load |image| into its memory
+   */
+  bool Reset(const std::string &image);
+
+  /**
+   * Step Spike over one instruction retired at |pc|. The register written by
+   * the design, if any, is compared.
+   *
+   * @return Did Spike agree with the design?
+   */
+  bool Step(uint64_t pc, bool we_gpr, bool we_fpr, unsigned int rd,
+            uint64_t wdata);
+
+  /**
+   * Mark the bytes of the vector registers changed by the last instruction
+   */
+  void TrackVrfWrites(uint32_t insn);
+
+  /**
+   * Compare the changed bytes of the vector registers against Ara's VRF
+   */
+  bool CheckVrf();
+
+  /**
+   * Read word |row| of bank |bank| of the VRF of lane |lane|
+   */
+  bool ReadVrfWord(unsigned int lane, unsigned int bank, unsigned int row,
+                   uint64_t &word);
+
+  void Fail(const std::string &msg);
+};
@@ -0,0 +1,428 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// Fast-forward of the Verilator test-bench with Spike.
+
+#include "spike_fast_forward.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <getopt.h>
+#include <iostream>
+#include <iterator>
+#include <map>
+
+#include "riscv/processor.h"
+#include "riscv/simif.h"
+#include "spike_memory.h"
+#include "verilator_sim_ctrl.h"
+
+using namespace ara_soc_map;
+
+// Layout of the restore stub: the code, then the state it loads, addressed
+// from t0. The offsets fit the 12-bit immediates of the loads.
+static const unsigned int kStubCodeBytes = 1024;
+static const unsigned int kStateXpr = 0;
+static const unsigned int kStateFpr = 256;
+static const unsigned int kStateCsr = 512;
+static const unsigned int kStateVrf = 1024;
+
+// Registers used by the stub
+static const unsigned int kT0 = 5;
+static const unsigned int kT1 = 6;
+static const unsigned int kT2 = 7;
+static const unsigned int kT3 = 28;
+
+// CSRs restored by the stub, in order. mstatus goes first, since it enables
+// the floating-point and the vector units.
+static const uint16_t kCsrMstatus = 0x300;
+static const uint16_t kCsrMepc = 0x341;
+static const uint16_t kRestoredCsrs[] = {
+    kCsrMstatus,
+    0x3b0,  // pmpaddr0
+    0x3a0,  // pmpcfg0
+    0x304,  // mie
+    0x305,  // mtvec
+    0x302,  // medeleg
+    0x303,  // mideleg
+    0x105,  // stvec
+    0x306,  // mcounteren
+    0x106,  // scounteren
+    0x340,  // mscratch
+    0x003,  // fcsr
+    kCsrMepc,
+};
+static const uint16_t kCsrVstart = 0x008;
+static const uint16_t kCsrVcsr = 0x00f;
+
+// Fields of mstatus
+static const uint64_t kMstatusMie = 1ULL << 3;
+static const uint64_t kMstatusMpie = 1ULL << 7;
+static const uint64_t kMstatusMpp = 3ULL << 11;
+
+// Encoding of the instructions of the stub
+static uint32_t IType(uint32_t opcode, uint32_t funct3, unsigned int rd,
+                      unsigned int rs1, int32_t imm) {
+  return ((uint32_t)imm & 0xfff) << 20 | rs1 << 15 | funct3 << 12 | rd << 7 |
+         opcode;
+}
+static uint32_t Ld(unsigned int rd, unsigned int rs1, int32_t imm) {
+  return IType(0x03, 3, rd, rs1, imm);
+}
+static uint32_t Fld(unsigned int rd, unsigned int rs1, int32_t imm) {
+  return IType(0x07, 3, rd, rs1, imm);
+}
+static uint32_t Addi(unsigned int rd, unsigned int rs1, int32_t imm) {
+  return IType(0x13, 0, rd, rs1, imm);
+}
+static uint32_t Jalr(unsigned int rd, unsigned int rs1, int32_t imm) {
+  return IType(0x67, 0, rd, rs1, imm);
+}
+static uint32_t Csrw(uint16_t csr, unsigned int rs1) {
+  return IType(0x73, 1, 0, rs1, csr);
+}
+static uint32_t Auipc(unsigned int rd, int32_t imm20) {
+  return (uint32_t)imm20 << 12 | rd << 7 | 0x17;
+}
+static uint32_t Add(unsigned int rd, unsigned int rs1, unsigned int rs2) {
+  return rs2 << 20 | rs1 << 15 | rd << 7 | 0x33;
+}
+static uint32_t Vsetvli(unsigned int rd, unsigned int rs1, uint32_t vtypei) {
+  return (vtypei & 0x7ff) << 20 | rs1 << 15 | 7 << 12 | rd << 7 | 0x57;
+}
+static uint32_t Vsetvl(unsigned int rd, unsigned int rs1, unsigned int rs2) {
+  return 1u << 31 | rs2 << 20 | rs1 << 15 | 7 << 12 | rd << 7 | 0x57;
+}
+static uint32_t Vle8(unsigned int vd, unsigned int rs1) {
+  return 1u << 25 | rs1 << 15 | vd << 7 | 0x07;
+}
+static const uint32_t kMret = 0x30200073;
+// e8, m8, tail and mask agnostic
+static const uint32_t kVtypeE8M8 = 0xc3;
+
+// The two instructions of a jump from |from| to |to|, through t0
+static void Jump(uint64_t from, uint64_t to, uint32_t insn[2]) {
+  int64_t delta = to - from;
+  int32_t hi = (int32_t)((delta + 0x800) >> 12);
+  int32_t lo = (int32_t)(delta - ((int64_t)hi << 12));
+  insn[0] = Auipc(kT0, hi);
+  insn[1] = Jalr(0, kT0, lo);
+}
+
+SpikeFastForward::SpikeFastForward(DpiMemUtil *mem_util,
+                                   const MemAreaLoc &dram, unsigned int vlen)
+    : mem_util_(mem_util),
+      dram_(dram),
+      vlenb_(vlen / 8),
+      isa_("rv64gcv"),
+      stop_pc_(0),
+      insns_(0),
+      time_s_(0) {}
+
+SpikeFastForward::~SpikeFastForward() = default;
+
+bool SpikeFastForward::ParseCLIArguments(int argc, char **argv,
+                                         bool &exit_app) {
+  const struct option long_options[] = {
+      {"fast-forward", required_argument, nullptr, 'F'},
+      {"fast-forward-isa", required_argument, nullptr, 'I'},
+      {"fast-forward-pc", required_argument, nullptr, 'P'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, no_argument, nullptr, 0}};
+
+  // Reset the command parsing index in-case other utils have already parsed
+  // some arguments
+  optind = 1;
+  while (1) {
+    int c = getopt_long(argc, argv, ":h", long_options, nullptr);
+    if (c == -1) {
+      break;
+    }
+
+    // Disable error reporting by getopt
+    opterr = 0;
+
+    switch (c) {
+      case 0:
+        break;
+      case 'F':
+        elf_file_ = optarg;
+        break;
+      case 'I':
+        isa_ = optarg;
+        break;
+      case 'P':
+        stop_pc_ = strtoull(optarg, nullptr, 0);
+        break;
+      case 'h':
+        std::cout << "Fast-forward with Spike:\n\n"
+                     "--fast-forward=FILE\n"
+                     "  Run the ELF file FILE on Spike up to the HW_CNT_READY "
+                     "store, and start\n"
+                     "  the design from the state of Spike. In batch runs, "
+                     "every test replaces\n"
+                     "  FILE.\n\n"
+                     "--fast-forward-isa=ISA\n"
+                     "  ISA string of Spike (default: rv64gcv)\n\n"
+                     "--fast-forward-pc=ADDR\n"
+                     "  Stop at the first instruction at address ADDR "
+                     "instead\n\n";
+        return true;
+      case ':':  // missing argument
+        std::cerr << "ERROR: Missing argument." << std::endl << std::endl;
+        return false;
+      case '?':
+      default:;
+        // Ignore unrecognized options since they might be consumed by
+        // other utils
+    }
+  }
+
+  return true;
+}
+
+void SpikeFastForward::PreExec() {
+  if (Enabled() && !Run(elf_file_)) {
+    VerilatorSimCtrl::GetInstance().RequestStop(false);
+  }
+}
+
+bool SpikeFastForward::LoadTest(const std::string &image) {
+  if (!Enabled()) {
+    return true;
+  }
+  elf_file_ = image;
+  return Run(image);
+}
+
+bool SpikeFastForward::Run(const std::string &image) {
+  auto begin = std::chrono::steady_clock::now();
+  proc_.reset();
+  if (!mem_) {
+    mem_.reset(new SpikeMemory);
+    mem_->SetUartStream(&std::cout);
+  }
+  mem_->Clear();
+  if (!mem_->LoadElf(image)) {
+    std::cerr << "ERROR: Could not load `" << image << "' into Spike."
+              << std::endl;
+    return false;
+  }
+
+  // The constructors follow the Spike version built by `make riscv-isa-sim`
+  std::string varch = "vlen:" + std::to_string(vlenb_ * 8) + ",elen:64";
+  isa_parser_.reset(new isa_parser_t(isa_.c_str(), "MSU"));
+  proc_.reset(new processor_t(isa_parser_.get(), varch.c_str(), mem_.get(),
+                              /*id=*/0, /*halt_on_reset=*/false, stderr,
+                              std::cerr));
+  proc_->reset();
+  // CVA6 boots from the DRAM, see ara_soc.sv
+  state_t *state = proc_->get_state();
+  state->pc = kDramBase;
+
+  // The design resumes at the marked instruction, which executes it again. The
+  // HW_CNT_READY store does not change the registers.
+  insns_ = 0;
+  uint64_t pc;
+  while (true) {
+    pc = state->pc;
+    if (stop_pc_ && pc == stop_pc_) {
+      break;
+    }
+    proc_->step(1);
+    ++insns_;
+
+    uint64_t addr, value;
+    if (!mem_->TakeMmioStore(addr, value)) {
+      continue;
+    }
+    if (!stop_pc_ && addr == kCtrlBase + kCtrlHwCntEn && value) {
+      break;
+    }
+    if (addr == kCtrlBase + kCtrlExit) {
+      std::cerr << "ERROR: [fast-forward] `" << image << "' exited after "
+                << insns_ << " instructions, before the marked point."
+                << std::endl;
+      return false;
+    }
+  }
+
+  bool ok = Inject(pc);
+  time_s_ = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                          begin)
+                .count();
+  if (ok) {
+    std::cout << "[fast-forward] Skipped " << insns_ << " instructions in "
+              << time_s_ << " s, the design starts at PC 0x" << std::hex << pc
+              << std::dec << "." << std::endl;
+  }
+  return ok;
+}
+
+std::vector<uint8_t> SpikeFastForward::BuildStub(uint64_t resume_pc) const {
+  std::vector<uint8_t> stub(kStubCodeBytes + kStateVrf + 32 * vlenb_, 0);
+  uint8_t *state = stub.data() + kStubCodeBytes;
+  auto put = [&state](unsigned int offset, uint64_t value) {
+    memcpy(state + offset, &value, sizeof(value));
+  };
+  std::vector<uint32_t> code;
+
+  // t0 points to the state
+  code.push_back(Auipc(kT0, 0));
+  code.push_back(Addi(kT0, kT0, kStubCodeBytes));
+
+  // CSRs. mret returns to the resume PC in M-mode, with the interrupts as
+  // they were.
+  const state_t *st = proc_->get_state();
+  unsigned int slot = 0;
+  for (uint16_t csr : kRestoredCsrs) {
+    auto it = st->csrmap.find(csr);
+    if (it == st->csrmap.end()) {
+      continue;
+    }
+    uint64_t value = it->second->read();
+    if (csr == kCsrMstatus) {
+      value = (value & ~(kMstatusMie | kMstatusMpie)) | kMstatusMpp |
+              (value & kMstatusMie ? kMstatusMpie : 0);
+    } else if (csr == kCsrMepc) {
+      value = resume_pc;
+    }
+    put(kStateCsr + 8 * slot, value);
+    code.push_back(Ld(kT1, kT0, kStateCsr + 8 * slot));
+    code.push_back(Csrw(csr, kT1));
+    ++slot;
+  }
+
+  // Vector registers, in four groups of eight byte vectors
+  memcpy(state + kStateVrf, proc_->VU.reg_file, 32 * vlenb_);
+  unsigned int vl_slot = kStateCsr + 8 * slot++;
+  unsigned int vtype_slot = kStateCsr + 8 * slot++;
+  unsigned int vstart_slot = kStateCsr + 8 * slot++;
+  unsigned int vcsr_slot = kStateCsr + 8 * slot++;
+  unsigned int group_slot = kStateCsr + 8 * slot++;
+  put(vl_slot, proc_->VU.vl->read());
+  put(vtype_slot, proc_->VU.vtype->read());
+  put(vstart_slot, proc_->VU.vstart->read());
+  auto vcsr = st->csrmap.find(kCsrVcsr);
+  put(vcsr_slot, vcsr == st->csrmap.end() ? 0 : vcsr->second->read());
+  put(group_slot, 8 * vlenb_);
+
+  code.push_back(Vsetvli(kT1, 0, kVtypeE8M8));
+  code.push_back(Ld(kT2, kT0, group_slot));
+  code.push_back(Addi(kT3, kT0, kStateVrf));
+  for (unsigned int v = 0; v < 32; v += 8) {
+    code.push_back(Vle8(v, kT3));
+    code.push_back(Add(kT3, kT3, kT2));
+  }
+  code.push_back(Ld(kT1, kT0, vl_slot));
+  code.push_back(Ld(kT2, kT0, vtype_slot));
+  code.push_back(Vsetvl(0, kT1, kT2));
+  code.push_back(Ld(kT1, kT0, vstart_slot));
+  code.push_back(Csrw(kCsrVstart, kT1));
+  code.push_back(Ld(kT1, kT0, vcsr_slot));
+  code.push_back(Csrw(kCsrVcsr, kT1));
+
+  // Floating-point registers
+  for (unsigned int r = 0; r < 32; ++r) {
+    put(kStateFpr + 8 * r, st->FPR[r].v[0]);
+    code.push_back(Fld(r, kT0, kStateFpr + 8 * r));
+  }
+
+  // Scalar registers, t0 last
+  for (unsigned int r = 1; r < 32; ++r) {
+    put(kStateXpr + 8 * r, st->XPR[r]);
+    if (r != kT0) {
+      code.push_back(Ld(r, kT0, kStateXpr + 8 * r));
+    }
+  }
+  code.push_back(Ld(kT0, kT0, kStateXpr + 8 * kT0));
+  code.push_back(kMret);
+
+  assert(4 * code.size() <= kStubCodeBytes);
+  memcpy(stub.data(), code.data(), 4 * code.size());
+  return stub;
+}
+
+bool SpikeFastForward::Inject(uint64_t resume_pc) {
+  const uint64_t page_size = SpikeMemory::kPageSize;
+
+  // The design decodes the low bits of the address only, e.g. the stack at
+  // the end of the DRAM region wraps around to the end of the memory
+  std::map<uint64_t, const char *> pages;
+  for (const auto &page : mem_->pages()) {
+    uint64_t offset =
+        ((page.first << SpikeMemory::kPageBits) - kDramBase) % dram_.size;
+    if (!pages.insert({offset, page.second.get()}).second) {
+      std::cerr << "ERROR: [fast-forward] The memory used by Spike does not "
+                   "fit in the DRAM of the design."
+                << std::endl;
+      return false;
+    }
+  }
+
+  // The stub goes to the first free pages, the program can overwrite them
+  // once it has resumed
+  std::vector<uint8_t> stub = BuildStub(resume_pc);
+  uint64_t stub_pages = (stub.size() + page_size - 1) / page_size;
+  uint64_t stub_offset = 0;
+  for (const auto &page : pages) {
+    if (page.first >= stub_offset + stub_pages * page_size) {
+      break;
+    }
+    stub_offset = page.first + page_size;
+  }
+  if (stub_offset + stub_pages * page_size > dram_.size) {
+    std::cerr << "ERROR: [fast-forward] No free memory for the restore stub."
+              << std::endl;
+    return false;
+  }
+  stub.resize(stub_pages * page_size, 0);
+  for (uint64_t p = 0; p < stub_pages; ++p) {
+    pages[stub_offset + p * page_size] =
+        reinterpret_cast<const char *>(stub.data() + p * page_size);
+  }
+
+  // The boot address jumps to the stub
+  std::vector<char> boot_page(page_size, 0);
+  auto boot = pages.find(0);
+  if (boot != pages.end()) {
+    memcpy(boot_page.data(), boot->second, page_size);
+  }
+  uint32_t jump[2];
+  Jump(kDramBase, kDramBase + stub_offset, jump);
+  memcpy(boot_page.data(), jump, sizeof(jump));
+  pages[0] = boot_page.data();
+
+  // Write the runs of contiguous pages
+  try {
+    std::vector<uint8_t> run;
+    uint64_t run_offset = 0;
+    for (auto it = pages.begin(); it != pages.end(); ++it) {
+      if (run.empty()) {
+        run_offset = it->first;
+      }
+      run.insert(run.end(), it->second, it->second + page_size);
+      auto next = std::next(it);
+      if (next == pages.end() || next->first != it->first + page_size) {
+        mem_util_->WriteMemory(dram_.base + run_offset, run.data(),
+                               run.size());
+        run.clear();
+      }
+    }
+  } catch (const std::exception &err) {
+    std::cerr << "ERROR: [fast-forward] " << err.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void SpikeFastForward::GetStatistics(std::vector<SimStatistic> &stats) const {
+  if (!Enabled()) {
+    return;
+  }
+  stats.push_back({"Fast-forwarded instructions", (double)insns_, ""});
+  stats.push_back({"Fast-forward time", time_s_, "s"});
+}
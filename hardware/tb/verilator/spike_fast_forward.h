@@ -0,0 +1,89 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// Fast-forward of the Verilator test-bench with Spike.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dpi_memutil.h"
+#include "sim_ctrl_extension.h"
+
+class processor_t;
+class isa_parser_t;
+class SpikeMemory;
+
+/**
+ * Skip the setup phase of a program by running it on Spike
+ *
+ * Spike, linked as a library, runs the ELF file loaded into the design up to
+ * a marked point: by default the HW_CNT_READY store of runtime.h, i.e. the
+ * first non-zero store to the hw_cnt_en register, which is not executed.
+ * The architectural state of Spike is then injected into the design before
+ * it leaves the reset:
+ * - the memory written by Spike goes to the DRAM through DpiMemUtil,
+ * - the scalar, floating-point, vector registers and the CSRs are restored by
+ *   a stub written into free DRAM pages. The first instruction of the program
+ *   jumps to the stub, which loads the registers from the state that follows
+ *   it and returns to the marked point with mret.
+ *
+ * The vector registers are loaded with byte elements, so that Ara shuffles
+ * them like any other vector load. The detailed simulation starts a few
+ * hundred cycles after the reset, at the marked point.
+ *
+ * The fast-forward is enabled with --fast-forward=FILE, FILE being the ELF
+ * file loaded into the design.
+ */
+class SpikeFastForward : public SimCtrlExtension {
+ public:
+  SpikeFastForward(DpiMemUtil *mem_util, const MemAreaLoc &dram,
+                   unsigned int vlen);
+  ~SpikeFastForward() override;
+
+  // Declared in SimCtrlExtension
+  bool ParseCLIArguments(int argc, char **argv, bool &exit_app) override;
+  void PreExec() override;
+  bool LoadTest(const std::string &image) override;
+  unsigned long ClockPeriod() const override { return 0; }
+  void GetStatistics(std::vector<SimStatistic> &stats) const override;
+
+ private:
+  DpiMemUtil *mem_util_;
+  MemAreaLoc dram_;
+  unsigned int vlenb_;
+  std::string elf_file_;
+  std::string isa_;
+  // Stop at this PC instead of the HW_CNT_READY store (0: disabled)
+  uint64_t stop_pc_;
+  std::unique_ptr<isa_parser_t> isa_parser_;
+  std::unique_ptr<SpikeMemory> mem_;
+  std::unique_ptr<processor_t> proc_;
+  unsigned long insns_;
+  double time_s_;
+
+  bool Enabled() const { return !elf_file_.empty(); }
+
+  /**
+   * Run |image| on Spike up to the marked point
+   *
+   * @return Was the marked point reached?
+   */
+  bool Run(const std::string &image);
+
+  /**
+   * Write the memory of Spike, the restore stub and the state into the DRAM
+   */
+  bool Inject(uint64_t resume_pc);
+
+  /**
+   * Assemble the restore stub, which returns to |resume_pc|, followed by the
+   * architectural state of Spike. The stub is position-independent.
+   */
+  std::vector<uint8_t> BuildStub(uint64_t resume_pc) const;
+};
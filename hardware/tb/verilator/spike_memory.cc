@@ -0,0 +1,165 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// Memory of ara_soc as seen by Spike, shared by the co-simulation and the
+// fast-forward of the Verilator test-bench.
+
+#include "spike_memory.h"
+
+#include <algorithm>
+#include <cstring>
+#include <elf.h>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace ara_soc_map;
+
+template <typename Ehdr, typename Phdr>
+static bool LoadSegments(const std::vector<uint8_t> &elf, SpikeMemory &mem) {
+  const Ehdr *eh = reinterpret_cast<const Ehdr *>(elf.data());
+  if (eh->e_phoff + (uint64_t)eh->e_phnum * sizeof(Phdr) > elf.size()) {
+    return false;
+  }
+  const Phdr *ph = reinterpret_cast<const Phdr *>(elf.data() + eh->e_phoff);
+  for (unsigned int i = 0; i < eh->e_phnum; ++i) {
+    if (ph[i].p_type != PT_LOAD || ph[i].p_memsz == 0) {
+      continue;
+    }
+    if (ph[i].p_offset + ph[i].p_filesz > elf.size() ||
+        !mem.Write(ph[i].p_paddr, elf.data() + ph[i].p_offset,
+                   ph[i].p_filesz) ||
+        !mem.Write(ph[i].p_paddr + ph[i].p_filesz, nullptr,
+                   ph[i].p_memsz - ph[i].p_filesz)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+SpikeMemory::SpikeMemory() : uart_(nullptr) { Clear(); }
+
+char *SpikeMemory::addr_to_mem(reg_t addr) {
+  if (addr < kDramBase || addr - kDramBase >= kDramLength) {
+    return nullptr;
+  }
+  std::unique_ptr<char[]> &page = pages_[addr >> kPageBits];
+  if (!page) {
+    page.reset(new char[kPageSize]());
+  }
+  return page.get() + (addr & (kPageSize - 1));
+}
+
+bool SpikeMemory::mmio_load(reg_t addr, size_t len, uint8_t *bytes) {
+  if (!IsPeriph(addr, len)) {
+    return false;
+  }
+  memset(bytes, 0, len);
+  uint64_t reg = (addr - kCtrlBase) / 8;
+  if (addr >= kCtrlBase && reg < kCtrlRegs) {
+    uint64_t value = ctrl_regs_[reg] >> (8 * (addr % 8));
+    memcpy(bytes, &value, std::min<size_t>(len, 8 - addr % 8));
+  }
+  mmio_accessed_ = true;
+  return true;
+}
+
+bool SpikeMemory::mmio_store(reg_t addr, size_t len, const uint8_t *bytes) {
+  mmio_accessed_ = IsPeriph(addr, len);
+  if (!mmio_accessed_) {
+    return false;
+  }
+
+  uint64_t value = 0;
+  memcpy(&value, bytes, std::min<size_t>(len, 8));
+  mmio_stored_ = true;
+  store_addr_ = addr;
+  store_value_ = value;
+
+  uint64_t reg = (addr - kCtrlBase) / 8;
+  if (addr >= kCtrlBase && reg < kCtrlRegs && addr % 8 == 0 &&
+      addr - kCtrlBase != kCtrlDramBase && addr - kCtrlBase != kCtrlDramEnd) {
+    ctrl_regs_[reg] = value;
+  }
+  if (addr == kUartBase && uart_) {
+    uart_->put((char)value);
+  }
+  if (addr >= kConsoleBase && addr + len <= kConsoleBase + kConsoleLength &&
+      uart_) {
+    uart_->write(reinterpret_cast<const char *>(bytes), len);
+  }
+  return true;
+}
+
+void SpikeMemory::Clear() {
+  pages_.clear();
+  memset(ctrl_regs_, 0, sizeof(ctrl_regs_));
+  ctrl_regs_[kCtrlDramBase / 8] = kDramBase;
+  ctrl_regs_[kCtrlDramEnd / 8] = kDramBase + kDramLength;
+  mmio_accessed_ = false;
+  mmio_stored_ = false;
+  store_addr_ = 0;
+  store_value_ = 0;
+}
+
+bool SpikeMemory::Write(uint64_t addr, const uint8_t *data, uint64_t size) {
+  for (uint64_t i = 0; i < size; ++i) {
+    char *byte = addr_to_mem(addr + i);
+    if (!byte) {
+      return false;
+    }
+    *byte = data ? data[i] : 0;
+  }
+  return true;
+}
+
+bool SpikeMemory::LoadElf(const std::string &file) {
+  std::ifstream is(file, std::ios::binary);
+  std::vector<uint8_t> elf((std::istreambuf_iterator<char>(is)),
+                           std::istreambuf_iterator<char>());
+  if (elf.size() < sizeof(Elf64_Ehdr) ||
+      memcmp(elf.data(), ELFMAG, SELFMAG) != 0) {
+    return false;
+  }
+  if (elf[EI_CLASS] == ELFCLASS64) {
+    return LoadSegments<Elf64_Ehdr, Elf64_Phdr>(elf, *this);
+  }
+  return elf[EI_CLASS] == ELFCLASS32 &&
+         LoadSegments<Elf32_Ehdr, Elf32_Phdr>(elf, *this);
+}
+
+uint32_t SpikeMemory::ReadInsn(uint64_t addr) {
+  uint32_t insn = 0;
+  for (unsigned int i = 0; i < sizeof(insn); ++i) {
+    char *byte = addr_to_mem(addr + i);
+    insn |= byte ? (uint32_t)(uint8_t)*byte << (8 * i) : 0;
+  }
+  return insn;
+}
+
+bool SpikeMemory::TakeMmioAccessed() {
+  bool accessed = mmio_accessed_;
+  mmio_accessed_ = false;
+  return accessed;
+}
+
+bool SpikeMemory::TakeMmioStore(uint64_t &addr, uint64_t &value) {
+  if (!mmio_stored_) {
+    return false;
+  }
+  mmio_stored_ = false;
+  addr = store_addr_;
+  value = store_value_;
+  return true;
+}
+
+bool SpikeMemory::IsPeriph(reg_t addr, size_t len) {
+  for (uint64_t base : {kUartBase, kCtrlBase}) {
+    if (addr >= base && addr + len <= base + kPeriphLength) {
+      return true;
+    }
+  }
+  return false;
+}
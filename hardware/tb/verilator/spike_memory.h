@@ -0,0 +1,112 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// Memory of ara_soc as seen by Spike, shared by the co-simulation and the
+// fast-forward of the Verilator test-bench.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "riscv/simif.h"
+
+/**
+ * Memory map of ara_soc, see src/ara_soc.sv and src/ctrl_registers.sv
+ */
+namespace ara_soc_map {
+const uint64_t kDramBase = 0x80000000;
+const uint64_t kDramLength = 0x40000000;
+const uint64_t kUartBase = 0xC0000000;
+// Console window in the UART region, see tb/ara_console.sv
+const uint64_t kConsoleBase = 0xC0000800;
+const uint64_t kConsoleLength = 0x800;
+const uint64_t kCtrlBase = 0xD0000000;
+const uint64_t kPeriphLength = 0x1000;
+// Registers of ctrl_registers, from kCtrlBase
+const uint64_t kCtrlExit = 0x00;
+const uint64_t kCtrlDramBase = 0x08;
+const uint64_t kCtrlDramEnd = 0x10;
+const uint64_t kCtrlEventTrigger = 0x18;
+const uint64_t kCtrlHwCntEn = 0x20;
+}  // namespace ara_soc_map
+
+/**
+ * Memory of Spike: the DRAM, allocated page by page, and the peripherals
+ *
+ * The control registers read back their reset value or the last value
+ * written, the UART reads as zero and can print the characters written to it
+ * or to the console window.
+ */
+class SpikeMemory : public simif_t {
+ public:
+  static const unsigned int kPageBits = 12;
+  static const uint64_t kPageSize = 1ULL << kPageBits;
+
+  typedef std::map<uint64_t, std::unique_ptr<char[]>> PageMap;
+
+  SpikeMemory();
+
+  // Declared in simif_t
+  char *addr_to_mem(reg_t addr) override;
+  bool mmio_load(reg_t addr, size_t len, uint8_t *bytes) override;
+  bool mmio_store(reg_t addr, size_t len, const uint8_t *bytes) override;
+  void proc_reset(unsigned id) override {}
+  const char *get_symbol(uint64_t addr) override { return nullptr; }
+
+  /**
+   * Free the DRAM and reset the control registers
+   */
+  void Clear();
+
+  /**
+   * Write |size| bytes of |data| (zeros if null) at |addr| of the DRAM
+   */
+  bool Write(uint64_t addr, const uint8_t *data, uint64_t size);
+
+  /**
+   * Load the segments of the ELF file |file| into the DRAM
+   */
+  bool LoadElf(const std::string &file);
+
+  uint32_t ReadInsn(uint64_t addr);
+
+  /**
+   * Was a peripheral accessed since the last call?
+   */
+  bool TakeMmioAccessed();
+
+  /**
+   * Get the last store to a peripheral since the last call, if any
+   */
+  bool TakeMmioStore(uint64_t &addr, uint64_t &value);
+
+  /**
+   * Print the characters written to the UART and to the console window to
+   * |os| (nothing if null)
+   */
+  void SetUartStream(std::ostream *os) { uart_ = os; }
+
+  /**
+   * Allocated pages of the DRAM, indexed by address >> kPageBits
+   */
+  const PageMap &pages() const { return pages_; }
+
+ private:
+  static const unsigned int kCtrlRegs = 5;
+
+  PageMap pages_;
+  uint64_t ctrl_regs_[kCtrlRegs];
+  std::ostream *uart_;
+  bool mmio_accessed_;
+  bool mmio_stored_;
+  uint64_t store_addr_;
+  uint64_t store_value_;
+
+  static bool IsPeriph(reg_t addr, size_t len);
+};
@@ -0,0 +1,265 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// Forward-progress watchdog of the Verilator test-bench.
+
+#include "watchdog.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+
+#include "verilator_sim_ctrl.h"
+
+// Fields of the co-simulation ports, see ara_tb_verilator.sv
+static const QData kCommitAck = (1ULL << 0) | (1ULL << 16);
+static const QData kCommitException = 1ULL << 32;
+static const QData kAraAccepted = 1ULL << 32;
+
+// Handshakes of an AXI probe (AR, R, AW, W, B), see ara_tb_verilator.sv
+static const QData kProbeHandshakes =
+    (1ULL << 0) | (1ULL << 1) | (1ULL << 3) | (1ULL << 4) | (1ULL << 6);
+
+// Fields of the watchdog ports, see ara_tb_verilator.sv
+static const QData kStateRunning = 0xff;
+static const QData kStateIdle = 1ULL << 8;
+static const QData kStateReqValid = 1ULL << 9;
+static const QData kStateReqReady = 1ULL << 10;
+static const QData kStateInsnStalled = 1ULL << 11;
+static const QData kStateLanesDesynch = 1ULL << 12;
+static const QData kStateHazards = 1ULL << 13;
+static const unsigned int kStatePeRunning = 16;
+static const unsigned int kLaneBits = 4;
+
+// Processing elements of the sequencer after the lanes, see
+// ara_pkg::vfu_offset_e
+static const char *const kUnitNames[] = {"load", "store", "mask", "slide",
+                                         "tmac"};
+
+Watchdog::Watchdog(const Signals &signals, unsigned int nr_lanes)
+    : sig_(signals),
+      nr_lanes_(nr_lanes),
+      stall_cycles_(0),
+      trace_cycles_(0),
+      history_size_(16),
+      armed_(false),
+      system_progress_(0),
+      ara_progress_(0),
+      ara_running_(0),
+      last_pc_(0),
+      last_pc_cycle_(0),
+      longest_stall_(0),
+      fired_(false),
+      stop_cycle_(0) {}
+
+bool Watchdog::ParseCLIArguments(int argc, char **argv, bool &exit_app) {
+  const struct option long_options[] = {
+      {"watchdog", required_argument, nullptr, 'D'},
+      {"watchdog-history", required_argument, nullptr, 'H'},
+      {"watchdog-trace", required_argument, nullptr, 'T'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, no_argument, nullptr, 0}};
+
+  // Reset the command parsing index in-case other utils have already parsed
+  // some arguments
+  optind = 1;
+  while (1) {
+    int c = getopt_long(argc, argv, ":h", long_options, nullptr);
+    if (c == -1) {
+      break;
+    }
+
+    // Disable error reporting by getopt
+    opterr = 0;
+
+    switch (c) {
+      case 0:
+        break;
+      case 'D':
+        stall_cycles_ = strtoul(optarg, nullptr, 0);
+        break;
+      case 'H':
+        history_size_ = strtoul(optarg, nullptr, 0);
+        break;
+      case 'T':
+        trace_cycles_ = strtoul(optarg, nullptr, 0);
+        break;
+      case 'h':
+        std::cout << "Watchdog:\n\n"
+                     "--watchdog=N\n"
+                     "  Stop the simulation as a failure after N cycles "
+                     "without forward progress\n"
+                     "  (default: 0, disabled)\n\n"
+                     "--watchdog-history=K\n"
+                     "  Print the last K instructions dispatched to Ara when "
+                     "the watchdog fires\n"
+                     "  (default: 16)\n\n"
+                     "--watchdog-trace=M\n"
+                     "  Trace M more cycles before stopping, if the model is "
+                     "built with tracing\n\n";
+        return true;
+      case ':':  // missing argument
+        std::cerr << "ERROR: Missing argument." << std::endl << std::endl;
+        return false;
+      case '?':
+      default:;
+        // Ignore unrecognized options since they might be consumed by
+        // other utils
+    }
+  }
+
+  return true;
+}
+
+void Watchdog::OnClock(unsigned long sim_time) {
+  if (!Enabled()) {
+    return;
+  }
+
+  unsigned long cycle = sim_time / 2;
+  if (!armed_) {
+    system_progress_ = ara_progress_ = cycle;
+    armed_ = true;
+  }
+
+  if (fired_) {
+    if (cycle >= stop_cycle_) {
+      VerilatorSimCtrl::GetInstance().RequestStop(false);
+    }
+    return;
+  }
+
+  QData commit = *sig_.sig_commit;
+  QData ara = *sig_.sig_ara;
+  QData state = *sig_.sig_state;
+
+  if (commit & kCommitAck) {
+    last_pc_ = *sig_.sig_pc;
+    last_pc_cycle_ = cycle;
+  }
+  if (ara & kAraAccepted) {
+    history_.push_back(Dispatch{cycle, (uint32_t)ara});
+    while (history_.size() > history_size_) {
+      history_.pop_front();
+    }
+  }
+
+  if ((commit & (kCommitAck | kCommitException)) || (ara & kAraAccepted) ||
+      (*sig_.sig_axi_system & kProbeHandshakes)) {
+    system_progress_ = cycle;
+  }
+  if ((state & kStateIdle) || (state & kStateRunning) != ara_running_ ||
+      (*sig_.sig_axi_vlsu & kProbeHandshakes)) {
+    ara_progress_ = cycle;
+  }
+  ara_running_ = state & kStateRunning;
+
+  unsigned long stall = cycle - std::min(system_progress_, ara_progress_);
+  longest_stall_ = std::max(longest_stall_, stall);
+  if (cycle - system_progress_ >= stall_cycles_) {
+    Fire(cycle,
+         "No instruction retired or dispatched to Ara, and no AXI handshake");
+  } else if (cycle - ara_progress_ >= stall_cycles_) {
+    Fire(cycle, "Ara is busy, but no instruction completed, and no VLSU "
+                "handshake");
+  }
+}
+
+void Watchdog::Fire(unsigned long cycle, const std::string &reason) {
+  fired_ = true;
+  std::cerr << "ERROR: [watchdog] " << reason << " for " << stall_cycles_
+            << " cycles (cycle " << cycle << ")." << std::endl;
+  Dump(cycle);
+
+  VerilatorSimCtrl &simctrl = VerilatorSimCtrl::GetInstance();
+  if (trace_cycles_ && simctrl.TraceOn()) {
+    std::cout << "[watchdog] Tracing " << trace_cycles_
+              << " cycles before stopping." << std::endl;
+    stop_cycle_ = cycle + trace_cycles_;
+    return;
+  }
+  if (trace_cycles_) {
+    std::cout << "[watchdog] The model is built without tracing, stopping now."
+              << std::endl;
+  }
+  simctrl.RequestStop(false);
+}
+
+void Watchdog::Dump(unsigned long cycle) const {
+  QData state = *sig_.sig_state;
+  QData lanes = *sig_.sig_lanes;
+
+  std::cout << std::hex << std::setfill('0') << "[watchdog] Last retired PC: 0x"
+            << std::setw(16) << last_pc_ << std::dec << std::setfill(' ')
+            << " (cycle " << last_pc_cycle_ << ")" << std::endl
+            << "[watchdog] Sequencer: "
+            << (state & kStateIdle ? "idle" : "busy")
+            << ", running instructions 0x" << std::hex << std::setfill('0')
+            << std::setw(2) << (state & kStateRunning) << std::dec
+            << std::setfill(' ') << ", request valid "
+            << !!(state & kStateReqValid) << " ready "
+            << !!(state & kStateReqReady) << std::endl
+            << "[watchdog] Sequencer stalls:"
+            << (state & kStateInsnStalled ? " accepted-instruction" : "")
+            << (state & kStateLanesDesynch ? " lanes-desynchronized" : "")
+            << (state & kStateHazards ? " hazards" : "")
+            << (state & (kStateInsnStalled | kStateLanesDesynch | kStateHazards)
+                    ? ""
+                    : " none")
+            << std::endl
+            << "[watchdog] Units with running instructions:";
+  bool running = false;
+  for (unsigned int pe = 0; pe < nr_lanes_ + 5; ++pe) {
+    if (!(state >> (kStatePeRunning + pe) & 1)) {
+      continue;
+    }
+    running = true;
+    if (pe < nr_lanes_) {
+      std::cout << " lane" << pe;
+    } else {
+      std::cout << " " << kUnitNames[pe - nr_lanes_];
+    }
+  }
+  std::cout << (running ? "" : " none") << std::endl;
+
+  for (unsigned int l = 0; l < nr_lanes_; ++l) {
+    QData lane = lanes >> (kLaneBits * l);
+    std::cout << "[watchdog] Lane " << l << ": request valid " << (lane & 1)
+              << " ready " << (lane >> 1 & 1) << ", operand requesters "
+              << (lane & 4 ? "busy" : "idle") << ", "
+              << (lane & 8 ? "running" : "no running instruction")
+              << std::endl;
+  }
+
+  std::cout << "[watchdog] Last " << history_.size()
+            << " instructions dispatched to Ara:" << std::endl;
+  for (const Dispatch &d : history_) {
+    std::cout << "[watchdog]   cycle " << std::setw(10) << d.cycle << " ("
+              << std::setw(8) << cycle - d.cycle << " ago): 0x" << std::hex
+              << std::setfill('0') << std::setw(8) << d.insn << std::dec
+              << std::setfill(' ') << std::endl;
+  }
+}
+
+bool Watchdog::LoadTest(const std::string &image) {
+  // Every test of a batch starts with a fresh watchdog
+  armed_ = false;
+  fired_ = false;
+  ara_running_ = 0;
+  last_pc_ = 0;
+  last_pc_cycle_ = 0;
+  longest_stall_ = 0;
+  history_.clear();
+  return true;
+}
+
+void Watchdog::GetStatistics(std::vector<SimStatistic> &stats) const {
+  if (!Enabled()) {
+    return;
+  }
+  stats.push_back({"Watchdog longest stall", (double)longest_stall_, "cycles"});
+}
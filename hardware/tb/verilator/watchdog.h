@@ -0,0 +1,98 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+//
+// Description:
+// Forward-progress watchdog of the Verilator test-bench.
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include <verilated.h>
+
+#include "sim_ctrl_extension.h"
+
+/**
+ * Stop a simulation that does not make forward progress anymore
+ *
+ * The system makes progress when CVA6 retires an instruction, when Ara
+ * accepts one, or on any AXI handshake of the crossbar input. Ara makes
+ * progress when it is idle, when its set of running instructions changes, or
+ * on any AXI handshake of its VLSU port. When either does not make progress
+ * for --watchdog=N cycles, the watchdog prints the state of the sequencer and
+ * of the lanes and the last instructions dispatched to Ara, and stops the
+ * simulation as a failure. With --watchdog-trace=M, the stop is delayed by M
+ * cycles, which are traced.
+ */
+class Watchdog : public SimCtrlExtension {
+ public:
+  /**
+   * Ports of ara_tb_verilator sampled by the watchdog
+   */
+  struct Signals {
+    // cosim_commit_o, cosim_pc0_o and cosim_ara_o
+    const QData *sig_commit;
+    const QData *sig_pc;
+    const QData *sig_ara;
+    // axi_probe_system_o and axi_probe_vlsu_o
+    const QData *sig_axi_system;
+    const QData *sig_axi_vlsu;
+    // watchdog_ara_o and watchdog_lanes_o
+    const QData *sig_state;
+    const QData *sig_lanes;
+  };
+
+  Watchdog(const Signals &signals, unsigned int nr_lanes);
+
+  // Declared in SimCtrlExtension
+  bool ParseCLIArguments(int argc, char **argv, bool &exit_app) override;
+  void OnClock(unsigned long sim_time) override;
+  unsigned long ClockPeriod() const override { return Enabled() ? 1 : 0; }
+  bool LoadTest(const std::string &image) override;
+  void GetStatistics(std::vector<SimStatistic> &stats) const override;
+
+ private:
+  struct Dispatch {
+    unsigned long cycle;
+    uint32_t insn;
+  };
+
+  Signals sig_;
+  unsigned int nr_lanes_;
+  // Options
+  unsigned long stall_cycles_;
+  unsigned long trace_cycles_;
+  size_t history_size_;
+  // Last cycle with progress of the system and of Ara, valid once armed
+  bool armed_;
+  unsigned long system_progress_;
+  unsigned long ara_progress_;
+  QData ara_running_;
+  uint64_t last_pc_;
+  unsigned long last_pc_cycle_;
+  unsigned long longest_stall_;
+  // Last instructions accepted by Ara, oldest first
+  std::deque<Dispatch> history_;
+  // Cycle to stop at, once the watchdog has fired
+  bool fired_;
+  unsigned long stop_cycle_;
+
+  /**
+   * Is the watchdog enabled (--watchdog)?
+   */
+  bool Enabled() const { return stall_cycles_ != 0; }
+
+  /**
+   * Report the stall and stop the simulation, or start the trace window
+   */
+  void Fire(unsigned long cycle, const std::string &reason);
+
+  /**
+   * Print the state of the sequencer, of the lanes, and the last dispatched
+   * instructions
+   */
+  void Dump(unsigned long cycle) const;
+};
@@ -137,36 +137,14 @@ verify_id_results() {
   threshold=$1
   sew=$2
 
-  id_results=hardware/id_results.txt
-  gold_results=hardware/gold_results.txt
+  id_results=hardware/id_results.bin
+  gold_results=hardware/gold_results.bin
 
-  echo "Summary of the first 10 lines for ID results:"
-  head -n 10 ${id_results}
-  echo "Summary of the first 10 lines for default-system results:"
-  head -n 10 ${gold_results}
   echo "Verifying ideal_dispatcher results:"
-  if [ $threshold -gt 0 ]; then
-    i=0
-    while IFS= read -r l0 && IFS= read -r l1 <&3; do
-      # Find the last byte of a floating-point word
-      i=$(($i + 1))
-      if [ $(($i % ($sew / 8))) -eq 0 ]; then
-        # abs(x-y)
-        diff=$((16#${l0} - 16#${l1}))
-        diff=${diff#-}
-        # More than threshold?
-        if [[ $diff -gt $threshold ]]; then
-          echo "Error. Test failed."
-          return -1
-        fi
-      fi
-    done < ${id_results} 3< ${gold_results}
-  else
-    diff ${id_results} ${gold_results}
-    if [ $? -ne 0 ]; then
-      echo "Error. Test failed."
-    fi
-    return $?
+  python3 scripts/compare_results.py --threshold ${threshold} --sew $((${sew:-64} / 8)) ${gold_results} ${id_results}
+  if [ $? -ne 0 ]; then
+    echo "Error. Test failed."
+    return -1
   fi
 }
 
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+# Copyright 2021 ETH Zurich and University of Bologna.
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# Compare the values stored by Ara in two simulations, e.g. with the default
+# system and with the ideal dispatcher. The captures are written by
+# hardware/tb/dpi/result_sink.cc. The memory contents left by the two
+# simulations are compared, so the order of the stores does not matter.
+
+import argparse
+import struct
+import sys
+
+MAGIC = b'ARARES01'
+
+parser = argparse.ArgumentParser(description=
+'''
+Compare two captures of the values stored by Ara.
+''')
+
+parser.add_argument('gold', help='Capture of the reference simulation')
+parser.add_argument('test', help='Capture of the simulation to check')
+parser.add_argument('-t', '--threshold', type=int, default=0,
+                    help=
+'''
+Only compare the most significant byte of every element, and accept an absolute
+difference up to THRESHOLD (e.g. for unordered floating-point reductions).
+''')
+parser.add_argument('-s', '--sew', type=int, default=8,
+                    help='Element width [bytes] used with --threshold (default: 8)')
+parser.add_argument('-n', '--max-errors', type=int, default=10,
+                    help='Number of mismatches to print (default: 10)')
+
+args = parser.parse_args()
+
+# Read a capture and return the final value of every stored byte
+def read_capture(fpath):
+  with open(fpath, 'rb') as fid:
+    data = fid.read()
+  if data[:8] != MAGIC:
+    sys.exit('Error: %s is not a result capture.' % fpath)
+  beat_bytes, = struct.unpack_from('<I', data, 8)
+
+  mem = dict()
+  pos = 12
+  while pos < len(data):
+    addr, strb = struct.unpack_from('<QQ', data, pos)
+    pos += 16
+    for b in range(beat_bytes):
+      if strb & (1 << b):
+        mem[addr + b] = data[pos]
+        pos += 1
+  return mem
+
+def main():
+  gold = read_capture(args.gold)
+  test = read_capture(args.test)
+
+  errors = list()
+  for addr in sorted(set(gold) | set(test)):
+    g = gold.get(addr)
+    t = test.get(addr)
+    if args.threshold > 0:
+      # Most significant byte of an element
+      if (addr + 1) % args.sew != 0 or g is None or t is None:
+        if g is None or t is None:
+          errors.append((addr, g, t))
+        continue
+      if abs(g - t) > args.threshold:
+        errors.append((addr, g, t))
+    elif g != t:
+      errors.append((addr, g, t))
+
+  fmt = lambda v: '--' if v is None else '%02x' % v
+  for addr, g, t in errors[:args.max_errors]:
+    print('0x%016x: %s != %s' % (addr, fmt(g), fmt(t)))
+
+  print('Compared %d bytes, %d mismatches.' % (len(set(gold) | set(test)), len(errors)))
+  sys.exit(1 if errors else 0)
+
+if __name__ == '__main__':
+  main()
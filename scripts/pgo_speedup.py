@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+# Copyright 2021 ETH Zurich and University of Bologna.
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# Compare the simulation speed of two Verilator models, e.g. the plain and the
+# profile-guided optimized ones built by `make verilate-pgo`. The speed is the
+# one printed by the models at the end of every simulation, read from
+# <dir>/<app>.log.
+
+import argparse
+import math
+import re
+import sys
+
+SPEED = re.compile(r'Simulation speed: ([0-9.eE+-]+) cycles/s')
+
+parser = argparse.ArgumentParser(description=
+'''
+Compare the simulation speed of two Verilator models.
+''')
+
+parser.add_argument('base', help='Logs of the reference model')
+parser.add_argument('test', help='Logs of the model to compare')
+parser.add_argument('apps', nargs='+', help='Simulated applications')
+
+args = parser.parse_args()
+
+def speed(path):
+  try:
+    with open(path) as f:
+      for line in f:
+        m = SPEED.search(line)
+        if m:
+          return float(m.group(1))
+  except OSError:
+    pass
+  return None
+
+speedups = []
+print('{:<16} {:>12} {:>12} {:>8}'.format('app', 'base [kHz]', 'test [kHz]',
+                                          'speedup'))
+for app in args.apps:
+  base = speed('{}/{}.log'.format(args.base, app))
+  test = speed('{}/{}.log'.format(args.test, app))
+  if not base or not test:
+    print('{:<16} no simulation speed in the logs'.format(app))
+    continue
+  speedups.append(test / base)
+  print('{:<16} {:>12.2f} {:>12.2f} {:>7.3f}x'.format(app, base / 1e3,
+                                                     test / 1e3, test / base))
+
+if not speedups:
+  sys.exit(1)
+geomean = math.exp(sum(math.log(s) for s in speedups) / len(speedups))
+print('{:<16} {:>12} {:>12} {:>7.3f}x'.format('geomean', '', '', geomean))
@@ -32,6 +32,13 @@ parser.add_argument('-s', '--show', action='store',
 Show the plot.
 ''')
 
+parser.add_argument('-a', '--axi', action='store_true',
+                    help=
+'''
+The input file is an AXI bandwidth time series of the Verilator AXI monitor
+(--axi-timeseries). Plot the bandwidth of every port over time.
+''')
+
 args = parser.parse_args()
 
 # Roofline plot
@@ -54,6 +61,23 @@ def heatmap(db):
     plt.savefig(args.outfile)
 
 
+# Line plot of the AXI bandwidth over time
+# One line per port and direction
+def axi_bandwidth(fpath):
+  titlefont = {'fontname' : 'Garamond'};
+  axisfont  = {'fontname' : 'Garamond'};
+  # [token]: port cycle read_bw write_bw
+  db = pd.read_csv(fpath, sep=' ', names=['port', 'cycle', 'read', 'write'])
+  db = db.melt(id_vars=['port', 'cycle'], var_name='dir', value_name='bw')
+  sns.lineplot(data=db, x='cycle', y='bw', hue='port', style='dir', drawstyle='steps-post')
+  plt.title('AXI bandwidth', **titlefont)
+  plt.xlabel('Cycle', **axisfont)
+  plt.ylabel('Bandwidth [Byte/cycle]', **axisfont)
+  if args.show:
+    plt.show()
+  if args.outfile:
+    plt.savefig(args.outfile)
+
 # Append a new entry to the main database
 def append_entry(lst, template):
   lst.append(copy.deepcopy(template))
@@ -94,6 +118,10 @@ def create_db(db, r_label, c_label):
   pd.DataFrame([[{l : [d['cycles']/d['max_cycles'] for d in db if (d['kernel'], d['size']) == (r, l)]} for l in c_label] for r in r_label])
 
 def main():
+  if args.axi:
+    axi_bandwidth(args.infile)
+    return
+
   # Main database (DB)
   db = list()
 